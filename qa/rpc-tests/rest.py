@@ -324,6 +324,62 @@ class RESTTest (BitcoinTestFramework):
         for tx in txs:
             assert_equal(tx in json_obj['tx'], True)
 
+        #check that every input carries the output it spends
+        json_string = http_get_call(url.hostname, url.port, '/rest/block/withprevouts/'+newblockhash[0]+self.FORMAT_SEPARATOR+'json')
+        json_obj = json.loads(json_string, parse_float=Decimal)
+        assert_equal(json_obj['hash'], newblockhash[0])
+        assert_equal('prevout' in json_obj['tx'][0]['vin'][0], False) #coinbase
+        for tx in json_obj['tx'][1:]:
+            for vin in tx['vin']:
+                prevtx = self.nodes[0].decoderawtransaction(self.nodes[0].gettransaction(vin['txid'])['hex'])
+                assert_equal(vin['prevout']['value'], prevtx['vout'][vin['vout']]['value'])
+                assert_equal(vin['prevout']['scriptPubKey']['hex'], prevtx['vout'][vin['vout']]['scriptPubKey']['hex'])
+
+        #the binary format is the block followed by the spent outputs
+        response = http_get_call(url.hostname, url.port, '/rest/block/'+newblockhash[0]+self.FORMAT_SEPARATOR+"bin", True)
+        assert_equal(response.status, 200)
+        block_bin = response.read()
+        response = http_get_call(url.hostname, url.port, '/rest/block/withprevouts/'+newblockhash[0]+self.FORMAT_SEPARATOR+"bin", True)
+        assert_equal(response.status, 200)
+        prevouts_bin = response.read()
+        assert_greater_than(len(prevouts_bin), len(block_bin))
+        assert_equal(prevouts_bin[:len(block_bin)], block_bin)
+
+        #########################################
+        # /rest/blocks/ and the getblocks RPC  #
+        #########################################
+
+        tip_height = self.nodes[0].getblockcount()
+        start = tip_height - 4
+        hashes = [self.nodes[0].getblockhash(h) for h in range(start, tip_height + 1)]
+
+        # ask for more blocks than there are, the range stops at the tip
+        json_string = http_get_call(url.hostname, url.port, '/rest/blocks/'+str(start)+'/10'+self.FORMAT_SEPARATOR+'json')
+        json_obj = json.loads(json_string, parse_float=Decimal)
+        assert_equal(len(json_obj), 5)
+        for i, block in enumerate(json_obj):
+            rpc_block = self.nodes[0].getblock(hashes[i], 2)
+            assert_equal(block['hash'], hashes[i])
+            assert_equal(block['confirmations'], rpc_block['confirmations'])
+            assert_equal(block.get('nextblockhash'), rpc_block.get('nextblockhash'))
+            assert_equal([tx['txid'] for tx in block['tx']], [tx['txid'] for tx in rpc_block['tx']])
+        assert_equal('nextblockhash' in json_obj[-1], False)
+
+        hex_string = http_get_call(url.hostname, url.port, '/rest/blocks/'+str(start)+'/5'+self.FORMAT_SEPARATOR+'hex')
+        assert_equal(hex_string.split(), [self.nodes[0].getblock(h, False) for h in hashes])
+
+        response = http_get_call(url.hostname, url.port, '/rest/blocks/'+str(tip_height + 1)+'/1'+self.FORMAT_SEPARATOR+'json', True)
+        assert_equal(response.status, 404)
+        response = http_get_call(url.hostname, url.port, '/rest/blocks/'+str(start)+'/0'+self.FORMAT_SEPARATOR+'json', True)
+        assert_equal(response.status, 400)
+
+        for verbosity in range(0, 3):
+            blocks = self.nodes[0].getblocks(start, 10, verbosity)
+            assert_equal(len(blocks), 5)
+            for i, block in enumerate(blocks):
+                assert_equal(block, self.nodes[0].getblock(hashes[i], verbosity))
+        assert_raises_jsonrpc(-8, "out of range", self.nodes[0].getblocks, tip_height + 1, 1)
+
         #test rest bestblock
         bb_hash = self.nodes[0].getbestblockhash()
 
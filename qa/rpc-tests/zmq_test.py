@@ -92,6 +92,16 @@ class ZMQTest (BitcoinTestFramework):
 
         assert_equal(hashRPC, hashZMQ) #blockhash from generate must be equal to the hash received over zmq
 
+        info = self.nodes[0].getzmqnotifications()
+        assert_equal(info["queuesize"], 0)
+        assert_equal(len(info["notifiers"]), 2)
+        for notifier in info["notifiers"]:
+            assert_equal(notifier["address"], "tcp://127.0.0.1:%i" % self.port)
+            assert_equal(notifier["hwm"], 1000)
+            assert_equal(notifier["dropped"], 0)
+            assert(notifier["published"] > 0)
+        assert_equal(self.nodes[1].getzmqnotifications()["notifiers"], [])
+
 
 if __name__ == '__main__':
     ZMQTest ().main ()
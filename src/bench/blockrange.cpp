@@ -0,0 +1,98 @@
+// Copyright (c) 2019 The Polis Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "blockrange.h"
+#include "chain.h"
+#include "chainparams.h"
+#include "random.h"
+#include "streams.h"
+#include "util.h"
+#include "validation.h"
+
+#include "bench/data/block813851.raw.h"
+
+#include <atomic>
+
+#include <boost/filesystem.hpp>
+
+static const int RANGE_BLOCKS = 100;
+
+// Writes RANGE_BLOCKS copies of the same block into a fresh datadir, just like AcceptBlock would
+class BlockRangeSetup
+{
+private:
+    boost::filesystem::path pathTemp;
+
+public:
+    std::vector<uint256> vHashes;
+    std::vector<CBlockIndex> vIndex;
+    std::vector<const CBlockIndex*> vBlocks;
+
+    BlockRangeSetup() : vHashes(RANGE_BLOCKS), vIndex(RANGE_BLOCKS)
+    {
+        SelectParams(CBaseChainParams::MAIN);
+        pathTemp = boost::filesystem::temp_directory_path() / strprintf("bench_polis_%lu_%i", (unsigned long)GetTime(), (int)GetRand(100000));
+        boost::filesystem::create_directories(pathTemp);
+        ForceSetArg("-datadir", pathTemp.string());
+        ClearDatadirCache();
+
+        CDataStream stream((const char*)raw_bench::block813851,
+                (const char*)&raw_bench::block813851[sizeof(raw_bench::block813851)],
+                SER_NETWORK, PROTOCOL_VERSION);
+        CBlock block;
+        stream >> block;
+
+        for (int i = 0; i < RANGE_BLOCKS; i++) {
+            CDiskBlockPos pos(0, i * (sizeof(raw_bench::block813851) + 8));
+            assert(WriteBlockToDisk(block, pos, Params().MessageStart()));
+            vHashes[i] = block.GetHash();
+            vIndex[i].phashBlock = &vHashes[i];
+            vIndex[i].nHeight = i;
+            vIndex[i].nFile = pos.nFile;
+            vIndex[i].nDataPos = pos.nPos;
+            vIndex[i].nStatus |= BLOCK_HAVE_DATA;
+            vBlocks.push_back(&vIndex[i]);
+        }
+    }
+
+    ~BlockRangeSetup()
+    {
+        ClearDatadirCache();
+        boost::filesystem::remove_all(pathTemp);
+    }
+};
+
+// What a client fetching the blocks with getblock/rest/block has to do
+static void ReadBlocksOneByOne(benchmark::State& state)
+{
+    BlockRangeSetup setup;
+    const Consensus::Params& params = Params().GetConsensus();
+
+    while (state.KeepRunning()) {
+        for (const CBlockIndex* pindex : setup.vBlocks) {
+            CBlock block;
+            assert(ReadBlockFromDisk(block, pindex, params));
+        }
+    }
+}
+
+static void ReadBlockRangeParallel(benchmark::State& state)
+{
+    BlockRangeSetup setup;
+    const Consensus::Params& params = Params().GetConsensus();
+
+    while (state.KeepRunning()) {
+        std::string strError;
+        std::atomic<int> nBlocks(0);
+        assert(ReadBlockRange(setup.vBlocks, params, 0,
+            [&](size_t, const CBlockIndex*, const CBlock&, const std::vector<char>&) { nBlocks++; },
+            [](size_t, size_t) { return true; }, strError));
+        assert(nBlocks == RANGE_BLOCKS);
+    }
+}
+
+BENCHMARK(ReadBlocksOneByOne);
+BENCHMARK(ReadBlockRangeParallel);
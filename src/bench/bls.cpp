@@ -343,6 +343,48 @@ static void BLSVerify_BatchedParallel(benchmark::State& state)
     }
 }
 
+// Verifies 1024 signatures (1% invalid) per iteration with VerifySigBatch
+static void BLSVerify_SigBatch(benchmark::State& state, size_t batchSize)
+{
+    BLSPublicKeyVector pubKeys;
+    BLSSecretKeyVector secKeys;
+    BLSSignatureVector sigs;
+    std::vector<uint256> msgHashes;
+    std::vector<bool> invalid;
+    BuildTestVectors(1024, 10, pubKeys, secKeys, sigs, msgHashes, invalid);
+
+    // Benchmark.
+    while (state.KeepRunning()) {
+        auto valid = blsWorker.VerifySigBatch(sigs, pubKeys, msgHashes, batchSize);
+        for (size_t i = 0; i < valid.size(); i++) {
+            if (valid[i] == invalid[i]) {
+                std::cout << "unexpected verification result" << std::endl;
+                assert(false);
+            }
+        }
+    }
+}
+
+static void BLSVerify_SigBatch1(benchmark::State& state)
+{
+    BLSVerify_SigBatch(state, 1);
+}
+
+static void BLSVerify_SigBatch16(benchmark::State& state)
+{
+    BLSVerify_SigBatch(state, 16);
+}
+
+static void BLSVerify_SigBatch128(benchmark::State& state)
+{
+    BLSVerify_SigBatch(state, 128);
+}
+
+static void BLSVerify_SigBatch1024(benchmark::State& state)
+{
+    BLSVerify_SigBatch(state, 1024);
+}
+
 BENCHMARK(BLSPubKeyAggregate_Normal)
 BENCHMARK(BLSSecKeyAggregate_Normal)
 BENCHMARK(BLSSign_Normal)
@@ -355,3 +397,7 @@ BENCHMARK(BLSVerify_LargeAggregatedBlock10000)
 BENCHMARK(BLSVerify_LargeAggregatedBlock1000PreVerified)
 BENCHMARK(BLSVerify_Batched)
 BENCHMARK(BLSVerify_BatchedParallel)
+BENCHMARK(BLSVerify_SigBatch1)
+BENCHMARK(BLSVerify_SigBatch16)
+BENCHMARK(BLSVerify_SigBatch128)
+BENCHMARK(BLSVerify_SigBatch1024)
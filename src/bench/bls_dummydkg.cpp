@@ -0,0 +1,143 @@
+// Copyright (c) 2019 The Polis Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "bls/bls_worker.h"
+#include "llmq/quorums_dummydkg.h"
+#include "llmq/quorums_utils.h"
+#include "random.h"
+
+#include <iostream>
+
+extern CBLSWorker blsWorker;
+
+// Messages of all members of a LLMQ_400_60 quorum for one dummy DKG session
+struct DummyDKGSession
+{
+    static const int QUORUM_SIZE = 400;
+    static const int QUORUM_THRESHOLD = 240;
+
+    BLSVerificationVectorPtr vvec;
+    std::vector<CBLSId> ids;
+    BLSPublicKeyVector pubKeys;
+    std::vector<llmq::CDummyContribution> contributions;
+    std::vector<llmq::CDummyCommitment> commitments;
+    std::vector<uint256> commitmentHashes;
+
+    DummyDKGSession()
+    {
+        uint256 quorumHash = GetRandHash();
+        std::vector<bool> validMembers(QUORUM_SIZE, true);
+
+        BLSSecretKeyVector svec(QUORUM_THRESHOLD);
+        vvec = std::make_shared<BLSVerificationVector>();
+        for (auto& sk : svec) {
+            sk.MakeNewKey();
+            vvec->emplace_back(sk.GetPublicKey());
+        }
+        uint256 commitmentHash = llmq::CLLMQUtils::BuildCommitmentHash(Consensus::LLMQ_400_60, quorumHash, validMembers, (*vvec)[0], ::SerializeHash(*vvec));
+
+        for (int i = 0; i < QUORUM_SIZE; i++) {
+            CBLSSecretKey operatorKey;
+            operatorKey.MakeNewKey();
+            ids.emplace_back(CBLSId::FromHash(GetRandHash()));
+            pubKeys.emplace_back(operatorKey.GetPublicKey());
+
+            llmq::CDummyContribution qc;
+            qc.llmqType = Consensus::LLMQ_400_60;
+            qc.quorumHash = quorumHash;
+            qc.signer = (uint16_t)i;
+            qc.sig = operatorKey.Sign(qc.GetSignHash());
+            contributions.emplace_back(qc);
+
+            CBLSSecretKey skShare;
+            skShare.SecretKeyShare(svec, ids.back());
+
+            llmq::CDummyCommitment qc2;
+            qc2.llmqType = Consensus::LLMQ_400_60;
+            qc2.quorumHash = quorumHash;
+            qc2.signer = (uint16_t)i;
+            qc2.validMembers = validMembers;
+            qc2.membersSig = operatorKey.Sign(commitmentHash);
+            qc2.quorumSig = skShare.Sign(commitmentHash);
+            commitments.emplace_back(qc2);
+            commitmentHashes.emplace_back(commitmentHash);
+        }
+    }
+};
+
+static const DummyDKGSession& GetDummyDKGSession()
+{
+    static DummyDKGSession session;
+    return session;
+}
+
+static void CheckAllValid(const std::vector<bool>& valid)
+{
+    for (bool v : valid) {
+        if (!v) {
+            std::cout << "unexpected verification result" << std::endl;
+            assert(false);
+        }
+    }
+}
+
+// Verification of each contribution on arrival, as done before messages were queued
+static void DummyDKG_VerifyContributions400_Serial(benchmark::State& state)
+{
+    const auto& session = GetDummyDKGSession();
+
+    while (state.KeepRunning()) {
+        std::vector<bool> valid;
+        for (size_t i = 0; i < session.contributions.size(); i++) {
+            const auto& qc = session.contributions[i];
+            valid.emplace_back(qc.sig.VerifyInsecure(session.pubKeys[i], qc.GetSignHash()));
+        }
+        CheckAllValid(valid);
+    }
+}
+
+static void DummyDKG_VerifyContributions400_Batched(benchmark::State& state)
+{
+    const auto& session = GetDummyDKGSession();
+
+    while (state.KeepRunning()) {
+        CheckAllValid(llmq::CDummyDKG::VerifyContributionSigs(blsWorker, session.contributions, session.pubKeys));
+    }
+}
+
+static void DummyDKG_VerifyCommitments400_Serial(benchmark::State& state)
+{
+    const auto& session = GetDummyDKGSession();
+
+    while (state.KeepRunning()) {
+        std::vector<bool> valid;
+        for (size_t i = 0; i < session.commitments.size(); i++) {
+            const auto& qc = session.commitments[i];
+            CBLSPublicKey sharePk;
+            sharePk.PublicKeyShare(*session.vvec, session.ids[i]);
+            valid.emplace_back(qc.membersSig.VerifyInsecure(session.pubKeys[i], session.commitmentHashes[i]) &&
+                               qc.quorumSig.VerifyInsecure(sharePk, session.commitmentHashes[i]));
+        }
+        CheckAllValid(valid);
+    }
+}
+
+static void DummyDKG_VerifyCommitments400_Batched(benchmark::State& state)
+{
+    const auto& session = GetDummyDKGSession();
+
+    while (state.KeepRunning()) {
+        BLSPublicKeyVector sharePks;
+        for (const auto& id : session.ids) {
+            sharePks.emplace_back(blsWorker.BuildPubKeyShare(session.vvec, id));
+        }
+        CheckAllValid(llmq::CDummyDKG::VerifyCommitmentSigs(blsWorker, session.commitments, session.commitmentHashes, session.pubKeys, sharePks));
+    }
+}
+
+BENCHMARK(DummyDKG_VerifyContributions400_Serial)
+BENCHMARK(DummyDKG_VerifyContributions400_Batched)
+BENCHMARK(DummyDKG_VerifyCommitments400_Serial)
+BENCHMARK(DummyDKG_VerifyCommitments400_Batched)
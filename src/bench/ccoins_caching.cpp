@@ -5,6 +5,7 @@
 #include "bench.h"
 #include "coins.h"
 #include "policy/policy.h"
+#include "random.h"
 #include "wallet/crypter.h"
 
 #include <vector>
@@ -84,4 +85,41 @@ static void CCoinsCaching(benchmark::State& state)
     }
 }
 
+// Lookups in a cache holding many coins, which is dominated by the layout of CCoinsMap (cache
+// misses while walking the bucket list) rather than by the script checks above.
+static void CCoinsCachingManyCoins(benchmark::State& state)
+{
+    static const int COIN_COUNT = 100000;
+
+    CCoinsView coinsDummy;
+    CCoinsViewCache coins(&coinsDummy);
+
+    std::vector<COutPoint> outpoints;
+    outpoints.reserve(COIN_COUNT);
+    for (int i = 0; i < COIN_COUNT; i++) {
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].scriptSig = CScript() << i;
+        tx.vout.resize(1);
+        tx.vout[0].nValue = CENT;
+        tx.vout[0].scriptPubKey << OP_1;
+        AddCoins(coins, tx, 1);
+        outpoints.emplace_back(tx.GetHash(), 0);
+    }
+
+    // visit the coins in a different order than they were inserted
+    FastRandomContext insecure_rand(true);
+    for (size_t i = outpoints.size() - 1; i > 0; i--) {
+        std::swap(outpoints[i], outpoints[insecure_rand.rand32() % (i + 1)]);
+    }
+
+    while (state.KeepRunning()) {
+        for (const auto& outpoint : outpoints) {
+            const Coin& coin = coins.AccessCoin(outpoint);
+            assert(!coin.IsSpent());
+        }
+    }
+}
+
 BENCHMARK(CCoinsCaching);
+BENCHMARK(CCoinsCachingManyCoins);
@@ -8,6 +8,9 @@
 #include "validation.h"
 #include "streams.h"
 #include "consensus/validation.h"
+#include "key.h"
+#include "script/interpreter.h"
+#include "script/standard.h"
 
 #include "bench/data/block813851.raw.h"
 
@@ -50,5 +53,68 @@ static void DeserializeAndCheckBlockTest(benchmark::State& state)
     }
 }
 
+// A block with a consolidation tx that spends many P2PKH outputs of the same key, similar to large PrivateSend
+// denomination txs. Legacy signature hashes serialize the whole tx for every input, so script checks of such txs
+// are dominated by SignatureHash
+static const size_t MANY_INPUTS_COUNT = 1000;
+
+static void CreateManyInputsBlock(CBlock& block, CScript& scriptPubKey)
+{
+    CKey key;
+    key.MakeNewKey(true);
+    scriptPubKey = GetScriptForDestination(key.GetPubKey().GetID());
+
+    CMutableTransaction tx;
+    tx.vin.resize(MANY_INPUTS_COUNT);
+    for (size_t i = 0; i < tx.vin.size(); i++) {
+        tx.vin[i].prevout = COutPoint(::SerializeHash((uint32_t)i), 0);
+    }
+    tx.vout.emplace_back(MANY_INPUTS_COUNT * COIN, scriptPubKey);
+
+    // the input scripts are not part of the signed data, so all inputs can be signed with the unsigned tx
+    const CTransaction txUnsigned(tx);
+    PrecomputedTransactionData txdata(txUnsigned);
+    for (size_t i = 0; i < tx.vin.size(); i++) {
+        uint256 hash = SignatureHash(scriptPubKey, txUnsigned, i, SIGHASH_ALL, &txdata);
+        std::vector<unsigned char> vchSig;
+        assert(key.Sign(hash, vchSig));
+        vchSig.push_back((unsigned char)SIGHASH_ALL);
+        tx.vin[i].scriptSig = CScript() << vchSig << ToByteVector(key.GetPubKey());
+    }
+    block.vtx.emplace_back(MakeTransactionRef(std::move(tx)));
+}
+
+static void VerifyManyInputsBlock(benchmark::State& state, bool fPrecompute)
+{
+    ECCVerifyHandle verifyHandle;
+
+    CBlock block;
+    CScript scriptPubKey;
+    CreateManyInputsBlock(block, scriptPubKey);
+
+    while (state.KeepRunning()) {
+        for (const auto& tx : block.vtx) {
+            // precomputing is part of the measured work, as it is in ConnectBlock
+            std::unique_ptr<PrecomputedTransactionData> txdata(fPrecompute ? new PrecomputedTransactionData(*tx) : nullptr);
+            for (size_t i = 0; i < tx->vin.size(); i++) {
+                TransactionSignatureChecker checker = txdata ? TransactionSignatureChecker(tx.get(), i, *txdata) : TransactionSignatureChecker(tx.get(), i);
+                assert(VerifyScript(tx->vin[i].scriptSig, scriptPubKey, MANDATORY_SCRIPT_VERIFY_FLAGS, checker));
+            }
+        }
+    }
+}
+
+static void VerifyManyInputsBlockTest(benchmark::State& state)
+{
+    VerifyManyInputsBlock(state, true);
+}
+
+static void VerifyManyInputsBlockNoPrecomputeTest(benchmark::State& state)
+{
+    VerifyManyInputsBlock(state, false);
+}
+
 BENCHMARK(DeserializeBlockTest);
 BENCHMARK(DeserializeAndCheckBlockTest);
+BENCHMARK(VerifyManyInputsBlockTest);
+BENCHMARK(VerifyManyInputsBlockNoPrecomputeTest);
@@ -0,0 +1,65 @@
+// Copyright (c) 2019 The Polis Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "evo/deterministicmns.h"
+#include "streams.h"
+
+static const int MASTERNODE_COUNT = 5000;
+
+// A serialized list snapshot like the ones CDeterministicMNManager keeps in CEvoDB
+static const CDataStream& GetMNListSnapshot()
+{
+    static CDataStream ds(SER_DISK, CLIENT_VERSION);
+    if (ds.empty()) {
+        CDeterministicMNList mnList(uint256(), 1000);
+        for (int i = 0; i < MASTERNODE_COUNT; i++) {
+            CBLSSecretKey sk;
+            sk.MakeNewKey();
+
+            auto dmnState = std::make_shared<CDeterministicMNState>();
+            dmnState->nRegisteredHeight = i;
+            dmnState->pubKeyOperator.Set(sk.GetPublicKey());
+            dmnState->addr = CService(CNetAddr(), 24126);
+
+            auto dmn = std::make_shared<CDeterministicMN>();
+            dmn->proTxHash = (CHashWriter(SER_GETHASH, 0) << i).GetHash();
+            dmn->collateralOutpoint = COutPoint(dmn->proTxHash, 0);
+            dmn->nOperatorReward = 0;
+            dmn->pdmnState = dmnState;
+            mnList.AddMN(dmn);
+        }
+        ds << mnList;
+    }
+    return ds;
+}
+
+// Loading a snapshot only keeps the serialized operator keys
+static void EvoDeserializeMNList(benchmark::State& state)
+{
+    const CDataStream& ds = GetMNListSnapshot();
+    while (state.KeepRunning()) {
+        CDataStream ds2(ds);
+        CDeterministicMNList mnList;
+        ds2 >> mnList;
+    }
+}
+
+// Same as before the operator keys were lazy: every key is decompressed while loading
+static void EvoDeserializeMNListEager(benchmark::State& state)
+{
+    const CDataStream& ds = GetMNListSnapshot();
+    while (state.KeepRunning()) {
+        CDataStream ds2(ds);
+        CDeterministicMNList mnList;
+        ds2 >> mnList;
+        mnList.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
+            dmn->pdmnState->pubKeyOperator.Get();
+        });
+    }
+}
+
+BENCHMARK(EvoDeserializeMNList);
+BENCHMARK(EvoDeserializeMNListEager);
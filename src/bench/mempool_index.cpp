@@ -0,0 +1,114 @@
+// Copyright (c) 2019 The Polis Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+#include "coins.h"
+#include "crypto/common.h"
+#include "pubkey.h"
+#include "policy/policy.h"
+#include "script/standard.h"
+#include "txmempool.h"
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+static const int MEMPOOL_INDEX_TX_COUNT = 1000;
+static const int MEMPOOL_INDEX_ADDRESS_COUNT = 100;
+
+static CScript AddressScript(int i)
+{
+    uint160 hash;
+    WriteLE32(hash.begin(), i + 1);
+    return GetScriptForDestination(CKeyID(hash));
+}
+
+// Adds and removes transactions (and their address/spent index entries) to the mempool the same way
+// AcceptToMemoryPool and block connection do when -addressindex and -spentindex are enabled.
+// If fConcurrentReader is set, another thread runs getaddressmempool-like queries at the same time.
+static void MempoolIndexes(benchmark::State& state, bool fConcurrentReader)
+{
+    CCoinsView coinsDummy;
+    CCoinsViewCache coins(&coinsDummy);
+
+    std::vector<CTransactionRef> txs;
+    for (int i = 0; i < MEMPOOL_INDEX_TX_COUNT; i++) {
+        CMutableTransaction txPrev;
+        txPrev.vin.resize(1);
+        txPrev.vin[0].scriptSig = CScript() << i;
+        txPrev.vout.resize(1);
+        txPrev.vout[0].nValue = 10 * COIN;
+        txPrev.vout[0].scriptPubKey = AddressScript(i % MEMPOOL_INDEX_ADDRESS_COUNT);
+        AddCoins(coins, txPrev, 1);
+
+        CMutableTransaction tx;
+        tx.vin.resize(1);
+        tx.vin[0].prevout = COutPoint(txPrev.GetHash(), 0);
+        tx.vout.resize(2);
+        for (int j = 0; j < 2; j++) {
+            tx.vout[j].nValue = 5 * COIN;
+            tx.vout[j].scriptPubKey = AddressScript((i + j + 1) % MEMPOOL_INDEX_ADDRESS_COUNT);
+        }
+        txs.emplace_back(MakeTransactionRef(tx));
+    }
+
+    std::vector<std::pair<uint160, int> > addresses;
+    for (int i = 0; i < MEMPOOL_INDEX_ADDRESS_COUNT; i++) {
+        CScript script = AddressScript(i);
+        addresses.emplace_back(uint160(std::vector<unsigned char>(script.begin() + 3, script.begin() + 23)), 1);
+    }
+
+    CTxMemPool pool(CFeeRate(0));
+    LockPoints lp;
+
+    std::atomic<bool> fStop(false);
+    std::atomic<uint64_t> nQueries(0);
+    std::thread reader;
+    if (fConcurrentReader) {
+        reader = std::thread([&]() {
+            while (!fStop) {
+                for (const auto& address : addresses) {
+                    std::vector<std::pair<uint160, int> > query{address};
+                    std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> > results;
+                    pool.getAddressIndex(query, results);
+                    CSpentIndexKey key(txs[nQueries % txs.size()]->vin[0].prevout.hash, 0);
+                    CSpentIndexValue value;
+                    pool.getSpentIndex(key, value);
+                    nQueries++;
+                }
+            }
+        });
+    }
+
+    while (state.KeepRunning()) {
+        for (const auto& tx : txs) {
+            CTxMemPoolEntry entry(tx, 1000, 0, 10.0, 1, tx->GetValueOut(), false, 1, lp);
+            LOCK(pool.cs);
+            pool.addUnchecked(tx->GetHash(), entry);
+            pool.addAddressIndex(entry, coins);
+            pool.addSpentIndex(entry, coins);
+        }
+        for (const auto& tx : txs) {
+            pool.removeRecursive(*tx);
+        }
+    }
+
+    fStop = true;
+    if (reader.joinable()) {
+        reader.join();
+    }
+}
+
+static void MempoolIndexesNoReader(benchmark::State& state)
+{
+    MempoolIndexes(state, false);
+}
+
+static void MempoolIndexesConcurrentReader(benchmark::State& state)
+{
+    MempoolIndexes(state, true);
+}
+
+BENCHMARK(MempoolIndexesNoReader);
+BENCHMARK(MempoolIndexesConcurrentReader);
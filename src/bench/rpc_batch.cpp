@@ -0,0 +1,70 @@
+// Copyright (c) 2019 The Polis Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "chainparams.h"
+#include "core_io.h"
+#include "primitives/block.h"
+#include "rpc/register.h"
+#include "rpc/server.h"
+#include "streams.h"
+#include "util.h"
+
+#include "bench/data/block813851.raw.h"
+
+#include <univalue.h>
+
+static const int BATCH_SIZE = 500;
+
+// A batch of BATCH_SIZE decoderawtransaction calls, each for another transaction of the bench block
+static UniValue SetupBatch()
+{
+    SelectParams(CBaseChainParams::MAIN);
+    RegisterRawTransactionRPCCommands(tableRPC);
+    if (RPCIsInWarmup(NULL))
+        SetRPCWarmupFinished();
+
+    CDataStream stream((const char*)raw_bench::block813851,
+            (const char*)&raw_bench::block813851[sizeof(raw_bench::block813851)],
+            SER_NETWORK, PROTOCOL_VERSION);
+    CBlock block;
+    stream >> block;
+
+    UniValue batch(UniValue::VARR);
+    for (int i = 0; i < BATCH_SIZE; i++) {
+        UniValue params(UniValue::VARR);
+        params.push_back(EncodeHexTx(*block.vtx[1 + i % (block.vtx.size() - 1)]));
+        UniValue req(UniValue::VOBJ);
+        req.push_back(Pair("method", "decoderawtransaction"));
+        req.push_back(Pair("params", params));
+        req.push_back(Pair("id", i));
+        batch.push_back(req);
+    }
+    return batch;
+}
+
+static void RPCBatch(benchmark::State& state, int nThreads)
+{
+    const UniValue batch = SetupBatch();
+    ForceSetArg("-rpcbatchthreads", std::to_string(nThreads));
+
+    while (state.KeepRunning()) {
+        std::string strReply = JSONRPCExecBatch(batch);
+        assert(strReply.find("\"error\":null") != std::string::npos);
+    }
+}
+
+static void RPCBatchSequential(benchmark::State& state)
+{
+    RPCBatch(state, 1);
+}
+
+static void RPCBatchParallel(benchmark::State& state)
+{
+    RPCBatch(state, DEFAULT_RPC_BATCH_THREADS);
+}
+
+BENCHMARK(RPCBatchSequential);
+BENCHMARK(RPCBatchParallel);
@@ -0,0 +1,91 @@
+// Copyright (c) 2019 The Polis Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "evo/simplifiedmns.h"
+#include "hash.h"
+
+#include <algorithm>
+
+static const int MASTERNODE_COUNT = 5000;
+//! Roughly the number of list entries changing per block (new registrations, PoSe, updates)
+static const int CHANGES_PER_BLOCK = 5;
+
+static uint256 MakeHash(uint32_t n, uint32_t salt)
+{
+    return (CHashWriter(SER_GETHASH, 0) << n << salt).GetHash();
+}
+
+static std::vector<CSimplifiedMNListEntry> MakeEntries()
+{
+    std::vector<CSimplifiedMNListEntry> entries(MASTERNODE_COUNT);
+    for (int i = 0; i < MASTERNODE_COUNT; i++) {
+        entries[i].proRegTxHash = MakeHash(i, 0);
+        entries[i].confirmedHash = MakeHash(i, 1);
+        entries[i].isValid = true;
+    }
+    std::sort(entries.begin(), entries.end(), [](const CSimplifiedMNListEntry& a, const CSimplifiedMNListEntry& b) {
+        return a.proRegTxHash < b.proRegTxHash;
+    });
+    return entries;
+}
+
+// Rehashes all entries, like CalcCbTxMerkleRootMNList did for every block
+static void SMLMerkleRootFull(benchmark::State& state)
+{
+    CSimplifiedMNList sml(MakeEntries());
+    uint32_t n = 0;
+    while (state.KeepRunning()) {
+        for (int i = 0; i < CHANGES_PER_BLOCK; i++) {
+            sml.mnList[(n * 7919 + i * 1031) % MASTERNODE_COUNT].confirmedHash = MakeHash(n, i);
+        }
+        uint256 root = sml.CalcMerkleRoot();
+        n++;
+    }
+}
+
+static void SMLMerkleRootIncremental(benchmark::State& state)
+{
+    std::vector<CSimplifiedMNListEntry> entries = MakeEntries();
+    std::vector<std::pair<uint256, uint256>> vLeaves;
+    for (const auto& smle : entries) {
+        vLeaves.emplace_back(smle.proRegTxHash, smle.CalcHash());
+    }
+    CSimplifiedMNListMerkleTree tree;
+    tree.Build(vLeaves);
+    uint32_t n = 0;
+    while (state.KeepRunning()) {
+        for (int i = 0; i < CHANGES_PER_BLOCK; i++) {
+            auto& smle = entries[(n * 7919 + i * 1031) % MASTERNODE_COUNT];
+            smle.confirmedHash = MakeHash(n, i);
+            tree.Update(smle.proRegTxHash, smle.CalcHash());
+        }
+        uint256 root = tree.CalcRoot();
+        n++;
+    }
+}
+
+// One registration and one removal per block, which shifts the leaves between both positions
+static void SMLMerkleRootIncrementalAddRemove(benchmark::State& state)
+{
+    std::vector<CSimplifiedMNListEntry> entries = MakeEntries();
+    std::vector<std::pair<uint256, uint256>> vLeaves;
+    for (const auto& smle : entries) {
+        vLeaves.emplace_back(smle.proRegTxHash, smle.CalcHash());
+    }
+    CSimplifiedMNListMerkleTree tree;
+    tree.Build(vLeaves);
+    uint32_t n = 0;
+    while (state.KeepRunning()) {
+        tree.Remove(vLeaves[n % MASTERNODE_COUNT].first);
+        tree.Update(MakeHash(n, 2), MakeHash(n, 3));
+        uint256 root = tree.CalcRoot();
+        n++;
+    }
+}
+
+BENCHMARK(SMLMerkleRootFull);
+BENCHMARK(SMLMerkleRootIncremental);
+BENCHMARK(SMLMerkleRootIncrementalAddRemove);
@@ -0,0 +1,96 @@
+// Copyright (c) 2019 The Polis Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "bench.h"
+
+#include "tinyformat.h"
+
+#include <univalue.h>
+
+static const int MASTERNODE_COUNT = 5000;
+
+// One entry of "masternodelist full"/"json"
+static UniValue BuildMasternodeEntry(int i)
+{
+    UniValue objMN(UniValue::VOBJ);
+    objMN.reserve(14);
+    objMN.push_back(Pair("address", strprintf("10.%d.%d.%d:24126", (i >> 16) & 0xff, (i >> 8) & 0xff, i & 0xff)));
+    objMN.push_back(Pair("payee", "PLmf6fB3DZjP9aXw1n9XfnmXn3Mr7fCaGS"));
+    objMN.push_back(Pair("status", "ENABLED"));
+    objMN.push_back(Pair("protocol", 70213));
+    objMN.push_back(Pair("daemonversion", "1.4.3"));
+    objMN.push_back(Pair("sentinelversion", "1.2.0"));
+    objMN.push_back(Pair("sentinelstate", "current"));
+    objMN.push_back(Pair("lastseen", (int64_t)1560000000 + i));
+    objMN.push_back(Pair("activeseconds", (int64_t)86400 * 30 + i));
+    objMN.push_back(Pair("lastpaidtime", (int64_t)1559000000 + i));
+    objMN.push_back(Pair("lastpaidblock", 250000 + i));
+    objMN.push_back(Pair("owneraddress", "PBTrP3Y1xM2QQ8qJTd8JCiJ1RGRGVM5ZVC"));
+    objMN.push_back(Pair("votingaddress", "PBTrP3Y1xM2QQ8qJTd8JCiJ1RGRGVM5ZVC"));
+    objMN.push_back(Pair("collateraladdress", "PKvhGFx4Vsr8sZ5Br3fDGcdMFb5KBfn8Gi"));
+    return objMN;
+}
+
+static std::string MasternodeOutpoint(int i)
+{
+    return strprintf("%064x-%d", i, i % 2);
+}
+
+// Builds the list the way handlers used to: every entry (and with it every subtree) is copied into its parent
+static void UniValueBuildCopy(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        UniValue obj(UniValue::VOBJ);
+        for (int i = 0; i < MASTERNODE_COUNT; i++) {
+            std::string strOutpoint = MasternodeOutpoint(i);
+            UniValue objMN = BuildMasternodeEntry(i);
+            obj.push_back(Pair(strOutpoint, objMN));
+        }
+    }
+}
+
+static void UniValueBuildMove(benchmark::State& state)
+{
+    while (state.KeepRunning()) {
+        UniValue obj(UniValue::VOBJ);
+        obj.reserve(MASTERNODE_COUNT);
+        for (int i = 0; i < MASTERNODE_COUNT; i++) {
+            obj.pushKV(MasternodeOutpoint(i), BuildMasternodeEntry(i));
+        }
+    }
+}
+
+static UniValue BuildMasternodeList()
+{
+    UniValue obj(UniValue::VOBJ);
+    obj.reserve(MASTERNODE_COUNT);
+    for (int i = 0; i < MASTERNODE_COUNT; i++) {
+        obj.pushKV(MasternodeOutpoint(i), BuildMasternodeEntry(i));
+    }
+    return obj;
+}
+
+static void UniValueWrite(benchmark::State& state)
+{
+    UniValue obj = BuildMasternodeList();
+    while (state.KeepRunning()) {
+        std::string strJson = obj.write();
+    }
+}
+
+// Appends to one buffer which keeps its capacity between replies
+static void UniValueWriteBuffer(benchmark::State& state)
+{
+    UniValue obj = BuildMasternodeList();
+    std::string strJson;
+    while (state.KeepRunning()) {
+        strJson.clear();
+        obj.write(strJson);
+    }
+}
+
+BENCHMARK(UniValueBuildCopy);
+BENCHMARK(UniValueBuildMove);
+BENCHMARK(UniValueWrite);
+BENCHMARK(UniValueWriteBuffer);
@@ -0,0 +1,186 @@
+// Copyright (c) 2019 The Polis Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "blockrange.h"
+
+#include "chain.h"
+#include "clientversion.h"
+#include "crypto/common.h"
+#include "pow.h"
+#include "primitives/block.h"
+#include "serialize.h"
+#include "streams.h"
+#include "tinyformat.h"
+#include "util.h"
+#include "validation.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+static const size_t BLOCK_RANGE_BATCH_BLOCKS = 64;
+static const size_t BLOCK_RANGE_BATCH_BYTES = 16 * 1024 * 1024;
+
+bool GetActiveChainRange(int nStart, int nCount, std::vector<const CBlockIndex*>& vBlocks, int& nTipHeight,
+                         const CBlockIndex*& pindexNext, std::string& strError)
+{
+    LOCK(cs_main);
+
+    if (nStart < 0 || nStart > chainActive.Height()) {
+        strError = strprintf("Block height %d out of range", nStart);
+        return false;
+    }
+    if (nCount < 1 || nCount > MAX_BLOCK_RANGE_COUNT) {
+        strError = strprintf("Block count must be between 1 and %d", MAX_BLOCK_RANGE_COUNT);
+        return false;
+    }
+
+    vBlocks.clear();
+    for (int nHeight = nStart; nHeight < nStart + nCount && nHeight <= chainActive.Height(); nHeight++) {
+        const CBlockIndex* pindex = chainActive[nHeight];
+        if (!(pindex->nStatus & BLOCK_HAVE_DATA)) {
+            strError = strprintf("Block %d not available (pruned data)", nHeight);
+            return false;
+        }
+        vBlocks.push_back(pindex);
+    }
+    nTipHeight = chainActive.Height();
+    pindexNext = chainActive.Next(vBlocks.back());
+    return true;
+}
+
+namespace {
+
+/** Reads blocks from the blk*.dat files, keeping the current file open between blocks */
+class CSequentialBlockReader
+{
+private:
+    FILE* file{nullptr};
+    int nFile{-1};
+    //! position of file, or 0 if unknown
+    unsigned int nOffset{0};
+
+    void Close()
+    {
+        if (file)
+            fclose(file);
+        file = nullptr;
+        nFile = -1;
+        nOffset = 0;
+    }
+
+public:
+    ~CSequentialBlockReader() { Close(); }
+
+    bool Read(const CBlockIndex* pindex, std::vector<char>& vchRaw)
+    {
+        // Every block is preceded by the network magic and its size
+        const CDiskBlockPos pos = pindex->GetBlockPos();
+        if (pos.nPos < 8)
+            return error("%s: invalid block position %s", __func__, pos.ToString());
+        const unsigned int nHeaderPos = pos.nPos - 8;
+
+        if (pos.nFile != nFile) {
+            Close();
+            file = OpenBlockFile(CDiskBlockPos(pos.nFile, nHeaderPos), true);
+            if (!file)
+                return error("%s: OpenBlockFile failed for %s", __func__, pos.ToString());
+            nFile = pos.nFile;
+        } else if (nOffset != nHeaderPos && fseek(file, nHeaderPos, SEEK_SET)) {
+            Close();
+            return error("%s: seek to %s failed", __func__, pos.ToString());
+        }
+        nOffset = 0;
+
+        unsigned char header[8];
+        if (fread(header, 1, sizeof(header), file) != sizeof(header))
+            return error("%s: failed to read block size at %s", __func__, pos.ToString());
+        const uint32_t nSize = ReadLE32(header + 4);
+        if (nSize < 80 || nSize > MAX_SIZE)
+            return error("%s: invalid block size %u at %s", __func__, nSize, pos.ToString());
+
+        vchRaw.resize(nSize);
+        if (fread(vchRaw.data(), 1, nSize, file) != nSize)
+            return error("%s: failed to read block at %s", __func__, pos.ToString());
+        nOffset = pos.nPos + nSize;
+        return true;
+    }
+};
+
+} // namespace
+
+bool ReadBlockRange(const std::vector<const CBlockIndex*>& vBlocks, const Consensus::Params& consensusParams, int nThreads,
+                    const BlockRangeProcessFn& fnProcess, const BlockRangeBatchFn& fnBatch, std::string& strError)
+{
+    if (nThreads <= 0)
+        nThreads = std::min(GetNumCores(), MAX_BLOCK_RANGE_THREADS);
+    nThreads = std::max(1, std::min(nThreads, MAX_BLOCK_RANGE_THREADS));
+
+    CSequentialBlockReader reader;
+    std::vector<std::vector<char> > vRaw;
+    size_t nFirst = 0;
+    while (nFirst < vBlocks.size()) {
+        // Read the next batch, one block after the other
+        size_t nCount = 0;
+        size_t nBytes = 0;
+        while (nFirst + nCount < vBlocks.size() && nCount < BLOCK_RANGE_BATCH_BLOCKS && nBytes < BLOCK_RANGE_BATCH_BYTES) {
+            if (vRaw.size() <= nCount)
+                vRaw.resize(nCount + 1);
+            const CBlockIndex* pindex = vBlocks[nFirst + nCount];
+            if (!reader.Read(pindex, vRaw[nCount])) {
+                strError = strprintf("Can't read block %d from disk", pindex->nHeight);
+                return false;
+            }
+            nBytes += vRaw[nCount].size();
+            nCount++;
+        }
+
+        // Decode it in parallel
+        std::atomic<size_t> nNext(0);
+        std::atomic<int> nFailedHeight(-1);
+        auto worker = [&]() {
+            size_t n;
+            while ((n = nNext++) < nCount && nFailedHeight < 0) {
+                const CBlockIndex* pindex = vBlocks[nFirst + n];
+                CBlock block;
+                try {
+                    CDataStream ssBlock(vRaw[n].data(), vRaw[n].data() + vRaw[n].size(), SER_DISK, CLIENT_VERSION);
+                    ssBlock >> block;
+                } catch (const std::exception& e) {
+                    error("%s: deserialize error for block %s: %s", __func__, pindex->GetBlockHash().ToString(), e.what());
+                    nFailedHeight = pindex->nHeight;
+                    break;
+                }
+                // Same checks as ReadBlockFromDisk
+                if (block.IsProofOfWork() && !CheckProofOfWork(block.GetHash(), block.nBits, consensusParams)) {
+                    error("%s: errors in block header of %s", __func__, pindex->GetBlockHash().ToString());
+                    nFailedHeight = pindex->nHeight;
+                    break;
+                }
+                if (block.GetHash() != pindex->GetBlockHash()) {
+                    error("%s: GetHash() doesn't match index for %s", __func__, pindex->ToString());
+                    nFailedHeight = pindex->nHeight;
+                    break;
+                }
+                fnProcess(nFirst + n, pindex, block, vRaw[n]);
+            }
+        };
+
+        std::vector<std::thread> vThreads;
+        for (int i = 1; i < nThreads && (size_t)i < nCount; i++)
+            vThreads.emplace_back(worker);
+        worker();
+        for (auto& thread : vThreads)
+            thread.join();
+
+        if (nFailedHeight >= 0) {
+            strError = strprintf("Can't read block %d from disk", nFailedHeight.load());
+            return false;
+        }
+        if (!fnBatch(nFirst, nCount))
+            return true;
+        nFirst += nCount;
+    }
+    return true;
+}
@@ -0,0 +1,46 @@
+// Copyright (c) 2019 The Polis Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef POLIS_BLOCKRANGE_H
+#define POLIS_BLOCKRANGE_H
+
+#include <functional>
+#include <string>
+#include <vector>
+
+class CBlock;
+class CBlockIndex;
+
+namespace Consensus { struct Params; }
+
+//! Max. number of blocks which can be requested at once through /rest/blocks and getblocks
+static const int MAX_BLOCK_RANGE_COUNT = 1000;
+//! Max. number of threads decoding the blocks of a range
+static const int MAX_BLOCK_RANGE_THREADS = 8;
+
+/**
+ * Collect the blocks at heights nStart to nStart + nCount - 1 of the active chain. The range is cut
+ * short at the tip. Fails if nStart is not in the active chain or the data of one of the blocks is
+ * not available (e.g. pruned).
+ * nTipHeight and pindexNext (the block following the range, NULL at the tip) are taken under the same
+ * lock, so the decoding threads can report confirmations without looking at chainActive.
+ */
+bool GetActiveChainRange(int nStart, int nCount, std::vector<const CBlockIndex*>& vBlocks, int& nTipHeight,
+                         const CBlockIndex*& pindexNext, std::string& strError);
+
+/** Called for every block of a range, from several threads at once. Gets the serialized block as well. */
+typedef std::function<void(size_t nIndex, const CBlockIndex* pindex, const CBlock& block, const std::vector<char>& vchRaw)> BlockRangeProcessFn;
+/** Called in order once the blocks nFirst to nFirst + nCount - 1 were processed, stops reading if it returns false */
+typedef std::function<bool(size_t nFirst, size_t nCount)> BlockRangeBatchFn;
+
+/**
+ * Read the given blocks in batches of up to 64 blocks or 16MB. The blocks of a batch are read
+ * sequentially, so consecutive blocks of the same blk*.dat file cost no extra seeks or opens, and are
+ * then decoded and handed to fnProcess in parallel by up to nThreads threads (<= 0 picks a default).
+ * Only one batch is held in memory, fnBatch is expected to send out or otherwise consume it.
+ */
+bool ReadBlockRange(const std::vector<const CBlockIndex*>& vBlocks, const Consensus::Params& consensusParams, int nThreads,
+                    const BlockRangeProcessFn& fnProcess, const BlockRangeBatchFn& fnBatch, std::string& strError);
+
+#endif // POLIS_BLOCKRANGE_H
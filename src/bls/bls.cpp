@@ -215,6 +215,32 @@ CBLSPublicKey CBLSPublicKey::AggregateInsecure(const std::vector<CBLSPublicKey>&
     return ret;
 }
 
+CBLSPublicKey CBLSPublicKey::AggregateSecure(const std::vector<CBLSPublicKey>& pks)
+{
+    if (pks.empty()) {
+        return CBLSPublicKey();
+    }
+
+    std::vector<bls::PublicKey> v;
+    v.reserve(pks.size());
+    for (auto& pk : pks) {
+        if (!pk.IsValid()) {
+            return CBLSPublicKey();
+        }
+        v.emplace_back(pk.impl);
+    }
+
+    CBLSPublicKey ret;
+    try {
+        ret.impl = bls::PublicKey::Aggregate(v);
+    } catch (...) {
+        return CBLSPublicKey();
+    }
+    ret.fValid = true;
+    ret.UpdateHash();
+    return ret;
+}
+
 bool CBLSPublicKey::PublicKeyShare(const std::vector<CBLSPublicKey>& mpk, const CBLSId& _id)
 {
     fValid = false;
@@ -372,6 +398,101 @@ bool CBLSSignature::VerifyInsecureAggregated(const std::vector<CBLSPublicKey>& p
     }
 }
 
+// chia serializes points in relic's compressed form, but without the leading byte and with the sign of y in the highest bit
+static void ReadG1(g1_t p, const uint8_t* buf)
+{
+    uint8_t tmp[BLS_CURVE_PUBKEY_SIZE + 1];
+    memcpy(tmp + 1, buf, BLS_CURVE_PUBKEY_SIZE);
+    tmp[0] = (buf[0] & 0x80) ? 0x03 : 0x02;
+    tmp[1] &= 0x7f;
+    g1_read_bin(p, tmp, sizeof(tmp));
+}
+
+static void ReadG2(g2_t p, const uint8_t* buf)
+{
+    uint8_t tmp[BLS_CURVE_SIG_SIZE + 1];
+    memcpy(tmp + 1, buf, BLS_CURVE_SIG_SIZE);
+    tmp[0] = (buf[0] & 0x80) ? 0x03 : 0x02;
+    tmp[1] &= 0x7f;
+    g2_read_bin(p, tmp, sizeof(tmp));
+}
+
+bool CBLSSignature::VerifyInsecureBatched(const std::vector<CBLSSignature>& sigs, const std::vector<CBLSPublicKey>& pubKeys, const std::vector<uint256>& hashes)
+{
+    assert(!sigs.empty() && sigs.size() == pubKeys.size() && sigs.size() == hashes.size());
+
+    // 128 bit coefficients with the highest bit set, so that none of them is 0
+    static const size_t COEFF_SIZE = 16;
+    std::vector<uint8_t> coeffs(sigs.size() * COEFF_SIZE);
+    GetRandBytes(coeffs.data(), coeffs.size());
+
+    std::vector<bls::PublicKey> pubKeyVec;
+    std::vector<const uint8_t*> hashes2;
+    pubKeyVec.reserve(pubKeys.size());
+    hashes2.reserve(hashes.size());
+
+    bool ret = false;
+    bn_t r;
+    g1_t pk;
+    g2_t sig, aggSig;
+    bn_null(r);
+    g1_null(pk);
+    g2_null(sig);
+    g2_null(aggSig);
+    try {
+        bn_new(r);
+        g1_new(pk);
+        g2_new(sig);
+        g2_new(aggSig);
+        g2_set_infty(aggSig);
+
+        uint8_t buf[BLS_CURVE_SIG_SIZE];
+        uint8_t buf2[BLS_CURVE_SIG_SIZE];
+        size_t i = 0;
+        for (; i < sigs.size(); i++) {
+            if (!sigs[i].IsValid() || !pubKeys[i].IsValid()) {
+                break;
+            }
+            coeffs[i * COEFF_SIZE] |= 0x80;
+            bn_read_bin(r, &coeffs[i * COEFF_SIZE], COEFF_SIZE);
+
+            // chia doesn't give access to its points, so they are read back from the serialized form. This must result
+            // in the very same points chia uses, otherwise we would verify different sigs than the ones we were given
+            sigs[i].impl.Serialize(buf);
+            ReadG2(sig, buf);
+            bls::InsecureSignature::FromG2(&sig).Serialize(buf2);
+            if (memcmp(buf, buf2, BLS_CURVE_SIG_SIZE) != 0) {
+                break;
+            }
+            g2_mul(sig, sig, r);
+            g2_add(aggSig, aggSig, sig);
+
+            pubKeys[i].impl.Serialize(buf);
+            ReadG1(pk, buf);
+            bls::PublicKey::FromG1(&pk).Serialize(buf2);
+            if (memcmp(buf, buf2, BLS_CURVE_PUBKEY_SIZE) != 0) {
+                break;
+            }
+            g1_mul(pk, pk, r);
+            pubKeyVec.emplace_back(bls::PublicKey::FromG1(&pk));
+            hashes2.emplace_back(hashes[i].begin());
+        }
+
+        if (i == sigs.size()) {
+            g2_norm(aggSig, aggSig);
+            ret = bls::InsecureSignature::FromG2(&aggSig).Verify(hashes2, pubKeyVec);
+        }
+    } catch (...) {
+        ret = false;
+    }
+
+    bn_free(r);
+    g1_free(pk);
+    g2_free(sig);
+    g2_free(aggSig);
+    return ret;
+}
+
 bool CBLSSignature::VerifySecureAggregated(const std::vector<CBLSPublicKey>& pks, const uint256& hash) const
 {
     if (pks.empty()) {
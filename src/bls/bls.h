@@ -18,6 +18,7 @@
 #undef DOUBLE
 
 #include <array>
+#include <mutex>
 #include <unistd.h>
 
 // reversed BLS12-381
@@ -255,6 +256,9 @@ public:
 
     void AggregateInsecure(const CBLSPublicKey& o);
     static CBLSPublicKey AggregateInsecure(const std::vector<CBLSPublicKey>& pks);
+    // Aggregates with the same coefficients as CBLSSignature::AggregateSecure uses for signatures of the same message,
+    // so that sig.VerifyInsecure(AggregateSecure(pks), hash) is the same as sig.VerifySecureAggregated(pks, hash)
+    static CBLSPublicKey AggregateSecure(const std::vector<CBLSPublicKey>& pks);
 
     bool PublicKeyShare(const std::vector<CBLSPublicKey>& mpk, const CBLSId& id);
     bool DHKeyExchange(const CBLSSecretKey& sk, const CBLSPublicKey& pk);
@@ -285,6 +289,10 @@ public:
 
     bool VerifyInsecure(const CBLSPublicKey& pubKey, const uint256& hash) const;
     bool VerifyInsecureAggregated(const std::vector<CBLSPublicKey>& pubKeys, const std::vector<uint256>& hashes) const;
+    // Verifies independent sigs (sigs[i] signed hashes[i] with pubKeys[i]) with a single pairing check. Each sig and pubKey
+    // is multiplied with a random coefficient first, so that invalid sigs can't cancel each other out as they would in an
+    // insecure aggregation. Returns false if any of the sigs is invalid, without telling which one. All hashes must be different
+    static bool VerifyInsecureBatched(const std::vector<CBLSSignature>& sigs, const std::vector<CBLSPublicKey>& pubKeys, const std::vector<uint256>& hashes);
 
     bool VerifySecureAggregated(const std::vector<CBLSPublicKey>& pks, const uint256& hash) const;
 
@@ -295,6 +303,164 @@ protected:
     bool InternalGetBuf(void* buf) const;
 };
 
+// Keeps the serialized form of a BLS object and only deserializes it (which includes the expensive point
+// decompression) when the object is actually needed by Get(). Serialization, hashing and comparison work on the
+// serialized form, so objects which are loaded from disk and written back or compared never get deserialized
+// Unlike the eager types, an invalid or malleable serialized form results in an invalid object instead of an exception.
+// The serialized form itself is kept, so it is written back and hashed as it was read
+template <typename BLSObject>
+class CBLSLazyWrapper
+{
+private:
+    static const size_t SerSize = BLSObject::SerSize;
+
+    mutable std::mutex mutex;
+
+    mutable char buf[SerSize];
+    mutable bool bufValid{false};
+
+    mutable BLSObject obj;
+    mutable bool objInitialized{false};
+
+    mutable uint256 hash;
+
+public:
+    CBLSLazyWrapper()
+    {
+        // all zeros is the serialized form of an invalid object
+        memset(buf, 0, sizeof(buf));
+        bufValid = true;
+    }
+
+    CBLSLazyWrapper(const BLSObject& _obj)
+    {
+        Set(_obj);
+    }
+
+    CBLSLazyWrapper(const CBLSLazyWrapper& r)
+    {
+        *this = r;
+    }
+
+    CBLSLazyWrapper& operator=(const CBLSLazyWrapper& r)
+    {
+        if (this == &r) {
+            return *this;
+        }
+        std::unique_lock<std::mutex> l1(mutex, std::defer_lock);
+        std::unique_lock<std::mutex> l2(r.mutex, std::defer_lock);
+        std::lock(l1, l2);
+        memcpy(buf, r.buf, sizeof(buf));
+        bufValid = r.bufValid;
+        if (r.objInitialized) {
+            obj = r.obj;
+        } else {
+            obj.Reset();
+        }
+        objInitialized = r.objInitialized;
+        hash = r.hash;
+        return *this;
+    }
+
+    void Set(const BLSObject& _obj)
+    {
+        std::unique_lock<std::mutex> l(mutex);
+        bufValid = false;
+        obj = _obj;
+        objInitialized = true;
+        hash.SetNull();
+    }
+
+    const BLSObject& Get() const
+    {
+        std::unique_lock<std::mutex> l(mutex);
+        if (!objInitialized) {
+            obj.SetBuf(buf, sizeof(buf));
+            // same check as CBLSWrapper::Unserialize does
+            char buf2[SerSize];
+            obj.GetBuf(buf2, sizeof(buf2));
+            if (memcmp(buf, buf2, sizeof(buf)) != 0) {
+                // only the object is invalid, the serialized form (and thus the hash) stays what was read
+                obj.Reset();
+            }
+            objInitialized = true;
+        }
+        return obj;
+    }
+
+    bool operator==(const CBLSLazyWrapper& r) const
+    {
+        char buf1[SerSize];
+        char buf2[SerSize];
+        GetBuf(buf1);
+        r.GetBuf(buf2);
+        return memcmp(buf1, buf2, SerSize) == 0;
+    }
+
+    bool operator!=(const CBLSLazyWrapper& r) const
+    {
+        return !(*this == r);
+    }
+
+    template <typename Stream>
+    inline void Serialize(Stream& s) const
+    {
+        char buf2[SerSize];
+        GetBuf(buf2);
+        s.write(buf2, SerSize);
+    }
+
+    template <typename Stream>
+    inline void Unserialize(Stream& s)
+    {
+        std::unique_lock<std::mutex> l(mutex);
+        s.read(buf, SerSize);
+        bufValid = true;
+        obj.Reset();
+        objInitialized = false;
+        hash.SetNull();
+    }
+
+    // same as BLSObject::GetHash(), without deserializing the object
+    uint256 GetHash() const
+    {
+        std::unique_lock<std::mutex> l(mutex);
+        UpdateBuf();
+        if (hash.IsNull()) {
+            CHashWriter ss(SER_GETHASH, 0);
+            ss.write(buf, SerSize);
+            hash = ss.GetHash();
+        }
+        return hash;
+    }
+
+    std::string ToString() const
+    {
+        char buf2[SerSize];
+        GetBuf(buf2);
+        return HexStr((unsigned char*)buf2, (unsigned char*)buf2 + SerSize);
+    }
+
+private:
+    // mutex must be held
+    void UpdateBuf() const
+    {
+        if (!bufValid) {
+            obj.GetBuf(buf, sizeof(buf));
+            bufValid = true;
+            hash.SetNull();
+        }
+    }
+
+    void GetBuf(char* bufRet) const
+    {
+        std::unique_lock<std::mutex> l(mutex);
+        UpdateBuf();
+        memcpy(bufRet, buf, SerSize);
+    }
+};
+typedef CBLSLazyWrapper<CBLSPublicKey> CBLSLazyPublicKey;
+
 typedef std::vector<CBLSId> BLSIdVector;
 typedef std::vector<CBLSPublicKey> BLSVerificationVector;
 typedef std::vector<CBLSPublicKey> BLSPublicKeyVector;
@@ -4,10 +4,13 @@
 
 #include "bls_worker.h"
 #include "hash.h"
+#include "random.h"
 #include "serialize.h"
 
 #include "util.h"
 
+#include <atomic>
+
 template <typename T>
 bool VerifyVectorHelper(const std::vector<T>& vec, size_t start, size_t count)
 {
@@ -884,63 +887,200 @@ bool CBLSWorker::IsAsyncVerifyInProgress()
     return sigVerifyBatchesInProgress != 0;
 }
 
-// sigVerifyMutex must be held while calling
-void CBLSWorker::PushSigVerifyBatch()
+void CBLSWorker::AsyncVerifySecureAggregatedSig(const CBLSSignature& sig, const std::vector<CBLSPublicKey>& pubKeys, const uint256& msgHash,
+                                                CBLSWorker::SigVerifyDoneCallback doneCallback,
+                                                CBLSPubKeyAggregationCache* cache, const uint256& cacheKey)
 {
-    auto f = [this](int threadId, std::shared_ptr<std::vector<SigVerifyJob> > _jobs) {
-        auto& jobs = *_jobs;
-        if (jobs.size() == 1) {
-            auto& job = jobs[0];
-            if (!job.cancelCond()) {
-                bool valid = job.sig.VerifyInsecure(job.pubKey, job.msgHash);
-                job.doneCallback(valid);
-            }
-            std::unique_lock<std::mutex> l(sigVerifyMutex);
-            sigVerifyBatchesInProgress--;
-            if (!sigVerifyQueue.empty()) {
-                PushSigVerifyBatch();
-            }
+    if (!sig.IsValid() || pubKeys.empty()) {
+        doneCallback(false);
+        return;
+    }
+
+    if (cache == nullptr) {
+        workerPool.push([sig, pubKeys, msgHash, doneCallback](int threadId) {
+            doneCallback(sig.VerifySecureAggregated(pubKeys, msgHash));
+        });
+        return;
+    }
+
+    CBLSPublicKey aggPubKey;
+    if (cache->Get(cacheKey, aggPubKey)) {
+        AsyncVerifySig(sig, aggPubKey, msgHash, std::move(doneCallback));
+        return;
+    }
+
+    workerPool.push([sig, pubKeys, msgHash, doneCallback, cache, cacheKey](int threadId) {
+        CBLSPublicKey aggPubKey = pubKeys.size() == 1 ? pubKeys[0] : CBLSPublicKey::AggregateSecure(pubKeys);
+        if (!aggPubKey.IsValid()) {
+            doneCallback(false);
             return;
         }
+        cache->Put(cacheKey, aggPubKey);
+        doneCallback(sig.VerifyInsecure(aggPubKey, msgHash));
+    });
+}
 
-        CBLSSignature aggSig;
-        std::vector<size_t> indexes;
-        std::vector<CBLSPublicKey> pubKeys;
-        std::vector<uint256> msgHashes;
-        indexes.reserve(jobs.size());
-        pubKeys.reserve(jobs.size());
-        msgHashes.reserve(jobs.size());
-        for (size_t i = 0; i < jobs.size(); i++) {
-            auto& job = jobs[i];
-            if (job.cancelCond()) {
-                continue;
-            }
-            if (pubKeys.empty()) {
-                aggSig = job.sig;
-            } else {
-                aggSig.AggregateInsecure(job.sig);
-            }
-            indexes.emplace_back(i);
-            pubKeys.emplace_back(job.pubKey);
-            msgHashes.emplace_back(job.msgHash);
+std::future<bool> CBLSWorker::AsyncVerifySecureAggregatedSig(const CBLSSignature& sig, const std::vector<CBLSPublicKey>& pubKeys, const uint256& msgHash,
+                                                             CBLSPubKeyAggregationCache* cache, const uint256& cacheKey)
+{
+    auto p = BuildFutureDoneCallback2<bool>();
+    AsyncVerifySecureAggregatedSig(sig, pubKeys, msgHash, std::move(p.first), cache, cacheKey);
+    return std::move(p.second);
+}
+
+void CBLSWorker::VerifySigJobs(std::vector<SigVerifyJob>& jobs)
+{
+    if (jobs.size() == 1) {
+        auto& job = jobs[0];
+        if (!job.cancelCond()) {
+            bool valid = job.sig.VerifyInsecure(job.pubKey, job.msgHash);
+            job.doneCallback(valid);
         }
+        return;
+    }
 
-        if (!pubKeys.empty()) {
-            bool allValid = aggSig.VerifyInsecureAggregated(pubKeys, msgHashes);
-            if (allValid) {
-                for (size_t i = 0; i < pubKeys.size(); i++) {
-                    jobs[indexes[i]].doneCallback(true);
-                }
-            } else {
-                // one or more sigs were not valid, revert to per-sig verification
-                // TODO this could be improved if we would cache pairing results in some way as the previous aggregated verification already calculated all the pairings for the hashes
-                for (size_t i = 0; i < pubKeys.size(); i++) {
-                    auto& job = jobs[indexes[i]];
-                    bool valid = job.sig.VerifyInsecure(job.pubKey, job.msgHash);
-                    job.doneCallback(valid);
-                }
+    std::vector<size_t> indexes;
+    BLSSignatureVector sigs;
+    BLSPublicKeyVector pubKeys;
+    std::vector<uint256> msgHashes;
+    indexes.reserve(jobs.size());
+    sigs.reserve(jobs.size());
+    pubKeys.reserve(jobs.size());
+    msgHashes.reserve(jobs.size());
+    for (size_t i = 0; i < jobs.size(); i++) {
+        auto& job = jobs[i];
+        if (job.cancelCond()) {
+            continue;
+        }
+        indexes.emplace_back(i);
+        sigs.emplace_back(job.sig);
+        pubKeys.emplace_back(job.pubKey);
+        msgHashes.emplace_back(job.msgHash);
+    }
+
+    if (!indexes.empty()) {
+        VerifySigJobsRange(jobs, indexes, sigs, pubKeys, msgHashes, 0, indexes.size());
+    }
+}
+
+void CBLSWorker::VerifySigJobsRange(std::vector<SigVerifyJob>& jobs, const std::vector<size_t>& indexes,
+                                    const BLSSignatureVector& sigs, const BLSPublicKeyVector& pubKeys, const std::vector<uint256>& msgHashes,
+                                    size_t start, size_t count)
+{
+    if (count == 1) {
+        auto& job = jobs[indexes[start]];
+        bool valid = job.sig.VerifyInsecure(job.pubKey, job.msgHash);
+        job.doneCallback(valid);
+        return;
+    }
+
+    bool allValid = CBLSSignature::VerifyInsecureBatched(BLSSignatureVector(sigs.begin() + start, sigs.begin() + start + count),
+                                                         BLSPublicKeyVector(pubKeys.begin() + start, pubKeys.begin() + start + count),
+                                                         std::vector<uint256>(msgHashes.begin() + start, msgHashes.begin() + start + count));
+    if (allValid) {
+        for (size_t i = start; i < start + count; i++) {
+            jobs[indexes[i]].doneCallback(true);
+        }
+        return;
+    }
+
+    // one or more sigs were not valid, so we bisect until we found them. As long as only a few sigs are invalid, this
+    // needs far less pairings than verifying all sigs one by one
+    size_t half = count / 2;
+    VerifySigJobsRange(jobs, indexes, sigs, pubKeys, msgHashes, start, half);
+    VerifySigJobsRange(jobs, indexes, sigs, pubKeys, msgHashes, start + half, count - half);
+}
+
+void CBLSWorker::AsyncVerifySigBatch(const BLSSignatureVector& sigs, const BLSPublicKeyVector& pubKeys, const std::vector<uint256>& msgHashes,
+                                     size_t batchSize, std::function<void(const std::vector<bool>&)> doneCallback)
+{
+    assert(sigs.size() == pubKeys.size() && sigs.size() == msgHashes.size());
+    batchSize = std::max(batchSize, (size_t)1);
+
+    struct BatchState {
+        // not std::vector<bool>, as the batches write their results concurrently
+        std::vector<char> results;
+        std::atomic<size_t> pending;
+        std::function<void(const std::vector<bool>&)> doneCallback;
+
+        void Done(size_t count)
+        {
+            if (pending.fetch_sub(count) == count) {
+                doneCallback(std::vector<bool>(results.begin(), results.end()));
             }
         }
+    };
+    auto state = std::make_shared<BatchState>();
+    state->results.assign(sigs.size(), 0);
+    state->pending = sigs.size() + 1;
+    state->doneCallback = std::move(doneCallback);
+
+    // the order is randomized so that no one can predict which signatures end up in the same batch
+    std::vector<size_t> order;
+    order.reserve(sigs.size());
+    for (size_t i = 0; i < sigs.size(); i++) {
+        if (sigs[i].IsValid() && pubKeys[i].IsValid()) {
+            order.emplace_back(i);
+        }
+    }
+    FastRandomContext rng;
+    std::random_shuffle(order.begin(), order.end(), rng);
+
+    std::vector<std::vector<size_t> > batches;
+    std::vector<std::set<uint256> > batchHashes;
+    size_t firstOpenBatch = 0;
+    for (size_t i : order) {
+        size_t b = firstOpenBatch;
+        while (b < batches.size() && (batches[b].size() >= batchSize || batchHashes[b].count(msgHashes[i]))) {
+            b++;
+        }
+        if (b == batches.size()) {
+            batches.emplace_back();
+            batchHashes.emplace_back();
+            batches.back().reserve(batchSize);
+        }
+        batches[b].emplace_back(i);
+        batchHashes[b].emplace(msgHashes[i]);
+        while (firstOpenBatch < batches.size() && batches[firstOpenBatch].size() >= batchSize) {
+            firstOpenBatch++;
+        }
+    }
+
+    for (auto& batch : batches) {
+        auto jobs = std::make_shared<std::vector<SigVerifyJob> >();
+        jobs->reserve(batch.size());
+        for (size_t i : batch) {
+            jobs->emplace_back([state, i](bool valid) { state->results[i] = valid; }, [] { return false; }, sigs[i], pubKeys[i], msgHashes[i]);
+        }
+        workerPool.push([state, jobs](int threadId) {
+            VerifySigJobs(*jobs);
+            state->Done(jobs->size());
+        });
+    }
+
+    // invalid sigs and pubKeys never made it into a batch
+    state->Done(sigs.size() - order.size() + 1);
+}
+
+std::future<std::vector<bool> > CBLSWorker::AsyncVerifySigBatch(const BLSSignatureVector& sigs, const BLSPublicKeyVector& pubKeys, const std::vector<uint256>& msgHashes,
+                                                                size_t batchSize)
+{
+    auto p = BuildFutureDoneCallback<std::vector<bool> >();
+    AsyncVerifySigBatch(sigs, pubKeys, msgHashes, batchSize, std::move(p.first));
+    return std::move(p.second);
+}
+
+std::vector<bool> CBLSWorker::VerifySigBatch(const BLSSignatureVector& sigs, const BLSPublicKeyVector& pubKeys, const std::vector<uint256>& msgHashes,
+                                             size_t batchSize)
+{
+    return AsyncVerifySigBatch(sigs, pubKeys, msgHashes, batchSize).get();
+}
+
+// sigVerifyMutex must be held while calling
+void CBLSWorker::PushSigVerifyBatch()
+{
+    auto f = [this](int threadId, std::shared_ptr<std::vector<SigVerifyJob> > _jobs) {
+        VerifySigJobs(*_jobs);
 
         std::unique_lock<std::mutex> l(sigVerifyMutex);
         sigVerifyBatchesInProgress--;
@@ -955,3 +1095,47 @@ void CBLSWorker::PushSigVerifyBatch()
     sigVerifyBatchesInProgress++;
     workerPool.push(f, batch);
 }
+
+/////
+
+bool CBLSPubKeyAggregationCache::Get(const uint256& cacheKey, CBLSPublicKey& ret)
+{
+    std::unique_lock<std::mutex> l(cs);
+    auto it = entriesByKey.find(cacheKey);
+    if (it == entriesByKey.end()) {
+        misses++;
+        return false;
+    }
+    entries.splice(entries.begin(), entries, it->second);
+    ret = it->second->second;
+    hits++;
+    return true;
+}
+
+void CBLSPubKeyAggregationCache::Put(const uint256& cacheKey, const CBLSPublicKey& pubKey)
+{
+    std::unique_lock<std::mutex> l(cs);
+    if (maxEntries == 0 || entriesByKey.count(cacheKey)) {
+        return;
+    }
+    entries.emplace_front(cacheKey, pubKey);
+    entriesByKey.emplace(cacheKey, entries.begin());
+    while (entries.size() > maxEntries) {
+        entriesByKey.erase(entries.back().first);
+        entries.pop_back();
+        evictions++;
+    }
+}
+
+void CBLSPubKeyAggregationCache::Clear()
+{
+    std::unique_lock<std::mutex> l(cs);
+    entries.clear();
+    entriesByKey.clear();
+}
+
+size_t CBLSPubKeyAggregationCache::GetEntryCount()
+{
+    std::unique_lock<std::mutex> l(cs);
+    return entries.size();
+}
@@ -9,11 +9,47 @@
 
 #include "ctpl.h"
 
+#include <atomic>
 #include <future>
+#include <list>
+#include <map>
 #include <mutex>
 
 #include <boost/lockfree/queue.hpp>
 
+// Caches securely aggregated public keys (see CBLSPublicKey::AggregateSecure), so that verifying a signature of the
+// same set of signers again only needs a single pairing check instead of aggregating all public keys again. The
+// aggregated key is kept in its deserialized form, which is what the pairing check needs
+// Cache keys are provided externally and must commit to all aggregated public keys (not only to the set of members),
+// so that entries of changed member lists are never returned and simply age out of the cache
+class CBLSPubKeyAggregationCache
+{
+private:
+    std::mutex cs;
+    size_t maxEntries;
+    // most recently used entries first
+    std::list<std::pair<uint256, CBLSPublicKey> > entries;
+    std::map<uint256, std::list<std::pair<uint256, CBLSPublicKey> >::iterator> entriesByKey;
+
+    std::atomic<uint64_t> hits{0};
+    std::atomic<uint64_t> misses{0};
+    std::atomic<uint64_t> evictions{0};
+
+public:
+    explicit CBLSPubKeyAggregationCache(size_t _maxEntries) :
+        maxEntries(_maxEntries) {}
+
+    bool Get(const uint256& cacheKey, CBLSPublicKey& ret);
+    void Put(const uint256& cacheKey, const CBLSPublicKey& pubKey);
+    void Clear();
+
+    size_t GetEntryCount();
+    size_t GetMaxEntries() const { return maxEntries; }
+    uint64_t GetHits() const { return hits; }
+    uint64_t GetMisses() const { return misses; }
+    uint64_t GetEvictions() const { return evictions; }
+};
+
 // Low level BLS/DKG stuff. All very compute intensive and optimized for parallelization
 // The worker tries to parallelize as much as possible and utilizes a few properties of BLS aggregation to speed up things
 // For example, public key vectors can be aggregated in parallel if they are split into batches and the batched aggregations are
@@ -25,10 +61,12 @@ public:
     typedef std::function<void(bool)> SigVerifyDoneCallback;
     typedef std::function<bool()> CancelCond;
 
+public:
+    static const int SIG_VERIFY_BATCH_SIZE = 8;
+
 private:
     ctpl::thread_pool workerPool;
 
-    static const int SIG_VERIFY_BATCH_SIZE = 8;
     struct SigVerifyJob {
         SigVerifyDoneCallback doneCallback;
         CancelCond cancelCond;
@@ -138,8 +176,33 @@ public:
     std::future<bool> AsyncVerifySig(const CBLSSignature& sig, const CBLSPublicKey& pubKey, const uint256& msgHash, CancelCond cancelCond = [] { return false; });
     bool IsAsyncVerifyInProgress();
 
+    // Batched verification of many independent signatures (sigs[i] signed msgHashes[i] with pubKeys[i])
+    // The tuples are shuffled randomly and split into batches of batchSize (batches never contain the same msgHash twice).
+    // Each batch is verified with a single randomized pairing check (only one final exponentiation) and the batches are
+    // verified in parallel. If a batch fails, it is bisected to find the invalid signatures. The result has one entry per signature
+    void AsyncVerifySigBatch(const BLSSignatureVector& sigs, const BLSPublicKeyVector& pubKeys, const std::vector<uint256>& msgHashes,
+                             size_t batchSize, std::function<void(const std::vector<bool>&)> doneCallback);
+    std::future<std::vector<bool> > AsyncVerifySigBatch(const BLSSignatureVector& sigs, const BLSPublicKeyVector& pubKeys, const std::vector<uint256>& msgHashes,
+                                                        size_t batchSize);
+    std::vector<bool> VerifySigBatch(const BLSSignatureVector& sigs, const BLSPublicKeyVector& pubKeys, const std::vector<uint256>& msgHashes,
+                                     size_t batchSize = SIG_VERIFY_BATCH_SIZE);
+
+    // Verification of a securely aggregated signature (all pubKeys signed the same msgHash). The secure aggregation
+    // of the public keys is the expensive part, so this is done as a whole in the worker pool instead of the caller's thread
+    // If a cache is given, the aggregated public key is taken from/stored in the cache
+    void AsyncVerifySecureAggregatedSig(const CBLSSignature& sig, const std::vector<CBLSPublicKey>& pubKeys, const uint256& msgHash, SigVerifyDoneCallback doneCallback,
+                                        CBLSPubKeyAggregationCache* cache = nullptr, const uint256& cacheKey = uint256());
+    std::future<bool> AsyncVerifySecureAggregatedSig(const CBLSSignature& sig, const std::vector<CBLSPublicKey>& pubKeys, const uint256& msgHash,
+                                                     CBLSPubKeyAggregationCache* cache = nullptr, const uint256& cacheKey = uint256());
+
 private:
     void PushSigVerifyBatch();
+    // Verifies the not cancelled jobs with one batched pairing check (see CBLSSignature::VerifyInsecureBatched). If that
+    // fails, the jobs are split in halves and verified again, down to single sigs. All msgHashes must be different
+    static void VerifySigJobs(std::vector<SigVerifyJob>& jobs);
+    static void VerifySigJobsRange(std::vector<SigVerifyJob>& jobs, const std::vector<size_t>& indexes,
+                                   const BLSSignatureVector& sigs, const BLSPublicKeyVector& pubKeys, const std::vector<uint256>& msgHashes,
+                                   size_t start, size_t count);
 };
 
 // Builds and caches different things from CBLSWorker
@@ -11,10 +11,13 @@
 #include "hash.h"
 #include "memusage.h"
 #include "serialize.h"
+#include "support/allocators/pool.h"
 #include "uint256.h"
 
 #include <assert.h>
 #include <stdint.h>
+#include <functional>
+#include <memory>
 #include <unordered_map>
 
 /**
@@ -135,7 +138,19 @@ struct CCoinsCacheEntry
     explicit CCoinsCacheEntry(Coin&& coin_) : coin(std::move(coin_)), flags(0) {}
 };
 
-typedef std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher> CCoinsMap;
+/**
+ * CCoinsMap nodes are allocated from a PoolResource instead of one malloc per entry. This
+ * avoids the allocator's per-node overhead, keeps nodes which are inserted together close in
+ * memory and allows releasing the whole cache at once. The block size covers the node
+ * (key, value and next pointer) plus some room for the cached hash some implementations store.
+ */
+typedef PoolAllocator<std::pair<const COutPoint, CCoinsCacheEntry>,
+                      sizeof(std::pair<const COutPoint, CCoinsCacheEntry>) + sizeof(void*) * 4,
+                      alignof(void*)> CCoinsMapAllocator;
+
+typedef std::unordered_map<COutPoint, CCoinsCacheEntry, SaltedOutpointHasher, std::equal_to<COutPoint>, CCoinsMapAllocator> CCoinsMap;
+
+typedef CCoinsMapAllocator::ResourceType CCoinsMapMemoryResource;
 
 /** Cursor for iterating over CoinsView state */
 class CCoinsViewCursor
@@ -216,6 +231,8 @@ protected:
      * declared as "const".  
      */
     mutable uint256 hashBlock;
+    /* Backing memory of cacheCoins. Declared first so it outlives the map. */
+    mutable std::unique_ptr<CCoinsMapMemoryResource> cacheCoinsMemoryResource;
     mutable CCoinsMap cacheCoins;
 
     /* Cached dynamic memory usage for the inner Coin objects. */
@@ -279,6 +296,13 @@ public:
      */
     void Uncache(const COutPoint &outpoint);
 
+    /**
+     * Drop all entries and give the cache's memory back to the system. Unlike clear(), this
+     * also releases the pool chunks and the bucket array of cacheCoins. Only call this on a
+     * cache without unflushed changes.
+     */
+    void ReallocateCache();
+
     //! Calculate the size of the cache (in number of transaction outputs)
     unsigned int GetCacheSize() const;
 
@@ -221,8 +221,11 @@ public:
      * @param[in] fWipe       If true, remove all existing data.
      * @param[in] obfuscate   If true, store data obfuscated via simple XOR. If false, XOR
      *                        with a zero'd byte array.
+     * @param[in] fCompression      If true, let leveldb compress the table files.
+     * @param[in] nWriteBufferSize  Size of leveldb's write buffer, 0 to derive it from nCacheSize.
      */
-    CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false);
+    CDBWrapper(const boost::filesystem::path& path, size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool obfuscate = false,
+               bool fCompression = false, size_t nWriteBufferSize = 0);
     ~CDBWrapper();
 
     template <typename K, typename V>
@@ -15,6 +15,7 @@
 #endif // ENABLE_WALLET
 
 #include "evo/deterministicmns.h"
+#include "evo/simplifiedmns.h"
 
 #include "llmq/quorums_dummydkg.h"
 
@@ -36,6 +37,9 @@ void CDSNotificationInterface::NotifyHeaderTip(const CBlockIndex *pindexNew, boo
 
 void CDSNotificationInterface::UpdatedBlockTip(const CBlockIndex *pindexNew, const CBlockIndex *pindexFork, bool fInitialDownload)
 {
+    // must also see blocks being disconnected without any new ones
+    mnListDiffCache.UpdatedBlockTip(pindexNew, pindexFork, fInitialDownload);
+
     if (pindexNew == pindexFork) // blocks were disconnected without any new ones
         return;
 
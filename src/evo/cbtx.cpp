@@ -9,6 +9,8 @@
 
 #include "chainparams.h"
 #include "univalue.h"
+#include "util.h"
+#include "utiltime.h"
 #include "validation.h"
 
 bool CheckCbTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CValidationState& state)
@@ -64,18 +66,28 @@ bool CheckCbTxMerkleRootMNList(const CBlock& block, const CBlockIndex* pindex, C
 
 bool CalcCbTxMerkleRootMNList(const CBlock& block, const CBlockIndex* pindexPrev, uint256& merkleRootRet, CValidationState& state)
 {
+    static int64_t nTimeMerkle = 0;
+
     LOCK(deterministicMNManager->cs);
 
-    CDeterministicMNList tmpMNList;
-    if (!deterministicMNManager->BuildNewListFromBlock(block, pindexPrev, state, tmpMNList, false)) {
+    auto evaluation = deterministicMNManager->EvaluateBlock(block, pindexPrev, state, false);
+    if (!evaluation) {
         return false;
     }
 
-    CSimplifiedMNList sml(tmpMNList);
+    if (!evaluation->fMerkleRootCalculated) {
+        int64_t nTimeStart = GetTimeMicros();
+
+        evaluation->merkleRootMNList = deterministicMNManager->CalcSimplifiedMNListMerkleRoot(evaluation->mnList, &evaluation->fMerkleRootMutated);
+        evaluation->fMerkleRootCalculated = true;
+
+        int64_t nTime = GetTimeMicros() - nTimeStart;
+        nTimeMerkle += nTime;
+        LogPrint("bench", "        - CalcCbTxMerkleRootMNList: %.2fms [%.2fs]\n", 0.001 * nTime, nTimeMerkle * 0.000001);
+    }
 
-    bool mutated = false;
-    merkleRootRet = sml.CalcMerkleRoot(&mutated);
-    return !mutated;
+    merkleRootRet = evaluation->merkleRootMNList;
+    return !evaluation->fMerkleRootMutated;
 }
 
 std::string CCbTx::ToString() const
@@ -146,8 +146,10 @@ CDeterministicMNCPtr CDeterministicMNList::GetValidMN(const uint256& proTxHash)
 
 CDeterministicMNCPtr CDeterministicMNList::GetMNByOperatorKey(const CBLSPublicKey& pubKey)
 {
+    // compare the serialized forms, so that the operator keys of the list don't need to be deserialized
+    CBLSLazyPublicKey lazyPubKey(pubKey);
     for (const auto& p : mnMap) {
-        if (p.second->pdmnState->pubKeyOperator == pubKey) {
+        if (p.second->pdmnState->pubKeyOperator == lazyPubKey) {
             return p.second;
         }
     }
@@ -358,7 +360,8 @@ CSimplifiedMNListDiff CDeterministicMNList::BuildSimplifiedDiff(const CDetermini
         auto fromPtr = GetMN(toPtr->proTxHash);
         if (fromPtr == nullptr) {
             diffRet.mnList.emplace_back(*toPtr);
-        } else {
+        } else if (fromPtr->pdmnState != toPtr->pdmnState) {
+            // lists derived from each other share the state of unchanged MNs
             CSimplifiedMNListEntry sme1(*toPtr);
             CSimplifiedMNListEntry sme2(*fromPtr);
             if (sme1 != sme2) {
@@ -406,7 +409,7 @@ void CDeterministicMNList::AddMN(const CDeterministicMNCPtr& dmn)
         AddUniqueProperty(dmn, dmn->pdmnState->addr);
     }
     AddUniqueProperty(dmn, dmn->pdmnState->keyIDOwner);
-    if (dmn->pdmnState->pubKeyOperator.IsValid()) {
+    if (dmn->pdmnState->pubKeyOperator != CBLSLazyPublicKey()) {
         AddUniqueProperty(dmn, dmn->pdmnState->pubKeyOperator);
     }
 }
@@ -434,7 +437,7 @@ void CDeterministicMNList::RemoveMN(const uint256& proTxHash)
         DeleteUniqueProperty(dmn, dmn->pdmnState->addr);
     }
     DeleteUniqueProperty(dmn, dmn->pdmnState->keyIDOwner);
-    if (dmn->pdmnState->pubKeyOperator.IsValid()) {
+    if (dmn->pdmnState->pubKeyOperator != CBLSLazyPublicKey()) {
         DeleteUniqueProperty(dmn, dmn->pdmnState->pubKeyOperator);
     }
     mnMap = mnMap.erase(proTxHash);
@@ -458,11 +461,12 @@ bool CDeterministicMNManager::ProcessBlock(const CBlock& block, const CBlockInde
 
     int nHeight = pindex->nHeight;
 
-    CDeterministicMNList newList;
-    if (!BuildNewListFromBlock(block, pindex->pprev, _state, newList, true)) {
+    auto evaluation = EvaluateBlock(block, pindex->pprev, _state, true);
+    if (!evaluation) {
         return false;
     }
 
+    CDeterministicMNList newList = evaluation->mnList;
     if (newList.GetHeight() == -1) {
         newList.SetHeight(nHeight);
     }
@@ -498,6 +502,7 @@ bool CDeterministicMNManager::UndoBlock(const CBlock& block, const CBlockIndex*
     evoDb.Erase(std::make_pair(DB_LIST_DIFF, blockHash));
     evoDb.Erase(std::make_pair(DB_LIST_SNAPSHOT, blockHash));
     mnListsCache.erase(blockHash);
+    lastEvaluation.reset();
 
     if (nHeight == GetSpork15Value()) {
         LogPrintf("CDeterministicMNManager::%s -- spork15 is not active anymore. nHeight=%d\n", __func__, nHeight);
@@ -637,7 +642,7 @@ bool CDeterministicMNManager::BuildNewListFromBlock(const CBlock& block, const C
 
             if (newState->nPoSeBanHeight != -1) {
                 // only revive when all keys are set
-                if (newState->pubKeyOperator.IsValid() && !newState->keyIDVoting.IsNull() && !newState->keyIDOwner.IsNull()) {
+                if (newState->pubKeyOperator.Get().IsValid() && !newState->keyIDVoting.IsNull() && !newState->keyIDOwner.IsNull()) {
                     newState->nPoSePenalty = 0;
                     newState->nPoSeBanHeight = -1;
                     newState->nPoSeRevivedHeight = nHeight;
@@ -743,6 +748,82 @@ bool CDeterministicMNManager::BuildNewListFromBlock(const CBlock& block, const C
     return true;
 }
 
+CDeterministicMNListEvaluationPtr CDeterministicMNManager::EvaluateBlock(const CBlock& block, const CBlockIndex* pindexPrev, CValidationState& _state, bool debugLogs)
+{
+    AssertLockHeld(cs);
+
+    int64_t nTimeStart = GetTimeMicros();
+
+    CHashWriter hw(SER_GETHASH, 0);
+    for (size_t i = 1; i < block.vtx.size(); i++) {
+        hw << block.vtx[i]->GetHash();
+    }
+    uint256 txsHash = hw.GetHash();
+    const uint256& prevBlockHash = pindexPrev->GetBlockHash();
+
+    if (lastEvaluation && lastEvaluation->prevBlockHash == prevBlockHash && lastEvaluation->txsHash == txsHash &&
+        (lastEvaluation->fDebugLogs || !debugLogs)) {
+        nEvaluationsReused++;
+        LogPrint("bench", "        - Evaluate MN list: reused [%.2fs (%d built, %d reused)]\n",
+            nTimeEvaluate * 0.000001, nEvaluationsBuilt, nEvaluationsReused);
+        return lastEvaluation;
+    }
+
+    auto evaluation = std::make_shared<CDeterministicMNListEvaluation>();
+    evaluation->prevBlockHash = prevBlockHash;
+    evaluation->txsHash = txsHash;
+    evaluation->fDebugLogs = debugLogs;
+    if (!BuildNewListFromBlock(block, pindexPrev, _state, evaluation->mnList, debugLogs)) {
+        return nullptr;
+    }
+    lastEvaluation = evaluation;
+
+    int64_t nTime = GetTimeMicros() - nTimeStart;
+    nTimeEvaluate += nTime;
+    nEvaluationsBuilt++;
+    LogPrint("bench", "        - Evaluate MN list: %.2fms [%.2fs (%d built, %d reused)]\n",
+        0.001 * nTime, nTimeEvaluate * 0.000001, nEvaluationsBuilt, nEvaluationsReused);
+
+    return evaluation;
+}
+
+uint256 CDeterministicMNManager::CalcSimplifiedMNListMerkleRoot(const CDeterministicMNList& mnList, bool* pmutated)
+{
+    AssertLockHeld(cs);
+
+    if (!fSmlTreeInitialized) {
+        std::vector<std::pair<uint256, uint256>> vLeaves;
+        vLeaves.reserve(mnList.GetAllMNsCount());
+        mnList.ForEachMN(false, [&](const CDeterministicMNCPtr& dmn) {
+            vLeaves.emplace_back(dmn->proTxHash, CSimplifiedMNListEntry(*dmn).CalcHash());
+        });
+        std::sort(vLeaves.begin(), vLeaves.end());
+        smlTree.Build(std::move(vLeaves));
+        fSmlTreeInitialized = true;
+    } else {
+        // unchanged MNs share their state with the previous list, so only changed ones have to be rehashed
+        mnList.ForEachMN(false, [&](const CDeterministicMNCPtr& toPtr) {
+            auto fromPtr = smlTreeList.GetMN(toPtr->proTxHash);
+            if (fromPtr && fromPtr->pdmnState == toPtr->pdmnState) {
+                return;
+            }
+            CSimplifiedMNListEntry sme(*toPtr);
+            if (fromPtr && sme == CSimplifiedMNListEntry(*fromPtr)) {
+                return;
+            }
+            smlTree.Update(toPtr->proTxHash, sme.CalcHash());
+        });
+        smlTreeList.ForEachMN(false, [&](const CDeterministicMNCPtr& fromPtr) {
+            if (!mnList.HasMN(fromPtr->proTxHash)) {
+                smlTree.Remove(fromPtr->proTxHash);
+            }
+        });
+    }
+    smlTreeList = mnList;
+
+    return smlTree.CalcRoot(pmutated);
+}
+
 void CDeterministicMNManager::HandleQuorumCommitment(llmq::CFinalCommitment& qc, CDeterministicMNList& mnList, bool debugLogs)
 {
     // The commitment has already been validated at this point so it's safe to use members of it
@@ -44,7 +44,8 @@ public:
     uint256 confirmedHashWithProRegTxHash;
 
     CKeyID keyIDOwner;
-    CBLSPublicKey pubKeyOperator;
+    // lazy, as loading snapshots and diffs would otherwise decompress the key of every MN
+    CBLSLazyPublicKey pubKeyOperator;
     CKeyID keyIDVoting;
     CService addr;
     CScript scriptPayout;
@@ -448,6 +449,30 @@ public:
     }
 };
 
+/**
+ * The masternode list resulting from a block, evaluated once and shared by everything that needs it.
+ *
+ * Connecting a block built the new list in ProcessBlock and again for the cbtx merkle root check. Block
+ * assembly built it once more for the coinbase and then twice in TestBlockValidity. The manager now keeps
+ * the evaluation of the last block, keyed by the previous block and the hash of the block's transactions
+ * (the coinbase doesn't influence the list), and the cbtx code stores the merkle root of the simplified
+ * list next to it. Members must only be accessed while holding CDeterministicMNManager::cs.
+ */
+struct CDeterministicMNListEvaluation
+{
+    uint256 prevBlockHash;
+    uint256 txsHash;
+    //! Built with debug logs, so ProcessBlock does not have to build the list again to log the changes
+    bool fDebugLogs{false};
+    //! Does not contain the correct block hash, see BuildNewListFromBlock
+    CDeterministicMNList mnList;
+
+    bool fMerkleRootCalculated{false};
+    bool fMerkleRootMutated{false};
+    uint256 merkleRootMNList;
+};
+typedef std::shared_ptr<CDeterministicMNListEvaluation> CDeterministicMNListEvaluationPtr;
+
 class CDeterministicMNManager
 {
     static const int SNAPSHOT_LIST_PERIOD = 576; // once per day
@@ -463,6 +488,16 @@ private:
     int tipHeight{-1};
     uint256 tipBlockHash;
 
+    CDeterministicMNListEvaluationPtr lastEvaluation;
+    int64_t nTimeEvaluate{0};
+    uint64_t nEvaluationsBuilt{0};
+    uint64_t nEvaluationsReused{0};
+
+    // merkle tree of the simplified list of smlTreeList, see CalcSimplifiedMNListMerkleRoot
+    CSimplifiedMNListMerkleTree smlTree;
+    CDeterministicMNList smlTreeList;
+    bool fSmlTreeInitialized{false};
+
 public:
     CDeterministicMNManager(CEvoDB& _evoDb);
 
@@ -473,6 +508,10 @@ public:
 
     // the returned list will not contain the correct block hash (we can't know it yet as the coinbase TX is not updated yet)
     bool BuildNewListFromBlock(const CBlock& block, const CBlockIndex* pindexPrev, CValidationState& state, CDeterministicMNList& mnListRet, bool debugLogs);
+    // same as BuildNewListFromBlock, but reuses the evaluation of the last block if it matches. Returns nullptr on failure
+    CDeterministicMNListEvaluationPtr EvaluateBlock(const CBlock& block, const CBlockIndex* pindexPrev, CValidationState& state, bool debugLogs);
+    // same as CSimplifiedMNList(mnList).CalcMerkleRoot(), but only rehashes the entries which differ from the last list passed in
+    uint256 CalcSimplifiedMNListMerkleRoot(const CDeterministicMNList& mnList, bool* pmutated);
     void HandleQuorumCommitment(llmq::CFinalCommitment& qc, CDeterministicMNList& mnList, bool debugLogs);
     void DecreasePoSePenalties(CDeterministicMNList& mnList);
 
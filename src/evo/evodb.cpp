@@ -8,18 +8,30 @@ CEvoDB* evoDb;
 
 CEvoDB::CEvoDB(size_t nCacheSize, bool fMemory, bool fWipe) :
     db(fMemory ? "" : (GetDataDir() / "evodb"), nCacheSize, fMemory, fWipe),
-    rootBatch(db),
-    rootDBTransaction(db, rootBatch),
+    pendingBatch(db),
+    pendingDBTransaction(db, pendingBatch),
+    rootDBTransaction(pendingDBTransaction, pendingDBTransaction),
     curDBTransaction(rootDBTransaction, rootDBTransaction)
 {
 }
 
-bool CEvoDB::CommitRootTransaction()
+void CEvoDB::StageRootTransaction()
 {
+    LOCK(cs);
     assert(curDBTransaction.IsClean());
+    assert(pendingDBTransaction.IsClean());
     rootDBTransaction.Commit();
-    bool ret = db.WriteBatch(rootBatch);
-    rootBatch.Clear();
+}
+
+bool CEvoDB::CommitPendingTransaction()
+{
+    // May be called from the coins flush thread (-asynccoinsflush)
+    LOCK(cs);
+    if (pendingDBTransaction.IsClean())
+        return true;
+    pendingDBTransaction.Commit();
+    bool ret = db.WriteBatch(pendingBatch);
+    pendingBatch.Clear();
     return ret;
 }
 
@@ -17,11 +17,15 @@ private:
     CCriticalSection cs;
     CDBWrapper db;
 
-    typedef CDBTransaction<CDBWrapper, CDBBatch> RootTransaction;
+    // StageRootTransaction() moves the root transaction into pendingDBTransaction, which is
+    // only written to disk by CommitPendingTransaction() once the coins database has caught up
+    typedef CDBTransaction<CDBWrapper, CDBBatch> PendingTransaction;
+    typedef CDBTransaction<PendingTransaction, PendingTransaction> RootTransaction;
     typedef CDBTransaction<RootTransaction, RootTransaction> CurTransaction;
     typedef CScopedDBTransaction<RootTransaction, RootTransaction> ScopedTransaction;
 
-    CDBBatch rootBatch;
+    CDBBatch pendingBatch;
+    PendingTransaction pendingDBTransaction;
     RootTransaction rootDBTransaction;
     CurTransaction curDBTransaction;
 
@@ -68,7 +72,8 @@ public:
         return db;
     }
 
-    bool CommitRootTransaction();
+    void StageRootTransaction();
+    bool CommitPendingTransaction();
 
     bool VerifyBestBlock(const uint256& hash);
     void WriteBestBlock(const uint256& hash);
@@ -83,7 +83,17 @@ static bool CheckInputsHash(const CTransaction& tx, const ProTx& proTx, CValidat
     return true;
 }
 
-bool CheckProRegTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CValidationState& state)
+// Runs the check immediately, or defers it to pvChecks if given
+static bool RunOrDeferCheck(std::function<bool(CValidationState&)>&& check, CValidationState& state, std::vector<CSpecialTxCheck>* pvChecks)
+{
+    if (pvChecks) {
+        pvChecks->emplace_back(std::move(check));
+        return true;
+    }
+    return check(state);
+}
+
+bool CheckProRegTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CValidationState& state, std::vector<CSpecialTxCheck>* pvChecks)
 {
     if (tx.nType != TRANSACTION_PROVIDER_REGISTER) {
         return state.DoS(100, false, REJECT_INVALID, "bad-protx-type");
@@ -193,26 +203,26 @@ bool CheckProRegTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CValid
         }
     }
 
-    if (!CheckInputsHash(tx, ptx, state)) {
-        return false;
-    }
-
-    if (!keyForPayloadSig.IsNull()) {
-        // collateral is not part of this ProRegTx, so we must verify ownership of the collateral
-        if (!CheckStringSig(ptx, keyForPayloadSig, state)) {
-            return false;
-        }
-    } else {
+    if (keyForPayloadSig.IsNull()) {
         // collateral is part of this ProRegTx, so we know the collateral is owned by the issuer
         if (!ptx.vchSig.empty()) {
             return state.DoS(100, false, REJECT_INVALID, "bad-protx-sig");
         }
     }
 
-    return true;
+    return RunOrDeferCheck([&tx, ptx, keyForPayloadSig](CValidationState& state) {
+        if (!CheckInputsHash(tx, ptx, state)) {
+            return false;
+        }
+        // collateral is not part of this ProRegTx, so we must verify ownership of the collateral
+        if (!keyForPayloadSig.IsNull() && !CheckStringSig(ptx, keyForPayloadSig, state)) {
+            return false;
+        }
+        return true;
+    }, state, pvChecks);
 }
 
-bool CheckProUpServTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CValidationState& state)
+bool CheckProUpServTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CValidationState& state, std::vector<CSpecialTxCheck>* pvChecks)
 {
     if (tx.nType != TRANSACTION_PROVIDER_UPDATE_SERVICE) {
         return state.DoS(100, false, REJECT_INVALID, "bad-protx-type");
@@ -254,18 +264,16 @@ bool CheckProUpServTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CVa
         }
 
         // we can only check the signature if pindexPrev != NULL and the MN is known
-        if (!CheckInputsHash(tx, ptx, state)) {
-            return false;
-        }
-        if (!CheckHashSig(ptx, mn->pdmnState->pubKeyOperator, state)) {
-            return false;
-        }
+        CBLSPublicKey pubKeyOperator = mn->pdmnState->pubKeyOperator.Get();
+        return RunOrDeferCheck([&tx, ptx, pubKeyOperator](CValidationState& state) {
+            return CheckInputsHash(tx, ptx, state) && CheckHashSig(ptx, pubKeyOperator, state);
+        }, state, pvChecks);
     }
 
     return true;
 }
 
-bool CheckProUpRegTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CValidationState& state)
+bool CheckProUpRegTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CValidationState& state, std::vector<CSpecialTxCheck>* pvChecks)
 {
     if (tx.nType != TRANSACTION_PROVIDER_UPDATE_REGISTRAR) {
         return state.DoS(100, false, REJECT_INVALID, "bad-protx-type");
@@ -336,18 +344,16 @@ bool CheckProUpRegTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CVal
             }
         }
 
-        if (!CheckInputsHash(tx, ptx, state)) {
-            return false;
-        }
-        if (!CheckHashSig(ptx, dmn->pdmnState->keyIDOwner, state)) {
-            return false;
-        }
+        CKeyID keyIDOwner = dmn->pdmnState->keyIDOwner;
+        return RunOrDeferCheck([&tx, ptx, keyIDOwner](CValidationState& state) {
+            return CheckInputsHash(tx, ptx, state) && CheckHashSig(ptx, keyIDOwner, state);
+        }, state, pvChecks);
     }
 
     return true;
 }
 
-bool CheckProUpRevTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CValidationState& state)
+bool CheckProUpRevTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CValidationState& state, std::vector<CSpecialTxCheck>* pvChecks)
 {
     if (tx.nType != TRANSACTION_PROVIDER_UPDATE_REVOKE) {
         return state.DoS(100, false, REJECT_INVALID, "bad-protx-type");
@@ -374,10 +380,10 @@ bool CheckProUpRevTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CVal
         if (!dmn)
             return state.DoS(100, false, REJECT_INVALID, "bad-protx-hash");
 
-        if (!CheckInputsHash(tx, ptx, state))
-            return false;
-        if (!CheckHashSig(ptx, dmn->pdmnState->pubKeyOperator, state))
-            return false;
+        CBLSPublicKey pubKeyOperator = dmn->pdmnState->pubKeyOperator.Get();
+        return RunOrDeferCheck([&tx, ptx, pubKeyOperator](CValidationState& state) {
+            return CheckInputsHash(tx, ptx, state) && CheckHashSig(ptx, pubKeyOperator, state);
+        }, state, pvChecks);
     }
 
     return true;
@@ -11,8 +11,10 @@
 #include "base58.h"
 #include "chainparams.h"
 #include "consensus/merkle.h"
+#include "streams.h"
 #include "univalue.h"
 #include "validation.h"
+#include "version.h"
 
 CSimplifiedMNListEntry::CSimplifiedMNListEntry(const CDeterministicMN& dmn) :
     proRegTxHash(dmn.proTxHash),
@@ -81,6 +83,133 @@ uint256 CSimplifiedMNList::CalcMerkleRoot(bool* pmutated) const
     return ComputeMerkleRoot(leaves, pmutated);
 }
 
+void CSimplifiedMNListMerkleTree::Clear()
+{
+    keys.clear();
+    levels.clear();
+    mutatedNodes.clear();
+    dirtyLeaves.clear();
+    nDirtyFrom = NOT_DIRTY;
+}
+
+void CSimplifiedMNListMerkleTree::Build(std::vector<std::pair<uint256, uint256>> vLeaves)
+{
+    Clear();
+    levels.emplace_back();
+    keys.reserve(vLeaves.size());
+    levels[0].reserve(vLeaves.size());
+    for (const auto& p : vLeaves) {
+        assert(keys.empty() || keys.back() < p.first);
+        keys.emplace_back(p.first);
+        levels[0].emplace_back(p.second);
+    }
+    nDirtyFrom = 0;
+}
+
+void CSimplifiedMNListMerkleTree::Update(const uint256& key, const uint256& leafHash)
+{
+    if (levels.empty()) {
+        levels.emplace_back();
+    }
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    size_t nPos = it - keys.begin();
+    if (it != keys.end() && *it == key) {
+        if (levels[0][nPos] != leafHash) {
+            levels[0][nPos] = leafHash;
+            dirtyLeaves.emplace(nPos);
+        }
+        return;
+    }
+    keys.insert(it, key);
+    levels[0].insert(levels[0].begin() + nPos, leafHash);
+    nDirtyFrom = std::min(nDirtyFrom, nPos);
+}
+
+void CSimplifiedMNListMerkleTree::Remove(const uint256& key)
+{
+    auto it = std::lower_bound(keys.begin(), keys.end(), key);
+    if (it == keys.end() || *it != key) {
+        return;
+    }
+    size_t nPos = it - keys.begin();
+    keys.erase(it);
+    levels[0].erase(levels[0].begin() + nPos);
+    nDirtyFrom = std::min(nDirtyFrom, nPos);
+}
+
+uint256 CSimplifiedMNListMerkleTree::CalcRoot(bool* pmutated)
+{
+    const size_t nLeaves = keys.size();
+    if (nLeaves == 0) {
+        levels.clear();
+        mutatedNodes.clear();
+        dirtyLeaves.clear();
+        nDirtyFrom = NOT_DIRTY;
+        if (pmutated) *pmutated = false;
+        return uint256();
+    }
+
+    // the leaves behind nDirtyFrom are rehashed anyway, and their positions may have changed
+    std::set<size_t> dirty(dirtyLeaves.begin(), dirtyLeaves.lower_bound(nDirtyFrom));
+    size_t nFrom = nDirtyFrom;
+    dirtyLeaves.clear();
+    nDirtyFrom = NOT_DIRTY;
+
+    size_t nLevel = 0;
+    for (; levels[nLevel].size() > 1; nLevel++) {
+        if (levels.size() == nLevel + 1) {
+            levels.emplace_back();
+            // a new level always needs all of its nodes
+            nFrom = 0;
+        }
+        const std::vector<uint256>& cur = levels[nLevel];
+        std::vector<uint256>& next = levels[nLevel + 1];
+        size_t nNextSize = (cur.size() + 1) / 2;
+        if (next.size() != nNextSize) {
+            nFrom = std::min(nFrom, std::min(next.size(), nNextSize) * 2);
+            next.resize(nNextSize);
+        }
+
+        std::set<size_t> nextDirty;
+        for (size_t i : dirty) {
+            nextDirty.emplace(i / 2);
+        }
+        size_t nNextFrom = nFrom == NOT_DIRTY ? NOT_DIRTY : nFrom / 2;
+        if (nNextFrom != NOT_DIRTY) {
+            mutatedNodes.erase(mutatedNodes.lower_bound(std::make_pair(nLevel, nNextFrom)), mutatedNodes.lower_bound(std::make_pair(nLevel + 1, (size_t)0)));
+            nextDirty.erase(nextDirty.lower_bound(nNextFrom), nextDirty.end());
+        }
+
+        // a node only counts as mutated if both children are complete subtrees, see MerkleComputation
+        auto hashNode = [&](size_t j) {
+            const uint256& left = cur[2 * j];
+            const uint256& right = 2 * j + 1 < cur.size() ? cur[2 * j + 1] : left;
+            if (((2 * j + 2) << nLevel) <= nLeaves && left == right) {
+                mutatedNodes.emplace(nLevel, j);
+            } else {
+                mutatedNodes.erase(std::make_pair(nLevel, j));
+            }
+            next[j] = Hash(left.begin(), left.end(), right.begin(), right.end());
+        };
+        for (size_t j : nextDirty) {
+            hashNode(j);
+        }
+        if (nNextFrom != NOT_DIRTY) {
+            for (size_t j = nNextFrom; j < nNextSize; j++) {
+                hashNode(j);
+            }
+        }
+
+        dirty = std::move(nextDirty);
+        nFrom = nNextFrom;
+    }
+    levels.resize(nLevel + 1);
+    mutatedNodes.erase(mutatedNodes.lower_bound(std::make_pair(nLevel, (size_t)0)), mutatedNodes.end());
+
+    if (pmutated) *pmutated = !mutatedNodes.empty();
+    return levels[nLevel][0];
+}
+
 void CSimplifiedMNListDiff::ToJson(UniValue& obj) const
 {
     obj.setObject();
@@ -169,3 +298,194 @@ bool BuildSimplifiedMNListDiff(const uint256& baseBlockHash, const uint256& bloc
 
     return true;
 }
+
+CSimplifiedMNListDiffCache mnListDiffCache;
+
+bool CSimplifiedMNListDiffCache::Build(const uint256& baseBlockHash, const uint256& blockHash, Payload& payloadRet, int& nHeightRet, std::string& errorRet)
+{
+    AssertLockHeld(cs_main);
+
+    CSimplifiedMNListDiff mnListDiff;
+    if (!BuildSimplifiedMNListDiff(baseBlockHash, blockHash, mnListDiff, errorRet)) {
+        return false;
+    }
+
+    auto vData = std::make_shared<std::vector<unsigned char>>();
+    CVectorWriter(SER_NETWORK, PROTOCOL_VERSION, *vData, 0, mnListDiff);
+    payloadRet = std::move(vData);
+    // BuildSimplifiedMNListDiff succeeded, so the block is known
+    nHeightRet = mapBlockIndex.at(blockHash)->nHeight;
+    return true;
+}
+
+void CSimplifiedMNListDiffCache::Insert(const uint256& baseBlockHash, const uint256& blockHash, int nHeight, const Payload& payload, uint64_t nRequests)
+{
+    AssertLockHeld(cs);
+
+    if (payload->size() > nMaxSize) {
+        return;
+    }
+
+    auto key = std::make_pair(baseBlockHash, blockHash);
+    auto it = mapEntries.find(key);
+    if (it != mapEntries.end()) {
+        // built concurrently by someone else
+        it->second->nRequests += nRequests;
+        return;
+    }
+
+    entries.push_front(Entry{key, nHeight, payload, nRequests});
+    mapEntries.emplace(key, entries.begin());
+    nSize += payload->size();
+
+    while (nSize > nMaxSize) {
+        Erase(std::prev(entries.end()));
+        nEvicted++;
+    }
+}
+
+void CSimplifiedMNListDiffCache::Erase(EntryList::iterator it)
+{
+    AssertLockHeld(cs);
+
+    nSize -= it->payload->size();
+    mapEntries.erase(it->key);
+    entries.erase(it);
+}
+
+void CSimplifiedMNListDiffCache::SetMaxSize(size_t nMaxSizeIn)
+{
+    LOCK(cs);
+
+    nMaxSize = nMaxSizeIn;
+    while (nSize > nMaxSize) {
+        Erase(std::prev(entries.end()));
+        nEvicted++;
+    }
+}
+
+void CSimplifiedMNListDiffCache::Clear()
+{
+    LOCK(cs);
+
+    entries.clear();
+    mapEntries.clear();
+    nSize = 0;
+    vPrecomputeBases.clear();
+}
+
+bool CSimplifiedMNListDiffCache::GetDiff(const uint256& baseBlockHash, const uint256& blockHash, Payload& payloadRet, std::string& errorRet)
+{
+    AssertLockHeld(cs_main);
+
+    {
+        LOCK(cs);
+        auto it = mapEntries.find(std::make_pair(baseBlockHash, blockHash));
+        if (it != mapEntries.end()) {
+            // the block might have been disconnected without UpdatedBlockTip being called yet. The base block is
+            // an ancestor of the block, so it's still in the active chain if the block is
+            auto blockIt = mapBlockIndex.find(blockHash);
+            if (blockIt != mapBlockIndex.end() && chainActive.Contains(blockIt->second)) {
+                it->second->nRequests++;
+                entries.splice(entries.begin(), entries, it->second);
+                payloadRet = it->second->payload;
+                nHits++;
+                return true;
+            }
+            Erase(it->second);
+        }
+        nMisses++;
+    }
+
+    int nHeight;
+    if (!Build(baseBlockHash, blockHash, payloadRet, nHeight, errorRet)) {
+        return false;
+    }
+
+    LOCK(cs);
+    Insert(baseBlockHash, blockHash, nHeight, payloadRet, 1);
+    return true;
+}
+
+void CSimplifiedMNListDiffCache::UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload)
+{
+    uint256 newTipBlockHash = pindexNew->GetBlockHash();
+
+    LOCK(cs);
+
+    // entries are only valid as long as their block is part of the active chain
+    for (auto it = entries.begin(); it != entries.end(); ) {
+        if (pindexFork == nullptr || it->nHeight > pindexFork->nHeight) {
+            Erase(it++);
+        } else {
+            ++it;
+        }
+    }
+
+    // clients which asked for a diff to the previous tip will most likely ask for the same diff to the new tip
+    vPrecomputeBases.clear();
+    if (!fInitialDownload && pindexNew != pindexFork && !tipBlockHash.IsNull()) {
+        std::vector<const Entry*> vPopular;
+        for (const auto& e : entries) {
+            if (e.key.second == tipBlockHash && e.nRequests > 0 && !mapEntries.count(std::make_pair(e.key.first, newTipBlockHash))) {
+                vPopular.emplace_back(&e);
+            }
+        }
+        std::sort(vPopular.begin(), vPopular.end(), [](const Entry* a, const Entry* b) {
+            return a->nRequests > b->nRequests;
+        });
+        for (size_t i = 0; i < vPopular.size() && i < MAX_PRECOMPUTE; i++) {
+            vPrecomputeBases.emplace_back(vPopular[i]->key.first);
+        }
+    }
+    precomputeBlockHash = newTipBlockHash;
+    tipBlockHash = newTipBlockHash;
+}
+
+void CSimplifiedMNListDiffCache::PrecomputeDiffs()
+{
+    std::vector<uint256> vBaseBlockHashes;
+    uint256 blockHash;
+    {
+        LOCK(cs);
+        vBaseBlockHashes.swap(vPrecomputeBases);
+        blockHash = precomputeBlockHash;
+    }
+
+    if (vBaseBlockHashes.empty()) {
+        return;
+    }
+
+    LOCK(cs_main);
+    for (const auto& baseBlockHash : vBaseBlockHashes) {
+        // a newer tip has its own list already, don't hold cs_main for diffs nobody will ask for anymore
+        if (chainActive.Tip() == nullptr || chainActive.Tip()->GetBlockHash() != blockHash) {
+            return;
+        }
+        Payload payload;
+        int nHeight;
+        std::string strError;
+        if (!Build(baseBlockHash, blockHash, payload, nHeight, strError)) {
+            LogPrint("net", "CSimplifiedMNListDiffCache::%s -- precomputing diff failed for baseBlockHash=%s, blockHash=%s. error=%s\n", __func__,
+                baseBlockHash.ToString(), blockHash.ToString(), strError);
+            continue;
+        }
+        LOCK(cs);
+        Insert(baseBlockHash, blockHash, nHeight, payload, 0);
+        nPrecomputed++;
+    }
+}
+
+void CSimplifiedMNListDiffCache::ToJson(UniValue& obj) const
+{
+    LOCK(cs);
+
+    obj.setObject();
+    obj.push_back(Pair("entries", (uint64_t)entries.size()));
+    obj.push_back(Pair("size", (uint64_t)nSize));
+    obj.push_back(Pair("maxsize", (uint64_t)nMaxSize));
+    obj.push_back(Pair("hits", nHits));
+    obj.push_back(Pair("misses", nMisses));
+    obj.push_back(Pair("precomputed", nPrecomputed));
+    obj.push_back(Pair("evicted", nEvicted));
+}
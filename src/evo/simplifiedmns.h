@@ -10,8 +10,15 @@
 #include "netaddress.h"
 #include "pubkey.h"
 #include "serialize.h"
+#include "sync.h"
+
+#include <list>
+#include <map>
+#include <memory>
+#include <set>
 
 class UniValue;
+class CBlockIndex;
 class CDeterministicMNList;
 class CDeterministicMN;
 
@@ -21,7 +28,7 @@ public:
     uint256 proRegTxHash;
     uint256 confirmedHash;
     CService service;
-    CBLSPublicKey pubKeyOperator;
+    CBLSLazyPublicKey pubKeyOperator;
     CKeyID keyIDVoting;
     bool isValid;
 
@@ -78,6 +85,45 @@ public:
     uint256 CalcMerkleRoot(bool* pmutated = NULL) const;
 };
 
+/**
+ * Merkle tree over the leaf hashes of a simplified MN list (sorted by proRegTxHash) which is updated
+ * in place instead of being recomputed from scratch.
+ *
+ * All levels of the tree are kept. Changing an entry only rehashes its path to the root, so the few
+ * entries changing per block cost O(log n) hashes each. Adding or removing an entry shifts all entries
+ * behind it, which requires rehashing the right part of the tree (still far less than rehashing all
+ * entries). Changes are collected and applied by CalcRoot. The root and the mutation flag are the
+ * same as the ones calculated by ComputeMerkleRoot over the sorted leaf hashes.
+ */
+class CSimplifiedMNListMerkleTree
+{
+private:
+    static const size_t NOT_DIRTY = (size_t)-1;
+
+    std::vector<uint256> keys;
+    //! levels[0] are the leaf hashes, the last level holds the root
+    std::vector<std::vector<uint256>> levels;
+    //! Nodes (level, index) whose children are equal, see ComputeMerkleRoot
+    std::set<std::pair<size_t, size_t>> mutatedNodes;
+
+    //! Leaves which changed in place
+    std::set<size_t> dirtyLeaves;
+    //! All leaves from this position on moved or changed
+    size_t nDirtyFrom{NOT_DIRTY};
+
+public:
+    void Clear();
+    //! Replace the whole tree, leaves must be sorted by key
+    void Build(std::vector<std::pair<uint256, uint256>> vLeaves);
+    //! Add a leaf or change the hash of an existing one
+    void Update(const uint256& key, const uint256& leafHash);
+    void Remove(const uint256& key);
+
+    uint256 CalcRoot(bool* pmutated = NULL);
+
+    size_t size() const { return keys.size(); }
+};
+
 /// P2P messages
 
 class CGetSimplifiedMNListDiff
@@ -127,4 +173,77 @@ public:
 
 bool BuildSimplifiedMNListDiff(const uint256& baseBlockHash, const uint256& blockHash, CSimplifiedMNListDiff& mnListDiffRet, std::string& errorRet);
 
+//! -mnlistdiffcachesize default, in MiB
+static const unsigned int DEFAULT_MNLISTDIFF_CACHE_SIZE = 16;
+
+/**
+ * LRU cache of serialized mnlistdiff messages, keyed by (baseBlockHash, blockHash).
+ *
+ * SPV clients mostly ask for the same few diffs (from the genesis block or from the block they've seen
+ * last up to the tip), so each diff is only built once and the serialized message is sent to all peers
+ * asking for it. Entries of disconnected blocks are removed on reorgs. When a new tip arrives, the diffs
+ * to the new tip from the most requested base blocks of the previous tip are built in advance.
+ */
+class CSimplifiedMNListDiffCache
+{
+public:
+    typedef std::shared_ptr<const std::vector<unsigned char>> Payload;
+
+private:
+    //! Max. number of diffs built in advance per new tip
+    static const size_t MAX_PRECOMPUTE = 4;
+
+    struct Entry
+    {
+        std::pair<uint256, uint256> key;
+        int nHeight;
+        Payload payload;
+        uint64_t nRequests;
+    };
+    typedef std::list<Entry> EntryList;
+
+    mutable CCriticalSection cs;
+    //! Most recently used entries first
+    EntryList entries;
+    std::map<std::pair<uint256, uint256>, EntryList::iterator> mapEntries;
+    size_t nMaxSize{DEFAULT_MNLISTDIFF_CACHE_SIZE * 1024 * 1024};
+    size_t nSize{0};
+    uint256 tipBlockHash;
+    //! Diffs to build in advance by PrecomputeDiffs(): the base blocks and the tip they were picked for
+    std::vector<uint256> vPrecomputeBases;
+    uint256 precomputeBlockHash;
+
+    uint64_t nHits{0};
+    uint64_t nMisses{0};
+    uint64_t nPrecomputed{0};
+    uint64_t nEvicted{0};
+
+    bool Build(const uint256& baseBlockHash, const uint256& blockHash, Payload& payloadRet, int& nHeightRet, std::string& errorRet);
+    void Insert(const uint256& baseBlockHash, const uint256& blockHash, int nHeight, const Payload& payload, uint64_t nRequests);
+    void Erase(EntryList::iterator it);
+
+public:
+    //! 0 disables caching
+    void SetMaxSize(size_t nMaxSizeIn);
+    void Clear();
+
+    /**
+     * Returns the serialized diff from the cache or builds (and caches) it.
+     * Same as BuildSimplifiedMNListDiff, cs_main must be held.
+     */
+    bool GetDiff(const uint256& baseBlockHash, const uint256& blockHash, Payload& payloadRet, std::string& errorRet);
+
+    /**
+     * Removes the entries of disconnected blocks and picks the popular diffs to build for the new tip.
+     * Building them is left to PrecomputeDiffs(), so this doesn't hold up the validation callbacks.
+     */
+    void UpdatedBlockTip(const CBlockIndex* pindexNew, const CBlockIndex* pindexFork, bool fInitialDownload);
+    //! Builds the diffs picked by the last UpdatedBlockTip call, unless the tip changed again in the meantime
+    void PrecomputeDiffs();
+
+    void ToJson(UniValue& obj) const;
+};
+
+extern CSimplifiedMNListDiffCache mnListDiffCache;
+
 #endif //DASH_SIMPLIFIEDMNS_H
@@ -8,6 +8,8 @@
 #include "hash.h"
 #include "primitives/block.h"
 #include "primitives/transaction.h"
+#include "util.h"
+#include "utiltime.h"
 #include "validation.h"
 
 #include "cbtx.h"
@@ -17,7 +19,13 @@
 #include "llmq/quorums_commitment.h"
 #include "llmq/quorums_blockprocessor.h"
 
-bool CheckSpecialTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CValidationState& state)
+bool CSpecialTxCheck::operator()()
+{
+    CValidationState state;
+    return check(state);
+}
+
+bool CheckSpecialTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CValidationState& state, std::vector<CSpecialTxCheck>* pvChecks)
 {
     if (tx.nVersion != 3 || tx.nType == TRANSACTION_NORMAL)
         return true;
@@ -28,13 +36,13 @@ bool CheckSpecialTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CVali
 
     switch (tx.nType) {
     case TRANSACTION_PROVIDER_REGISTER:
-        return CheckProRegTx(tx, pindexPrev, state);
+        return CheckProRegTx(tx, pindexPrev, state, pvChecks);
     case TRANSACTION_PROVIDER_UPDATE_SERVICE:
-        return CheckProUpServTx(tx, pindexPrev, state);
+        return CheckProUpServTx(tx, pindexPrev, state, pvChecks);
     case TRANSACTION_PROVIDER_UPDATE_REGISTRAR:
-        return CheckProUpRegTx(tx, pindexPrev, state);
+        return CheckProUpRegTx(tx, pindexPrev, state, pvChecks);
     case TRANSACTION_PROVIDER_UPDATE_REVOKE:
-        return CheckProUpRevTx(tx, pindexPrev, state);
+        return CheckProUpRevTx(tx, pindexPrev, state, pvChecks);
     case TRANSACTION_COINBASE:
         return CheckCbTx(tx, pindexPrev, state);
     case TRANSACTION_QUORUM_COMMITMENT:
@@ -86,11 +94,18 @@ bool UndoSpecialTx(const CTransaction& tx, const CBlockIndex* pindex)
     return false;
 }
 
-bool ProcessSpecialTxsInBlock(const CBlock& block, const CBlockIndex* pindex, CValidationState& state)
+bool ProcessSpecialTxsInBlock(const CBlock& block, const CBlockIndex* pindex, CValidationState& state, bool fCheckSpecialTxs)
 {
+    static int64_t nTimeLoop = 0;
+    static int64_t nTimeQuorum = 0;
+    static int64_t nTimeDMN = 0;
+    static int64_t nTimeMerkle = 0;
+
+    int64_t nTime1 = GetTimeMicros();
+
     for (int i = 0; i < (int)block.vtx.size(); i++) {
         const CTransaction& tx = *block.vtx[i];
-        if (!CheckSpecialTx(tx, pindex->pprev, state)) {
+        if (fCheckSpecialTxs && !CheckSpecialTx(tx, pindex->pprev, state)) {
             return false;
         }
         if (!ProcessSpecialTx(tx, pindex, state)) {
@@ -98,18 +113,31 @@ bool ProcessSpecialTxsInBlock(const CBlock& block, const CBlockIndex* pindex, CV
         }
     }
 
+    int64_t nTime2 = GetTimeMicros(); nTimeLoop += nTime2 - nTime1;
+    LogPrint("bench", "      - Loop: %.2fms [%.2fs]\n", 0.001 * (nTime2 - nTime1), nTimeLoop * 0.000001);
+
     if (!llmq::quorumBlockProcessor->ProcessBlock(block, pindex, state)) {
         return false;
     }
 
+    int64_t nTime3 = GetTimeMicros(); nTimeQuorum += nTime3 - nTime2;
+    LogPrint("bench", "      - quorumBlockProcessor: %.2fms [%.2fs]\n", 0.001 * (nTime3 - nTime2), nTimeQuorum * 0.000001);
+
     if (!deterministicMNManager->ProcessBlock(block, pindex, state)) {
         return false;
     }
 
+    int64_t nTime4 = GetTimeMicros(); nTimeDMN += nTime4 - nTime3;
+    LogPrint("bench", "      - deterministicMNManager: %.2fms [%.2fs]\n", 0.001 * (nTime4 - nTime3), nTimeDMN * 0.000001);
+
+    // reuses the list evaluated by deterministicMNManager->ProcessBlock
     if (!CheckCbTxMerkleRootMNList(block, pindex, state)) {
         return false;
     }
 
+    int64_t nTime5 = GetTimeMicros(); nTimeMerkle += nTime5 - nTime4;
+    LogPrint("bench", "      - CheckCbTxMerkleRootMNList: %.2fms [%.2fs]\n", 0.001 * (nTime5 - nTime4), nTimeMerkle * 0.000001);
+
     return true;
 }
 
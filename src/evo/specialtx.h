@@ -9,12 +9,38 @@
 #include "streams.h"
 #include "version.h"
 
+#include <functional>
+
 class CBlock;
 class CBlockIndex;
 class CValidationState;
 
-bool CheckSpecialTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CValidationState& state);
-bool ProcessSpecialTxsInBlock(const CBlock& block, const CBlockIndex* pindex, CValidationState& state);
+/**
+ * Closure representing the context-free part of a special tx check (signatures and inputs hash), so that it can be
+ * run in a CCheckQueue. Only success or failure is reported, the reject reason is lost.
+ * Note that this may store references to the checked transaction
+ */
+class CSpecialTxCheck
+{
+private:
+    std::function<bool(CValidationState&)> check;
+
+public:
+    CSpecialTxCheck() {}
+    explicit CSpecialTxCheck(std::function<bool(CValidationState&)>&& _check) : check(std::move(_check)) {}
+
+    bool operator()();
+
+    void swap(CSpecialTxCheck& other)
+    {
+        check.swap(other.check);
+    }
+};
+
+// If pvChecks is not null, the signature and inputs hash checks are not performed but appended to pvChecks instead
+bool CheckSpecialTx(const CTransaction& tx, const CBlockIndex* pindexPrev, CValidationState& state, std::vector<CSpecialTxCheck>* pvChecks = nullptr);
+// fCheckSpecialTxs can be false if CheckSpecialTx was already called for all txs of the block
+bool ProcessSpecialTxsInBlock(const CBlock& block, const CBlockIndex* pindex, CValidationState& state, bool fCheckSpecialTxs = true);
 bool UndoSpecialTxsInBlock(const CBlock& block, const CBlockIndex* pindex);
 
 template <typename T>
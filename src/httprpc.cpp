@@ -147,6 +147,38 @@ static bool RPCAuthorized(const std::string& strAuth, std::string& strAuthUserna
     return multiUserAuthorized(strUserPass);
 }
 
+/** Requests with larger bodies are classified as heavy without looking at them */
+static const size_t MAX_CLASSIFY_BODY_SIZE = 1024 * 1024;
+
+static HTTPWorkClass HTTPClassify_JSONRPC(HTTPRequest* req, const std::string &)
+{
+    // Requests which are going to be rejected right away are cheap
+    if (req->GetRequestMethod() != HTTPRequest::POST || !req->GetHeader("authorization").first)
+        return HTTP_WORK_CHEAP;
+
+    std::string strBody = req->ReadBody(false);
+    if (strBody.size() > MAX_CLASSIFY_BODY_SIZE)
+        return HTTP_WORK_HEAVY;
+    UniValue valRequest;
+    if (!valRequest.read(strBody))
+        return HTTP_WORK_CHEAP;
+
+    if (valRequest.isObject()) {
+        const UniValue& method = find_value(valRequest, "method");
+        return method.isStr() ? GetRPCWorkClass(method.get_str()) : HTTP_WORK_CHEAP;
+    }
+    // A batch is as expensive as its most expensive call
+    HTTPWorkClass workClass = HTTP_WORK_CHEAP;
+    if (valRequest.isArray()) {
+        for (size_t i = 0; i < valRequest.size(); i++) {
+            const UniValue& method = valRequest[i].isObject() ? find_value(valRequest[i], "method") : NullUniValue;
+            if (method.isStr())
+                workClass = std::max(workClass, GetRPCWorkClass(method.get_str()));
+        }
+    }
+    return workClass;
+}
+
 static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
 {
     // JSONRPC handles only POST
@@ -189,6 +221,7 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
         // singleton request
         if (valRequest.isObject()) {
             jreq.parse(valRequest);
+            RecordRPCQueueTime(jreq.strMethod, req->GetQueueTime());
 
             UniValue result = tableRPC.execute(jreq);
 
@@ -196,9 +229,15 @@ static bool HTTPReq_JSONRPC(HTTPRequest* req, const std::string &)
             strReply = JSONRPCReply(result, NullUniValue, jreq.id);
 
         // array of requests
-        } else if (valRequest.isArray())
+        } else if (valRequest.isArray()) {
+            // every call of the batch waited just as long
+            for (size_t i = 0; i < valRequest.size(); i++) {
+                const UniValue& method = valRequest[i].isObject() ? find_value(valRequest[i], "method") : NullUniValue;
+                if (method.isStr())
+                    RecordRPCQueueTime(method.get_str(), req->GetQueueTime());
+            }
             strReply = JSONRPCExecBatch(valRequest.get_array());
-        else
+        } else
             throw JSONRPCError(RPC_PARSE_ERROR, "Top-level object parse error");
 
         req->WriteHeader("Content-Type", "application/json");
@@ -237,7 +276,13 @@ bool StartHTTPRPC()
     if (!InitRPCAuthentication())
         return false;
 
-    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC);
+    std::string strError;
+    if (!InitRPCWorkClasses(strError)) {
+        uiInterface.ThreadSafeMessageBox(strError, "", CClientUIInterface::MSG_ERROR);
+        return false;
+    }
+
+    RegisterHTTPHandler("/", true, HTTPReq_JSONRPC, HTTPClassify_JSONRPC);
 
     assert(EventBase());
     httpRPCTimerInterface = new HTTPRPCTimerInterface(EventBase());
@@ -19,7 +19,9 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <signal.h>
+#include <condition_variable>
 #include <future>
+#include <mutex>
 
 #include <event2/event.h>
 #include <event2/http.h>
@@ -48,6 +50,7 @@ public:
     }
     void operator()() override
     {
+        req->nTimeStarted = GetTimeMicros();
         func(req.get(), path);
     }
 
@@ -72,6 +75,8 @@ private:
     bool running;
     size_t maxDepth;
     int numThreads;
+    uint64_t numProcessed;
+    uint64_t numRejected;
 
     /** RAII object to keep track of number of running worker threads */
     class ThreadCounter
@@ -94,7 +99,9 @@ private:
 public:
     WorkQueue(size_t _maxDepth) : running(true),
                                  maxDepth(_maxDepth),
-                                 numThreads(0)
+                                 numThreads(0),
+                                 numProcessed(0),
+                                 numRejected(0)
     {
     }
     /** Precondition: worker threads have all stopped
@@ -108,6 +115,7 @@ public:
     {
         std::unique_lock<std::mutex> lock(cs);
         if (queue.size() >= maxDepth) {
+            numRejected++;
             return false;
         }
         queue.emplace_back(std::unique_ptr<WorkItem>(item));
@@ -128,6 +136,7 @@ public:
                     break;
                 i = std::move(queue.front());
                 queue.pop_front();
+                numProcessed++;
             }
             (*i)();
         }
@@ -154,18 +163,43 @@ public:
         std::unique_lock<std::mutex> lock(cs);
         return queue.size();
     }
+
+    /** Fill in the statistics of this queue (but the work class) */
+    void GetStats(HTTPWorkQueueStats& stats)
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        stats.nThreads = numThreads;
+        stats.nDepth = queue.size();
+        stats.nMaxDepth = maxDepth;
+        stats.nProcessed = numProcessed;
+        stats.nRejected = numRejected;
+    }
 };
 
 struct HTTPPathHandler
 {
     HTTPPathHandler() {}
-    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler):
-        prefix(_prefix), exactMatch(_exactMatch), handler(_handler)
+    HTTPPathHandler(std::string _prefix, bool _exactMatch, HTTPRequestHandler _handler, HTTPRequestClassifier _classifier):
+        prefix(_prefix), exactMatch(_exactMatch), handler(_handler), classifier(_classifier)
     {
     }
     std::string prefix;
     bool exactMatch;
     HTTPRequestHandler handler;
+    HTTPRequestClassifier classifier;
+};
+
+/** Names and settings of the work classes */
+static const struct {
+    const char* name;
+    const char* threadsArg;
+    int defaultThreads;
+    const char* depthArg;
+    int defaultDepth;
+} workClasses[HTTP_WORK_CLASS_COUNT] = {
+    {"cheap", "-rpccheapthreads", DEFAULT_HTTP_CHEAP_THREADS, "-rpccheapworkqueue", DEFAULT_HTTP_CHEAP_WORKQUEUE},
+    {"normal", "-rpcthreads", DEFAULT_HTTP_THREADS, "-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE},
+    {"heavy", "-rpcheavythreads", DEFAULT_HTTP_HEAVY_THREADS, "-rpcheavyworkqueue", DEFAULT_HTTP_HEAVY_WORKQUEUE},
 };
 
 /** HTTP module state */
@@ -176,8 +210,8 @@ static struct event_base* eventBase = 0;
 struct evhttp* eventHTTP = 0;
 //! List of subnets to allow RPC connections from
 static std::vector<CSubNet> rpc_allow_subnets;
-//! Work queue for handling longer requests off the event loop thread
-static WorkQueue<HTTPClosure>* workQueue = 0;
+//! Work queues for handling longer requests off the event loop thread, one per work class
+static WorkQueue<HTTPClosure>* workQueues[HTTP_WORK_CLASS_COUNT] = {};
 //! Handlers for (sub)paths
 std::vector<HTTPPathHandler> pathHandlers;
 //! Bound listening sockets
@@ -283,14 +317,17 @@ static void http_request_cb(struct evhttp_request* req, void* arg)
         }
     }
 
-    // Dispatch to worker thread
+    // Dispatch to worker thread of the request's work class
     if (i != iend) {
+        const HTTPWorkClass workClass = i->classifier ? i->classifier(hreq.get(), path) : HTTP_WORK_NORMAL;
         std::unique_ptr<HTTPWorkItem> item(new HTTPWorkItem(std::move(hreq), path, i->handler));
+        WorkQueue<HTTPClosure>* workQueue = workQueues[workClass];
         assert(workQueue);
         if (workQueue->Enqueue(item.get()))
             item.release(); /* if true, queue took ownership */
         else {
-            LogPrintf("WARNING: request rejected because http work queue depth exceeded, it can be increased with the -rpcworkqueue= setting\n");
+            LogPrintf("WARNING: request rejected because http %s work queue depth exceeded, it can be increased with the %s= setting\n",
+                      workClasses[workClass].name, workClasses[workClass].depthArg);
             item->req->WriteReply(HTTP_INTERNAL, "Work queue depth exceeded");
         }
     } else {
@@ -433,10 +470,11 @@ bool InitHTTPServer()
     }
 
     LogPrint("http", "Initialized HTTP server\n");
-    int workQueueDepth = std::max((long)GetArg("-rpcworkqueue", DEFAULT_HTTP_WORKQUEUE), 1L);
-    LogPrintf("HTTP: creating work queue of depth %d\n", workQueueDepth);
-
-    workQueue = new WorkQueue<HTTPClosure>(workQueueDepth);
+    for (int i = 0; i < HTTP_WORK_CLASS_COUNT; i++) {
+        int workQueueDepth = std::max((long)GetArg(workClasses[i].depthArg, workClasses[i].defaultDepth), 1L);
+        LogPrintf("HTTP: creating %s work queue of depth %d\n", workClasses[i].name, workQueueDepth);
+        workQueues[i] = new WorkQueue<HTTPClosure>(workQueueDepth);
+    }
     eventBase = base;
     eventHTTP = http;
     return true;
@@ -448,15 +486,17 @@ std::future<bool> threadResult;
 bool StartHTTPServer()
 {
     LogPrint("http", "Starting HTTP server\n");
-    int rpcThreads = std::max((long)GetArg("-rpcthreads", DEFAULT_HTTP_THREADS), 1L);
-    LogPrintf("HTTP: starting %d worker threads\n", rpcThreads);
     std::packaged_task<bool(event_base*, evhttp*)> task(ThreadHTTP);
     threadResult = task.get_future();
     threadHTTP = std::thread(std::move(task), eventBase, eventHTTP);
 
-    for (int i = 0; i < rpcThreads; i++) {
-        std::thread rpc_worker(HTTPWorkQueueRun, workQueue);
-        rpc_worker.detach();
+    for (int i = 0; i < HTTP_WORK_CLASS_COUNT; i++) {
+        int rpcThreads = std::max((long)GetArg(workClasses[i].threadsArg, workClasses[i].defaultThreads), 1L);
+        LogPrintf("HTTP: starting %d %s worker threads\n", rpcThreads, workClasses[i].name);
+        for (int j = 0; j < rpcThreads; j++) {
+            std::thread rpc_worker(HTTPWorkQueueRun, workQueues[i]);
+            rpc_worker.detach();
+        }
     }
     return true;
 }
@@ -472,14 +512,18 @@ void InterruptHTTPServer()
         // Reject requests on current connections
         evhttp_set_gencb(eventHTTP, http_reject_request_cb, NULL);
     }
-    if (workQueue)
-        workQueue->Interrupt();
+    for (WorkQueue<HTTPClosure>* workQueue : workQueues) {
+        if (workQueue)
+            workQueue->Interrupt();
+    }
 }
 
 void StopHTTPServer()
 {
     LogPrint("http", "Stopping HTTP server\n");
-    if (workQueue) {
+    for (WorkQueue<HTTPClosure>*& workQueue : workQueues) {
+        if (!workQueue)
+            continue;
         LogPrint("http", "Waiting for HTTP worker threads to exit\n");
 #ifndef WIN32
         // ToDo: Disabling WaitExit() for Windows platforms is an ugly workaround for the wallet not
@@ -488,6 +532,7 @@ void StopHTTPServer()
         workQueue->WaitExit();
 #endif        
         delete workQueue;
+        workQueue = 0;
     }
     if (eventBase) {
         LogPrint("http", "Waiting for HTTP event thread to exit\n");
@@ -519,6 +564,37 @@ struct event_base* EventBase()
     return eventBase;
 }
 
+std::string HTTPWorkClassName(HTTPWorkClass workClass)
+{
+    assert(workClass >= 0 && workClass < HTTP_WORK_CLASS_COUNT);
+    return workClasses[workClass].name;
+}
+
+bool ParseHTTPWorkClass(const std::string& strName, HTTPWorkClass& workClass)
+{
+    for (int i = 0; i < HTTP_WORK_CLASS_COUNT; i++) {
+        if (strName == workClasses[i].name) {
+            workClass = (HTTPWorkClass)i;
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<HTTPWorkQueueStats> GetHTTPWorkQueueStats()
+{
+    std::vector<HTTPWorkQueueStats> vStats;
+    for (int i = 0; i < HTTP_WORK_CLASS_COUNT; i++) {
+        if (!workQueues[i])
+            continue;
+        HTTPWorkQueueStats stats;
+        stats.workClass = (HTTPWorkClass)i;
+        workQueues[i]->GetStats(stats);
+        vStats.push_back(stats);
+    }
+    return vStats;
+}
+
 static void httpevent_callback_fn(evutil_socket_t, short, void* data)
 {
     // Static handler: simply call inner handler
@@ -546,12 +622,17 @@ void HTTPEvent::trigger(struct timeval* tv)
         evtimer_add(ev, tv); // trigger after timeval passed
 }
 HTTPRequest::HTTPRequest(struct evhttp_request* _req) : req(_req),
-                                                       replySent(false)
+                                                       replySent(false),
+                                                       nTimeReceived(GetTimeMicros()),
+                                                       nTimeStarted(0)
 {
 }
 HTTPRequest::~HTTPRequest()
 {
-    if (!replySent) {
+    if (!replySent && replyStream) {
+        // A chunked reply was started, the only thing left to do is to finish it
+        EndReplyChunks();
+    } else if (!replySent) {
         // Keep track of whether reply was sent to avoid request leaks
         LogPrintf("%s: Unhandled request\n", __func__);
         WriteReply(HTTP_INTERNAL, "Unhandled request");
@@ -570,7 +651,7 @@ std::pair<bool, std::string> HTTPRequest::GetHeader(const std::string& hdr)
         return std::make_pair(false, "");
 }
 
-std::string HTTPRequest::ReadBody()
+std::string HTTPRequest::ReadBody(bool fConsume)
 {
     struct evbuffer* buf = evhttp_request_get_input_buffer(req);
     if (!buf)
@@ -586,7 +667,8 @@ std::string HTTPRequest::ReadBody()
     if (!data) // returns NULL in case of empty buffer
         return "";
     std::string rv(data, size);
-    evbuffer_drain(buf, size);
+    if (fConsume)
+        evbuffer_drain(buf, size);
     return rv;
 }
 
@@ -616,6 +698,127 @@ void HTTPRequest::WriteReply(int nStatus, const std::string& strReply)
     req = 0; // transferred back to main thread
 }
 
+void HTTPRequest::WriteReplyPart(const char* data, size_t nSize)
+{
+    assert(!replySent && req);
+    struct evbuffer* evb = evhttp_request_get_output_buffer(req);
+    assert(evb);
+    evbuffer_add(evb, data, nSize);
+}
+
+/** Max. amount of chunk data handed to libevent which hasn't been written to the client yet */
+static const size_t MAX_PENDING_REPLY_BYTES = 4 * 1024 * 1024;
+
+/** State of a chunked reply, shared by the worker producing it and the http thread sending it */
+struct HTTPReplyStream
+{
+    std::mutex cs;
+    std::condition_variable cond;
+    //! bytes handed to libevent since the connection's output buffer was last drained
+    size_t nPendingBytes{0};
+    //! set when the connection was closed, the request is gone then
+    bool fClosed{false};
+    //! only accessed from the http thread
+    struct evhttp_connection* evcon{nullptr};
+};
+
+static void http_reply_stream_closed_cb(struct evhttp_connection* evcon, void* arg)
+{
+    HTTPReplyStream* stream = static_cast<HTTPReplyStream*>(arg);
+    {
+        std::lock_guard<std::mutex> lock(stream->cs);
+        stream->fClosed = true;
+    }
+    stream->cond.notify_all();
+}
+
+static void http_reply_stream_drained_cb(struct evhttp_connection* evcon, void* arg)
+{
+    HTTPReplyStream* stream = static_cast<HTTPReplyStream*>(arg);
+    {
+        std::lock_guard<std::mutex> lock(stream->cs);
+        stream->nPendingBytes = 0;
+    }
+    stream->cond.notify_all();
+}
+
+void HTTPRequest::StartReplyChunks(int nStatus)
+{
+    assert(!replySent && req && !replyStream);
+    replyStream = std::make_shared<HTTPReplyStream>();
+    std::shared_ptr<HTTPReplyStream> stream = replyStream;
+    struct evhttp_request* reqLocal = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [reqLocal, stream, nStatus]() {
+        // The stream outlives the close callback, it is unset again before the reply is finished
+        stream->evcon = evhttp_request_get_connection(reqLocal);
+        if (stream->evcon)
+            evhttp_connection_set_closecb(stream->evcon, http_reply_stream_closed_cb, stream.get());
+        evhttp_send_reply_start(reqLocal, nStatus, NULL);
+    });
+    ev->trigger(0);
+}
+
+bool HTTPRequest::WriteReplyChunk(const std::string& strChunk)
+{
+    assert(!replySent && req && replyStream);
+    std::shared_ptr<HTTPReplyStream> stream = replyStream;
+    {
+        std::unique_lock<std::mutex> lock(stream->cs);
+        const std::chrono::seconds timeout(GetArg("-rpcservertimeout", DEFAULT_HTTP_SERVER_TIMEOUT));
+        bool fReady = stream->cond.wait_for(lock, timeout, [&stream]() {
+            return stream->fClosed || stream->nPendingBytes < MAX_PENDING_REPLY_BYTES;
+        });
+        if (!fReady || stream->fClosed)
+            return false;
+        stream->nPendingBytes += strChunk.size();
+    }
+
+    struct evbuffer* evb = evbuffer_new();
+    assert(evb);
+    evbuffer_add(evb, strChunk.data(), strChunk.size());
+    struct evhttp_request* reqLocal = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [reqLocal, stream, evb]() {
+        bool fClosed;
+        {
+            std::lock_guard<std::mutex> lock(stream->cs);
+            fClosed = stream->fClosed;
+        }
+        if (!fClosed) {
+#if LIBEVENT_VERSION_NUMBER >= 0x02010100
+            evhttp_send_reply_chunk_with_cb(reqLocal, evb, http_reply_stream_drained_cb, stream.get());
+#else
+            // No way to learn when the data was written, don't hold back the writer then
+            evhttp_send_reply_chunk(reqLocal, evb);
+            http_reply_stream_drained_cb(NULL, stream.get());
+#endif
+        }
+        evbuffer_free(evb);
+    });
+    ev->trigger(0);
+    return true;
+}
+
+void HTTPRequest::EndReplyChunks()
+{
+    assert(!replySent && req && replyStream);
+    std::shared_ptr<HTTPReplyStream> stream = replyStream;
+    struct evhttp_request* reqLocal = req;
+    HTTPEvent* ev = new HTTPEvent(eventBase, true, [reqLocal, stream]() {
+        {
+            std::lock_guard<std::mutex> lock(stream->cs);
+            if (stream->fClosed)
+                return; // evhttp already freed the request together with the connection
+        }
+        if (stream->evcon)
+            evhttp_connection_set_closecb(stream->evcon, NULL, NULL);
+        evhttp_send_reply_end(reqLocal);
+    });
+    ev->trigger(0);
+    replyStream.reset();
+    replySent = true;
+    req = 0; // transferred back to main thread
+}
+
 CService HTTPRequest::GetPeer()
 {
     evhttp_connection* con = evhttp_request_get_connection(req);
@@ -656,10 +859,11 @@ HTTPRequest::RequestMethod HTTPRequest::GetRequestMethod()
     }
 }
 
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler)
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler,
+                         const HTTPRequestClassifier &classifier)
 {
     LogPrint("http", "Registering HTTP handler for %s (exactmatch %d)\n", prefix, exactMatch);
-    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler));
+    pathHandlers.push_back(HTTPPathHandler(prefix, exactMatch, handler, classifier));
 }
 
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch)
@@ -8,9 +8,15 @@
 #include <string>
 #include <stdint.h>
 #include <functional>
+#include <memory>
+#include <vector>
 
 static const int DEFAULT_HTTP_THREADS=4;
 static const int DEFAULT_HTTP_WORKQUEUE=16;
+static const int DEFAULT_HTTP_CHEAP_THREADS=2;
+static const int DEFAULT_HTTP_CHEAP_WORKQUEUE=64;
+static const int DEFAULT_HTTP_HEAVY_THREADS=2;
+static const int DEFAULT_HTTP_HEAVY_WORKQUEUE=8;
 static const int DEFAULT_HTTP_SERVER_TIMEOUT=30;
 
 struct evhttp_request;
@@ -32,13 +38,30 @@ void InterruptHTTPServer();
 /** Stop HTTP server */
 void StopHTTPServer();
 
+/** Cost classes of requests. Every class has its own work queue and worker threads, so a pile of
+ * expensive requests only gets requests of its own class rejected.
+ */
+enum HTTPWorkClass {
+    HTTP_WORK_CHEAP,
+    HTTP_WORK_NORMAL, //!< sized by -rpcthreads and -rpcworkqueue
+    HTTP_WORK_HEAVY,
+    HTTP_WORK_CLASS_COUNT
+};
+std::string HTTPWorkClassName(HTTPWorkClass workClass);
+bool ParseHTTPWorkClass(const std::string& strName, HTTPWorkClass& workClass);
+
 /** Handler for requests to a certain HTTP path */
 typedef std::function<bool(HTTPRequest* req, const std::string &)> HTTPRequestHandler;
+/** Picks the work class of a request to a certain HTTP path. Runs on the event loop thread, so it has
+ * to be quick, and must not consume the request body.
+ */
+typedef std::function<HTTPWorkClass(HTTPRequest* req, const std::string &)> HTTPRequestClassifier;
 /** Register handler for prefix.
  * If multiple handlers match a prefix, the first-registered one will
- * be invoked.
+ * be invoked. Without a classifier, requests are handled as HTTP_WORK_NORMAL.
  */
-void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler);
+void RegisterHTTPHandler(const std::string &prefix, bool exactMatch, const HTTPRequestHandler &handler,
+                         const HTTPRequestClassifier &classifier = HTTPRequestClassifier());
 /** Unregister handler for prefix */
 void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
 
@@ -47,14 +70,36 @@ void UnregisterHTTPHandler(const std::string &prefix, bool exactMatch);
  */
 struct event_base* EventBase();
 
+struct HTTPWorkQueueStats
+{
+    HTTPWorkClass workClass;
+    int nThreads;
+    size_t nDepth;
+    size_t nMaxDepth;
+    uint64_t nProcessed;
+    uint64_t nRejected;
+};
+
+/** Return the state of the work queues, one entry per work class */
+std::vector<HTTPWorkQueueStats> GetHTTPWorkQueueStats();
+
+struct HTTPReplyStream;
+
 /** In-flight HTTP request.
  * Thin C++ wrapper around evhttp_request.
  */
 class HTTPRequest
 {
+    friend class HTTPWorkItem;
+
 private:
     struct evhttp_request* req;
     bool replySent;
+    //! when the request was received and when a worker thread picked it up, in microseconds
+    int64_t nTimeReceived;
+    int64_t nTimeStarted;
+    //! set while a chunked reply is being sent
+    std::shared_ptr<HTTPReplyStream> replyStream;
 
 public:
     HTTPRequest(struct evhttp_request* req);
@@ -90,9 +135,13 @@ public:
      * Read request body.
      *
      * @note As this consumes the underlying buffer, call this only once.
-     * Repeated calls will return an empty string.
+     * Repeated calls will return an empty string. Pass fConsume=false to leave
+     * the body in place, e.g. to take a look at it in a HTTPRequestClassifier.
      */
-    std::string ReadBody();
+    std::string ReadBody(bool fConsume = true);
+
+    /** Time the request spent waiting in its work queue, in microseconds */
+    int64_t GetQueueTime() const { return nTimeStarted ? nTimeStarted - nTimeReceived : 0; }
 
     /**
      * Write output header.
@@ -101,6 +150,14 @@ public:
      */
     void WriteHeader(const std::string& hdr, const std::string& value);
 
+    /**
+     * Append data to the body of the reply without sending anything yet, so large replies can be
+     * produced piecewise instead of being assembled in one string first.
+     *
+     * @note The reply is sent by a following WriteReply call, which appends its strReply to this data.
+     */
+    void WriteReplyPart(const char* data, size_t nSize);
+
     /**
      * Write HTTP reply.
      * nStatus is the HTTP status code to send.
@@ -110,6 +167,25 @@ public:
      * main thread, do not call any other HTTPRequest methods after calling this.
      */
     void WriteReply(int nStatus, const std::string& strReply = "");
+
+    /**
+     * Start a reply using chunked transfer encoding, for replies which are too large to be kept in
+     * memory at once. Headers have to be written before.
+     *
+     * @note Follow up with WriteReplyChunk calls and finish with EndReplyChunks instead of WriteReply.
+     */
+    void StartReplyChunks(int nStatus);
+
+    /**
+     * Send the next part of a chunked reply. Blocks while more than a few MB handed to this function
+     * haven't made it to the network yet, so a slow client doesn't make the node buffer the whole reply.
+     * Returns false if the client went away (or stopped reading), in which case the caller can stop
+     * producing data, but still has to call EndReplyChunks.
+     */
+    bool WriteReplyChunk(const std::string& strChunk);
+
+    /** Finish a chunked reply. As with WriteReply, no other methods must be called afterwards. */
+    void EndReplyChunks();
 };
 
 /** Event handler closure.
@@ -0,0 +1,377 @@
+// Copyright (c) 2019 The Polis Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "indexbuilder.h"
+
+#include "chain.h"
+#include "chainparams.h"
+#include "hash.h"
+#include "primitives/block.h"
+#include "txdb.h"
+#include "undo.h"
+#include "util.h"
+#include "validation.h"
+
+#include <algorithm>
+#include <functional>
+
+CIndexBuilder indexBuilder;
+
+// Same classification of scripts as in ConnectBlock
+static int GetAddressType(const CScript& script, uint160& hashBytes)
+{
+    if (script.IsPayToScriptHash()) {
+        hashBytes = uint160(std::vector<unsigned char>(script.begin()+2, script.begin()+22));
+        return 2;
+    } else if (script.IsPayToPublicKeyHash()) {
+        hashBytes = uint160(std::vector<unsigned char>(script.begin()+3, script.begin()+23));
+        return 1;
+    } else if (script.IsPayToPublicKey()) {
+        hashBytes = Hash160(script.begin()+1, script.end()-1);
+        return 1;
+    }
+    hashBytes.SetNull();
+    return 0;
+}
+
+/**
+ * Collect the index entries ConnectBlock writes for a block. If fDisconnect is set, the unspent and
+ * spent entries are the ones restoring the state before the block (null values erase an entry) and
+ * the address and timestamp entries are the ones to erase, in the order DisconnectBlock uses.
+ */
+static bool GetBlockIndexEntries(const CBlock& block, const CBlockUndo& blockUndo, const CBlockIndex* pindex,
+                                 int nIndexes, bool fDisconnect, CAdditionalIndexEntries& entries)
+{
+    if (blockUndo.vtxundo.size() + 1 != block.vtx.size())
+        return error("%s: block and undo data inconsistent for %s", __func__, pindex->GetBlockHash().ToString());
+
+    const bool fAddress = nIndexes & CIndexBuilder::INDEX_ADDRESS;
+    const bool fSpent = nIndexes & CIndexBuilder::INDEX_SPENT;
+
+    for (size_t n = 0; n < block.vtx.size(); n++) {
+        const size_t i = fDisconnect ? block.vtx.size() - 1 - n : n;
+        const CTransaction& tx = *block.vtx[i];
+        const uint256 txhash = tx.GetHash();
+
+        auto addOutputs = [&]() {
+            if (!fAddress)
+                return;
+            for (unsigned int k = 0; k < tx.vout.size(); k++) {
+                const CTxOut& out = tx.vout[k];
+                uint160 hashBytes;
+                int addressType = GetAddressType(out.scriptPubKey, hashBytes);
+                if (addressType == 0)
+                    continue;
+                entries.addressIndex.push_back(std::make_pair(CAddressIndexKey(addressType, hashBytes, pindex->nHeight, i, txhash, k, false), out.nValue));
+                entries.addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(addressType, hashBytes, txhash, k),
+                    fDisconnect ? CAddressUnspentValue() : CAddressUnspentValue(out.nValue, out.scriptPubKey, pindex->nHeight)));
+            }
+        };
+
+        if (fDisconnect)
+            addOutputs();
+
+        if (i > 0) {
+            const CTxUndo& txundo = blockUndo.vtxundo[i-1];
+            if (txundo.vprevout.size() != tx.vin.size())
+                return error("%s: transaction and undo data inconsistent for %s", __func__, txhash.ToString());
+
+            for (unsigned int j = 0; j < tx.vin.size(); j++) {
+                const CTxIn& input = tx.vin[j];
+                const Coin& coin = txundo.vprevout[j];
+                const CTxOut& prevout = coin.out;
+                uint160 hashBytes;
+                int addressType = GetAddressType(prevout.scriptPubKey, hashBytes);
+
+                if (fAddress && addressType > 0) {
+                    entries.addressIndex.push_back(std::make_pair(CAddressIndexKey(addressType, hashBytes, pindex->nHeight, i, txhash, j, true), prevout.nValue * -1));
+                    entries.addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(addressType, hashBytes, input.prevout.hash, input.prevout.n),
+                        fDisconnect ? CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, coin.nHeight) : CAddressUnspentValue()));
+                }
+
+                if (fSpent) {
+                    entries.spentIndex.push_back(std::make_pair(CSpentIndexKey(input.prevout.hash, input.prevout.n),
+                        fDisconnect ? CSpentIndexValue() : CSpentIndexValue(txhash, j, pindex->nHeight, prevout.nValue, addressType, hashBytes)));
+                }
+            }
+        }
+
+        if (!fDisconnect)
+            addOutputs();
+    }
+
+    if (nIndexes & CIndexBuilder::INDEX_TIMESTAMP)
+        entries.timestampIndex.push_back(CTimestampIndexKey(pindex->nTime, pindex->GetBlockHash()));
+
+    return true;
+}
+
+int CIndexBuilder::GetEnabledIndexes()
+{
+    return (fAddressIndex ? INDEX_ADDRESS : 0) | (fSpentIndex ? INDEX_SPENT : 0) | (fTimestampIndex ? INDEX_TIMESTAMP : 0);
+}
+
+int CIndexBuilder::GetMissingIndexes()
+{
+    int nMissing = 0;
+    if (GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX) && !fAddressIndex)
+        nMissing |= INDEX_ADDRESS;
+    if (GetBoolArg("-spentindex", DEFAULT_SPENTINDEX) && !fSpentIndex)
+        nMissing |= INDEX_SPENT;
+    if (GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX) && !fTimestampIndex)
+        nMissing |= INDEX_TIMESTAMP;
+    return nMissing;
+}
+
+std::string CIndexBuilder::IndexNames(int nIndexesIn)
+{
+    std::vector<std::string> vNames;
+    if (nIndexesIn & INDEX_ADDRESS)
+        vNames.push_back("addressindex");
+    if (nIndexesIn & INDEX_SPENT)
+        vNames.push_back("spentindex");
+    if (nIndexesIn & INDEX_TIMESTAMP)
+        vNames.push_back("timestampindex");
+    std::string strNames;
+    for (const auto& strName : vNames)
+        strNames += (strNames.empty() ? "" : ",") + strName;
+    return strNames;
+}
+
+void CIndexBuilder::Start(int nIndexesIn, int nThreadsIn)
+{
+    assert(!threadBuild.joinable());
+
+    int nStoredIndexes = 0;
+    uint256 hashStored;
+    if (pblocktree->ReadIndexBuildState(nStoredIndexes, hashStored) && (nStoredIndexes & ~GetEnabledIndexes()) == 0) {
+        // The flags got written but the node stopped before the progress was erased
+        pblocktree->FinishIndexBuild(std::vector<std::string>());
+        nStoredIndexes = 0;
+    }
+    if (nStoredIndexes != 0) {
+        // The stored progress only holds for the indexes which were being built, continue with these first.
+        // Anything requested in addition is picked up on the next start.
+        if (nStoredIndexes != nIndexesIn) {
+            LogPrintf("%s: resuming build of %s, %s will be built afterwards\n", __func__,
+                      IndexNames(nStoredIndexes), IndexNames(nIndexesIn & ~nStoredIndexes));
+        }
+        nIndexesIn = nStoredIndexes;
+        hashBuilt = hashStored;
+    } else {
+        hashBuilt.SetNull();
+    }
+
+    nIndexes = nIndexesIn;
+    nThreads = std::max(1, std::min(nThreadsIn, MAX_INDEX_BUILD_THREADS));
+    nHeight = -1;
+    fInterrupt = false;
+    fRunning = true;
+    {
+        LOCK(cs_status);
+        strError.clear();
+    }
+
+    LogPrintf("%s: building %s in the background using %d threads\n", __func__, IndexNames(nIndexesIn), nThreads);
+    threadBuild = std::thread(&TraceThread<std::function<void()> >, "idxbuild", std::function<void()>(std::bind(&CIndexBuilder::ThreadBuild, this)));
+}
+
+void CIndexBuilder::Interrupt()
+{
+    fInterrupt = true;
+}
+
+void CIndexBuilder::Stop()
+{
+    Interrupt();
+    if (threadBuild.joinable())
+        threadBuild.join();
+}
+
+std::string CIndexBuilder::GetError() const
+{
+    LOCK(cs_status);
+    return strError;
+}
+
+void CIndexBuilder::SetError(const std::string& strErrorIn)
+{
+    LogPrintf("%s: %s\n", __func__, strErrorIn);
+    LOCK(cs_status);
+    strError = strErrorIn;
+}
+
+bool CIndexBuilder::ReadBlocks(std::vector<WorkItem>& vWork, bool fDisconnect)
+{
+    const Consensus::Params& consensusParams = Params().GetConsensus();
+    const int nIndexesLocal = nIndexes;
+    std::atomic<size_t> nNext(0);
+
+    auto worker = [&]() {
+        size_t n;
+        while ((n = nNext++) < vWork.size() && !fInterrupt) {
+            WorkItem& item = vWork[n];
+            CBlock block;
+            CBlockUndo blockUndo;
+            if (!ReadBlockFromDisk(block, item.pindex, consensusParams)) {
+                error("%s: failed to read block %s", __func__, item.pindex->GetBlockHash().ToString());
+                continue;
+            }
+            if (!UndoReadFromDisk(blockUndo, item.pindex->GetUndoPos(), item.pindex->pprev->GetBlockHash())) {
+                error("%s: failed to read undo data of block %s", __func__, item.pindex->GetBlockHash().ToString());
+                continue;
+            }
+            item.fOk = GetBlockIndexEntries(block, blockUndo, item.pindex, nIndexesLocal, fDisconnect, *item.pentries);
+        }
+    };
+
+    std::vector<std::thread> vThreads;
+    for (int i = 1; i < nThreads && (size_t)i < vWork.size(); i++)
+        vThreads.emplace_back(worker);
+    worker();
+    for (auto& thread : vThreads)
+        thread.join();
+
+    for (const auto& item : vWork) {
+        if (!item.fOk)
+            return false;
+    }
+    return true;
+}
+
+bool CIndexBuilder::ProcessBlocks(const std::vector<const CBlockIndex*>& vBlocks, bool fDisconnect, const CBlockIndex* pindexLast)
+{
+    std::vector<CAdditionalIndexEntries> vEntries(vBlocks.size());
+    std::vector<WorkItem> vWork;
+    vWork.reserve(vBlocks.size());
+    for (size_t i = 0; i < vBlocks.size(); i++)
+        vWork.push_back(WorkItem{vBlocks[i], &vEntries[i], false});
+
+    if (!ReadBlocks(vWork, fDisconnect)) {
+        if (!fInterrupt)
+            SetError(strprintf("Failed to read blocks %d-%d from disk", vBlocks.front()->nHeight, vBlocks.back()->nHeight));
+        return false;
+    }
+
+    // One batch for the whole range, in block order, so entries created and removed within it cancel out
+    CAdditionalIndexEntries entries;
+    for (auto& blockEntries : vEntries) {
+        entries.addressIndex.insert(entries.addressIndex.end(), blockEntries.addressIndex.begin(), blockEntries.addressIndex.end());
+        entries.addressUnspentIndex.insert(entries.addressUnspentIndex.end(), blockEntries.addressUnspentIndex.begin(), blockEntries.addressUnspentIndex.end());
+        entries.spentIndex.insert(entries.spentIndex.end(), blockEntries.spentIndex.begin(), blockEntries.spentIndex.end());
+        entries.timestampIndex.insert(entries.timestampIndex.end(), blockEntries.timestampIndex.begin(), blockEntries.timestampIndex.end());
+    }
+
+    if (!pblocktree->WriteIndexBuildBatch(entries, fDisconnect, nIndexes, pindexLast->GetBlockHash())) {
+        SetError("Failed to write index batch");
+        return false;
+    }
+    hashBuilt = pindexLast->GetBlockHash();
+    nHeight = pindexLast->nHeight;
+    return true;
+}
+
+bool CIndexBuilder::Finish()
+{
+    AssertLockHeld(cs_main);
+
+    const int nIndexesLocal = nIndexes;
+    std::vector<std::string> vFlags;
+    if (nIndexesLocal & INDEX_ADDRESS) {
+        vFlags.push_back("addressindex");
+        vFlags.push_back("addressbalanceindex");
+    }
+    if (nIndexesLocal & INDEX_SPENT)
+        vFlags.push_back("spentindex");
+    if (nIndexesLocal & INDEX_TIMESTAMP)
+        vFlags.push_back("timestampindex");
+
+    if (!pblocktree->FinishIndexBuild(vFlags)) {
+        SetError("Failed to write index flags");
+        return false;
+    }
+
+    // From now on ConnectBlock and DisconnectBlock maintain the indexes
+    if (nIndexesLocal & INDEX_ADDRESS)
+        fAddressIndex = true;
+    if (nIndexesLocal & INDEX_SPENT)
+        fSpentIndex = true;
+    if (nIndexesLocal & INDEX_TIMESTAMP)
+        fTimestampIndex = true;
+
+    LogPrintf("%s: %s built up to block %s at height %d\n", __func__, IndexNames(nIndexesLocal), hashBuilt.ToString(), nHeight);
+    return true;
+}
+
+void CIndexBuilder::ThreadBuild()
+{
+    const size_t nBlocksPerRange = BLOCKS_PER_THREAD * nThreads;
+    int64_t nLastLog = 0;
+    bool fFinished = false;
+
+    while (!fInterrupt) {
+        std::vector<const CBlockIndex*> vBlocks;
+        const CBlockIndex* pindexLast = nullptr;
+        bool fDisconnect = false;
+
+        {
+            LOCK(cs_main);
+
+            const CBlockIndex* pindexBuilt = chainActive.Genesis();
+            if (!hashBuilt.IsNull()) {
+                BlockMap::const_iterator it = mapBlockIndex.find(hashBuilt);
+                if (it == mapBlockIndex.end()) {
+                    SetError("Index build progress refers to an unknown block, restart with -reindex");
+                    break;
+                }
+                pindexBuilt = it->second;
+            }
+            if (pindexBuilt != nullptr)
+                nHeight = pindexBuilt->nHeight;
+            if (pindexBuilt == nullptr) {
+                // Nothing to do before the genesis block is connected
+                pindexLast = nullptr;
+            } else if (!chainActive.Contains(pindexBuilt)) {
+                // Rewind the blocks which got disconnected since they were indexed, tip first
+                fDisconnect = true;
+                const CBlockIndex* pindex = pindexBuilt;
+                while (!chainActive.Contains(pindex) && vBlocks.size() < nBlocksPerRange) {
+                    vBlocks.push_back(pindex);
+                    pindex = pindex->pprev;
+                }
+                pindexLast = pindex;
+            } else if (chainActive.Height() - pindexBuilt->nHeight <= HANDOVER_BLOCKS) {
+                // Close enough, index the rest without letting the tip move and switch over
+                for (int nHeightNext = pindexBuilt->nHeight + 1; nHeightNext <= chainActive.Height(); nHeightNext++)
+                    vBlocks.push_back(chainActive[nHeightNext]);
+                if (!vBlocks.empty() && !ProcessBlocks(vBlocks, false, vBlocks.back()))
+                    break;
+                fFinished = Finish();
+                break;
+            } else {
+                int nHeightEnd = std::min(chainActive.Height(), pindexBuilt->nHeight + (int)nBlocksPerRange);
+                for (int nHeightNext = pindexBuilt->nHeight + 1; nHeightNext <= nHeightEnd; nHeightNext++)
+                    vBlocks.push_back(chainActive[nHeightNext]);
+                pindexLast = vBlocks.back();
+            }
+        }
+
+        if (pindexLast == nullptr) {
+            MilliSleep(100);
+            continue;
+        }
+
+        if (!ProcessBlocks(vBlocks, fDisconnect, pindexLast))
+            break;
+
+        if (GetTime() - nLastLog >= 10) {
+            LogPrintf("%s: %s built up to height %d\n", __func__, IndexNames(nIndexes), nHeight);
+            nLastLog = GetTime();
+        }
+    }
+
+    if (!fFinished && !fInterrupt && GetError().empty())
+        SetError("Index build stopped unexpectedly");
+    fRunning = false;
+}
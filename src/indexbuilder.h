@@ -0,0 +1,97 @@
+// Copyright (c) 2019 The Polis Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef POLIS_INDEXBUILDER_H
+#define POLIS_INDEXBUILDER_H
+
+#include "sync.h"
+#include "uint256.h"
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+class CBlockIndex;
+struct CAdditionalIndexEntries;
+
+//! -indexbuildthreads default, number of threads reading blocks for the background index builder
+static const int DEFAULT_INDEX_BUILD_THREADS = 4;
+static const int MAX_INDEX_BUILD_THREADS = 16;
+
+/**
+ * Builds -addressindex, -spentindex and -timestampindex for an already synced chain in the background.
+ *
+ * Enabling one of these indexes used to require a full -reindex. Instead, the builder walks the active
+ * chain from the genesis block, reads blocks and their undo data with several threads, and writes the
+ * resulting index entries in one batch per range of blocks together with its progress, so it can
+ * resume after a restart. Blocks which get disconnected before the builder reaches the tip are
+ * rewound the same way. Once the builder has caught up, it switches the indexes over to the inline
+ * path in ConnectBlock/DisconnectBlock while holding cs_main. Until then, the RPCs depending on the
+ * indexes keep reporting them as disabled while the node otherwise works as usual.
+ */
+class CIndexBuilder
+{
+public:
+    enum Index {
+        INDEX_ADDRESS = 1,
+        INDEX_SPENT = 2,
+        INDEX_TIMESTAMP = 4,
+    };
+
+private:
+    static const int BLOCKS_PER_THREAD = 64;
+    //! Once the builder is this close to the tip, the remaining blocks are indexed while holding cs_main
+    static const int HANDOVER_BLOCKS = 6;
+
+    struct WorkItem
+    {
+        const CBlockIndex* pindex;
+        CAdditionalIndexEntries* pentries;
+        bool fOk;
+    };
+
+    std::thread threadBuild;
+    std::atomic<bool> fInterrupt{false};
+    std::atomic<bool> fRunning{false};
+    std::atomic<int> nIndexes{0};
+    std::atomic<int> nHeight{-1};
+    int nThreads{DEFAULT_INDEX_BUILD_THREADS};
+    uint256 hashBuilt;
+
+    mutable CCriticalSection cs_status;
+    std::string strError;
+
+    void ThreadBuild();
+    //! Read and convert the blocks of vWork with nThreads threads, in parallel
+    bool ReadBlocks(std::vector<WorkItem>& vWork, bool fDisconnect);
+    //! Index (or rewind) the given blocks and advance the build progress to pindexLast
+    bool ProcessBlocks(const std::vector<const CBlockIndex*>& vBlocks, bool fDisconnect, const CBlockIndex* pindexLast);
+    bool Finish();
+    void SetError(const std::string& strErrorIn);
+
+public:
+    /** The indexes present in the block tree database */
+    static int GetEnabledIndexes();
+    /** The indexes enabled by the command line but not yet present in the block tree database */
+    static int GetMissingIndexes();
+    static std::string IndexNames(int nIndexes);
+
+    /**
+     * Start building the missing indexes (or resume an interrupted build). Must be called after the
+     * block index has been loaded.
+     */
+    void Start(int nIndexesIn, int nThreadsIn);
+    void Interrupt();
+    void Stop();
+
+    bool IsRunning() const { return fRunning; }
+    int GetIndexes() const { return nIndexes; }
+    int GetHeight() const { return nHeight; }
+    std::string GetError() const;
+};
+
+extern CIndexBuilder indexBuilder;
+
+#endif // POLIS_INDEXBUILDER_H
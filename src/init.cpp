@@ -20,6 +20,7 @@
 #include "consensus/validation.h"
 #include "httpserver.h"
 #include "httprpc.h"
+#include "indexbuilder.h"
 #include "key.h"
 #include "validation.h"
 #include "miner.h"
@@ -67,7 +68,9 @@
 #include "warnings.h"
 
 #include "evo/deterministicmns.h"
+#include "evo/simplifiedmns.h"
 
+#include "llmq/quorums_dummydkg.h"
 #include "llmq/quorums_init.h"
 
 #include <stdint.h>
@@ -93,6 +96,8 @@
 
 #if ENABLE_ZMQ
 #include "zmq/zmqnotificationinterface.h"
+#include "zmq/zmqpublishnotifier.h"
+#include "zmq/zmqrpc.h"
 #endif
 
 extern void ThreadSendAlert(CConnman& connman);
@@ -107,10 +112,6 @@ static const bool DEFAULT_STOPAFTERBLOCKIMPORT = false;
 std::unique_ptr<CConnman> g_connman;
 std::unique_ptr<PeerLogicValidation> peerLogic;
 
-#if ENABLE_ZMQ
-static CZMQNotificationInterface* pzmqNotificationInterface = NULL;
-#endif
-
 static CDSNotificationInterface* pdsNotificationInterface = NULL;
 
 #ifdef WIN32
@@ -214,6 +215,7 @@ void Interrupt(boost::thread_group& threadGroup)
     InterruptRPC();
     InterruptREST();
     InterruptTorControl();
+    indexBuilder.Interrupt();
     if (g_connman)
         g_connman->Interrupt();
     threadGroup.interrupt_all();
@@ -296,6 +298,8 @@ void PrepareShutdown()
         fFeeEstimatesInitialized = false;
     }
 
+    indexBuilder.Stop();
+
     {
         LOCK(cs_main);
         if (pcoinsTip != NULL) {
@@ -438,6 +442,7 @@ std::string HelpMessage(HelpMessageMode mode)
     if (showDebug)
         strUsage += HelpMessageOpt("-blocksonly", strprintf(_("Whether to operate in a blocks only mode (default: %u)"), DEFAULT_BLOCKSONLY));
     strUsage +=HelpMessageOpt("-assumevalid=<hex>", strprintf(_("If this block is in the chain assume that it and its ancestors are valid and potentially skip their script verification (0 to verify all, default: %s, testnet: %s)"), Params(CBaseChainParams::MAIN).GetConsensus().defaultAssumeValid.GetHex(), Params(CBaseChainParams::TESTNET).GetConsensus().defaultAssumeValid.GetHex()));
+    strUsage += HelpMessageOpt("-asynccoinsflush", strprintf(_("Write the coins cache to disk in a background thread, so block validation doesn't wait for it. Coins which are still being written count against -dbcache (default: %u)"), DEFAULT_ASYNC_COINS_FLUSH));
     strUsage += HelpMessageOpt("-conf=<file>", strprintf(_("Specify configuration file (default: %s)"), BITCOIN_CONF_FILENAME));
     if (mode == HMM_BITCOIND)
     {
@@ -452,6 +457,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-maxmempool=<n>", strprintf(_("Keep the transaction memory pool below <n> megabytes (default: %u)"), DEFAULT_MAX_MEMPOOL_SIZE));
     strUsage += HelpMessageOpt("-mempoolexpiry=<n>", strprintf(_("Do not keep transactions in the mempool longer than <n> hours (default: %u)"), DEFAULT_MEMPOOL_EXPIRY));
     strUsage += HelpMessageOpt("-blockreconstructionextratxn=<n>", strprintf(_("Extra transactions to keep in memory for compact block reconstructions (default: %u)"), DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN));
+    strUsage += HelpMessageOpt("-blockreconstructionspecialpool=<n>", strprintf(_("Use at most <n> megabytes of InstantSend/PrivateSend transactions which are not in the mempool for compact block reconstructions, 0 to disable (default: %u)"), DEFAULT_BLOCK_RECONSTRUCTION_SPECIAL_POOL));
     strUsage += HelpMessageOpt("-par=<n>", strprintf(_("Set the number of script verification threads (%u to %d, 0 = auto, <0 = leave that many cores free, default: %d)"),
         -GetNumCores(), MAX_SCRIPTCHECK_THREADS, DEFAULT_SCRIPTCHECK_THREADS));
 #ifndef WIN32
@@ -470,6 +476,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-addressindex", strprintf(_("Maintain a full address index, used to query for the balance, txids and unspent outputs for addresses (default: %u)"), DEFAULT_ADDRESSINDEX));
     strUsage += HelpMessageOpt("-timestampindex", strprintf(_("Maintain a timestamp index for block hashes, used to query blocks hashes by a range of timestamps (default: %u)"), DEFAULT_TIMESTAMPINDEX));
     strUsage += HelpMessageOpt("-spentindex", strprintf(_("Maintain a full spent index, used to query the spending txid and input index for an outpoint (default: %u)"), DEFAULT_SPENTINDEX));
+    strUsage += HelpMessageOpt("-indexbuildthreads=<n>", strprintf(_("Number of threads reading blocks when building one of the above indexes for an existing chain in the background (1 to %d, default: %d)"), MAX_INDEX_BUILD_THREADS, DEFAULT_INDEX_BUILD_THREADS));
 
     strUsage += HelpMessageGroup(_("Connection options:"));
     strUsage += HelpMessageOpt("-addnode=<ip>", _("Add a node to connect to and attempt to keep the connection open"));
@@ -489,6 +496,7 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-maxreceivebuffer=<n>", strprintf(_("Maximum per-connection receive buffer, <n>*1000 bytes (default: %u)"), DEFAULT_MAXRECEIVEBUFFER));
     strUsage += HelpMessageOpt("-maxsendbuffer=<n>", strprintf(_("Maximum per-connection send buffer, <n>*1000 bytes (default: %u)"), DEFAULT_MAXSENDBUFFER));
     strUsage += HelpMessageOpt("-maxtimeadjustment", strprintf(_("Maximum allowed median peer time offset adjustment. Local perspective of time may be influenced by peers forward or backward by this amount. (default: %u seconds)"), DEFAULT_MAX_TIME_ADJUSTMENT));
+    strUsage += HelpMessageOpt("-mnlistdiffcachesize=<n>", strprintf(_("Limit size of the cache of mnlistdiff messages served to SPV clients to <n> MiB, 0 = disable (default: %u)"), DEFAULT_MNLISTDIFF_CACHE_SIZE));
     strUsage += HelpMessageOpt("-onion=<ip:port>", strprintf(_("Use separate SOCKS5 proxy to reach peers via Tor hidden services (default: %s)"), "-proxy"));
     strUsage += HelpMessageOpt("-onlynet=<net>", _("Only connect to nodes in network <net> (ipv4, ipv6 or onion)"));
     strUsage += HelpMessageOpt("-permitbaremultisig", strprintf(_("Relay non-P2SH multisig (default: %u)"), DEFAULT_PERMIT_BAREMULTISIG));
@@ -534,6 +542,9 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-zmqpubrawtx=<address>", _("Enable publish raw transaction in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawtxlock=<address>", _("Enable publish raw transaction (locked via InstantSend) in <address>"));
     strUsage += HelpMessageOpt("-zmqpubrawinstantsenddoublespend=<address>", _("Enable publish raw transactions of attempted InstantSend double spend in <address>"));
+    strUsage += HelpMessageOpt("-zmqpub<type>hwm=<n>", strprintf(_("Set the outbound message high water mark of the -zmqpub<type> socket (default: %d)"), DEFAULT_ZMQ_SNDHWM));
+    strUsage += HelpMessageOpt("-zmqqueuesize=<n>", strprintf(_("Number of ZeroMQ messages waiting to be published before new ones get dropped (default: %d)"), DEFAULT_ZMQ_QUEUE_SIZE));
+    strUsage += HelpMessageOpt("-zmqbatchms=<n>", strprintf(_("Collect ZeroMQ messages for up to <n> milliseconds and publish them together, 0 publishes right away (default: %d, maximum: %d)"), DEFAULT_ZMQ_BATCH_MS, MAX_ZMQ_BATCH_MS));
 #endif
 
     strUsage += HelpMessageGroup(_("Debugging/Testing options:"));
@@ -644,8 +655,14 @@ std::string HelpMessage(HelpMessageMode mode)
     strUsage += HelpMessageOpt("-rpcport=<port>", strprintf(_("Listen for JSON-RPC connections on <port> (default: %u or testnet: %u)"), BaseParams(CBaseChainParams::MAIN).RPCPort(), BaseParams(CBaseChainParams::TESTNET).RPCPort()));
     strUsage += HelpMessageOpt("-rpcallowip=<ip>", _("Allow JSON-RPC connections from specified source. Valid for <ip> are a single IP (e.g. 1.2.3.4), a network/netmask (e.g. 1.2.3.4/255.255.255.0) or a network/CIDR (e.g. 1.2.3.4/24). This option can be specified multiple times"));
     strUsage += HelpMessageOpt("-rpcthreads=<n>", strprintf(_("Set the number of threads to service RPC calls (default: %d)"), DEFAULT_HTTP_THREADS));
+    strUsage += HelpMessageOpt("-rpccheapthreads=<n>", strprintf(_("Set the number of threads to service cheap RPC calls, like getblockcount (default: %d)"), DEFAULT_HTTP_CHEAP_THREADS));
+    strUsage += HelpMessageOpt("-rpcheavythreads=<n>", strprintf(_("Set the number of threads to service expensive RPC calls, like getaddresstxids or gobject (default: %d)"), DEFAULT_HTTP_HEAVY_THREADS));
+    strUsage += HelpMessageOpt("-rpcbatchthreads=<n>", strprintf(_("Set the max. number of threads executing the calls of a JSON-RPC batch request concurrently, if all of them are read-only (default: %d)"), DEFAULT_RPC_BATCH_THREADS));
+    strUsage += HelpMessageOpt("-rpcmethodclass=<method>:<class>", _("Serve calls to RPC method <method> with the threads of <class> (cheap, normal or heavy). This option can be specified multiple times"));
     if (showDebug) {
         strUsage += HelpMessageOpt("-rpcworkqueue=<n>", strprintf("Set the depth of the work queue to service RPC calls (default: %d)", DEFAULT_HTTP_WORKQUEUE));
+        strUsage += HelpMessageOpt("-rpccheapworkqueue=<n>", strprintf("Set the depth of the work queue to service cheap RPC calls (default: %d)", DEFAULT_HTTP_CHEAP_WORKQUEUE));
+        strUsage += HelpMessageOpt("-rpcheavyworkqueue=<n>", strprintf("Set the depth of the work queue to service expensive RPC calls (default: %d)", DEFAULT_HTTP_HEAVY_WORKQUEUE));
         strUsage += HelpMessageOpt("-rpcservertimeout=<n>", strprintf("Timeout during HTTP requests (default: %d)", DEFAULT_HTTP_SERVER_TIMEOUT));
     }
 
@@ -1227,6 +1244,9 @@ bool AppInitParameterInteraction()
 #ifdef ENABLE_WALLET
     RegisterWalletRPCCommands(tableRPC);
 #endif
+#if ENABLE_ZMQ
+    RegisterZMQRPCCommands(tableRPC);
+#endif
 
     nConnectTimeout = GetArg("-timeout", DEFAULT_CONNECT_TIMEOUT);
     if (nConnectTimeout <= 0)
@@ -1294,6 +1314,8 @@ bool AppInitParameterInteraction()
 
     nMaxTipAge = GetArg("-maxtipage", DEFAULT_MAX_TIP_AGE);
 
+    mnListDiffCache.SetMaxSize(std::max((int64_t)0, GetArg("-mnlistdiffcachesize", DEFAULT_MNLISTDIFF_CACHE_SIZE)) * 1024 * 1024);
+
     if (mapMultiArgs.count("-bip9params")) {
         // Allow overriding BIP9 parameters for testing
         if (!chainparams.MineBlocksOnDemand()) {
@@ -1706,8 +1728,30 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
     nTotalCache = std::max(nTotalCache, nMinDbCache << 20); // total cache cannot be less than nMinDbCache
     nTotalCache = std::min(nTotalCache, nMaxDbCache << 20); // total cache cannot be greater than nMaxDbcache
     int64_t nBlockTreeDBCache = nTotalCache / 8;
-    nBlockTreeDBCache = std::min(nBlockTreeDBCache, (GetBoolArg("-txindex", DEFAULT_TXINDEX) ? nMaxBlockDBAndTxIndexCache : nMaxBlockDBCache) << 20);
+    nBlockTreeDBCache = std::min(nBlockTreeDBCache, nMaxBlockDBCache << 20);
     nTotalCache -= nBlockTreeDBCache;
+    // the enabled optional indexes share another eighth, weighted by how much they are usually queried
+    CIndexDBCacheSizes indexDBCacheSizes;
+    {
+        const bool fTxIndexArg = GetBoolArg("-txindex", DEFAULT_TXINDEX);
+        const bool fAddressIndexArg = GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
+        const bool fSpentIndexArg = GetBoolArg("-spentindex", DEFAULT_SPENTINDEX);
+        const bool fTimestampIndexArg = GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
+        int nWeights = fTxIndexArg * 4 + fAddressIndexArg * 4 + fSpentIndexArg * 2 + fTimestampIndexArg;
+        if (nWeights > 0) {
+            int64_t nIndexDBCache = std::min(nTotalCache / 8, nMaxIndexDBCache << 20);
+            nTotalCache -= nIndexDBCache;
+            int64_t nMinCache = nDisabledIndexDBCache << 20;
+            if (fTxIndexArg)
+                indexDBCacheSizes.nTxIndex = std::max(nMinCache, nIndexDBCache * 4 / nWeights);
+            if (fAddressIndexArg)
+                indexDBCacheSizes.nAddressIndex = std::max(nMinCache, nIndexDBCache * 4 / nWeights);
+            if (fSpentIndexArg)
+                indexDBCacheSizes.nSpentIndex = std::max(nMinCache, nIndexDBCache * 2 / nWeights);
+            if (fTimestampIndexArg)
+                indexDBCacheSizes.nTimestampIndex = std::max(nMinCache, nIndexDBCache / nWeights);
+        }
+    }
     int64_t nCoinDBCache = std::min(nTotalCache / 2, (nTotalCache / 4) + (1 << 23)); // use 25%-50% of the remainder for disk cache
     nCoinDBCache = std::min(nCoinDBCache, nMaxCoinsDBCache << 20); // cap total coins db cache
     nTotalCache -= nCoinDBCache;
@@ -1716,6 +1760,7 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
     int64_t nEvoDbCache = 1024 * 1024 * 16; // TODO
     LogPrintf("Cache configuration:\n");
     LogPrintf("* Using %.1fMiB for block index database\n", nBlockTreeDBCache * (1.0 / 1024 / 1024));
+    LogPrintf("* Using %.1fMiB for index databases\n", (indexDBCacheSizes.nTxIndex + indexDBCacheSizes.nAddressIndex + indexDBCacheSizes.nSpentIndex + indexDBCacheSizes.nTimestampIndex) * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for chain state database\n", nCoinDBCache * (1.0 / 1024 / 1024));
     LogPrintf("* Using %.1fMiB for in-memory UTXO set (plus up to %.1fMiB of unused mempool space)\n", nCoinCacheUsage * (1.0 / 1024 / 1024), nMempoolSizeMax * (1.0 / 1024 / 1024));
 
@@ -1742,8 +1787,10 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
 
                 evoDb = new CEvoDB(nEvoDbCache, false, fReindex || fReindexChainState);
                 deterministicMNManager = new CDeterministicMNManager(*evoDb);
-                pblocktree = new CBlockTreeDB(nBlockTreeDBCache, false, fReindex);
-                pcoinsdbview = new CCoinsViewDB(nCoinDBCache, false, fReindex || fReindexChainState);
+                pblocktree = new CBlockTreeDB(nBlockTreeDBCache, false, fReindex, indexDBCacheSizes);
+                pcoinsdbview = new CCoinsViewDB(nCoinDBCache, false, fReindex || fReindexChainState, GetBoolArg("-asynccoinsflush", DEFAULT_ASYNC_COINS_FLUSH));
+                // EvoDB must never get ahead of the coins on disk, see FlushStateToDisk()
+                pcoinsdbview->SetAfterWriteHook([]() { return evoDb->CommitPendingTransaction(); });
                 pcoinscatcher = new CCoinsViewErrorCatcher(pcoinsdbview);
                 pcoinsTip = new CCoinsViewCache(pcoinscatcher);
                 llmq::InitLLMQSystem(*evoDb);
@@ -1759,6 +1806,10 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
                         strLoadError = _("Error upgrading chainstate database");
                         break;
                     }
+                    if (!pblocktree->MigrateIndexes()) {
+                        strLoadError = _("Error moving indexes out of the block database");
+                        break;
+                    }
                 }
                 if (fRequestShutdown) break;
 
@@ -1907,6 +1958,14 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
             vImportFiles.push_back(strFile);
     }
 
+    // Build indexes which were enabled after the chain was synced in the background instead of requiring -reindex
+    int nMissingIndexes = CIndexBuilder::GetMissingIndexes();
+    if (nMissingIndexes != 0) {
+        if (fPruneMode)
+            return InitError(_("Prune mode is incompatible with building -addressindex, -spentindex or -timestampindex, rebuild the database using -reindex instead"));
+        indexBuilder.Start(nMissingIndexes, GetArg("-indexbuildthreads", DEFAULT_INDEX_BUILD_THREADS));
+    }
+
     threadGroup.create_thread(boost::bind(&ThreadImport, vImportFiles));
 
     // Wait for genesis block to be processed
@@ -2093,6 +2152,9 @@ bool AppInitMain(boost::thread_group& threadGroup, CScheduler& scheduler)
 #endif // ENABLE_WALLET
     }
 
+    scheduler.scheduleEvery(boost::bind(&llmq::CDummyDKG::ProcessPendingMessages, llmq::quorumDummyDKG), 1);
+    scheduler.scheduleEvery(boost::bind(&CSimplifiedMNListDiffCache::PrecomputeDiffs, boost::ref(mnListDiffCache)), 1);
+
     // ********************************************************* Step 12: start node
 
     //// debug print
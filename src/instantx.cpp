@@ -779,6 +779,16 @@ bool CInstantSend::GetTxLockRequest(const uint256& txHash, CTxLockRequest& txLoc
     return true;
 }
 
+void CInstantSend::GetAcceptedLockRequestTxes(std::vector<CTransactionRef>& vtxRet)
+{
+    LOCK(cs_instantsend);
+
+    vtxRet.reserve(vtxRet.size() + mapLockRequestAccepted.size());
+    for (const auto& pair : mapLockRequestAccepted) {
+        vtxRet.emplace_back(pair.second.tx);
+    }
+}
+
 bool CInstantSend::GetTxLockVote(const uint256& hash, CTxLockVote& txLockVoteRet)
 {
     LOCK(cs_instantsend);
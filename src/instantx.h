@@ -130,6 +130,8 @@ public:
     void RejectLockRequest(const CTxLockRequest& txLockRequest);
     bool HasTxLockRequest(const uint256& txHash);
     bool GetTxLockRequest(const uint256& txHash, CTxLockRequest& txLockRequestRet);
+    /// Get transactions of all accepted lock requests (used for compact block reconstruction)
+    void GetAcceptedLockRequestTxes(std::vector<CTransactionRef>& vtxRet);
 
     bool GetTxLockVote(const uint256& hash, CTxLockVote& txLockVoteRet);
 
@@ -303,7 +303,7 @@ static bool GetKernelStakeModifier(uint256 hashBlockFrom, unsigned int nTimeTx,
 //   a proof-of-work situation.
 //
 
-bool CheckStakeKernelHash(unsigned int nBits, const CBlock& blockFrom, unsigned int nTxPrevOffset, const CTransactionRef& txPrev, const COutPoint& prevout, unsigned int nTimeTx, uint256& hashProofOfStake)
+bool CheckStakeKernelHash(unsigned int nBits, const CBlockHeader& blockFrom, unsigned int nTxPrevOffset, const CTransactionRef& txPrev, const COutPoint& prevout, unsigned int nTimeTx, uint256& hashProofOfStake)
 {
 
     auto txPrevTime = blockFrom.GetBlockTime();
@@ -392,10 +392,10 @@ bool CheckProofOfStake(const CBlock &block, uint256& hashProofOfStake)
         pindex = it->second;
     else
         return error("CheckProofOfStake() : read block failed");
-    // Read block header
-    CBlock blockprev;
-    if (!ReadBlockFromDisk(blockprev, pindex->GetBlockPos(), cons))
-        return error("CheckProofOfStake(): INFO: failed to find block");
+    // Only the header of the block containing txPrev is needed for the kernel hash, take it from
+    // the block index instead of reading the full block from disk. This keeps the proof-of-stake
+    // check (and thus the compact block announcement in AcceptBlock) away from disk reads.
+    CBlockHeader blockprev = pindex->GetBlockHeader();
     if(!CheckKernelScript(prevTxOut.scriptPubKey, tx->vout[1].scriptPubKey))
         return error("CheckProofOfStake() : INFO: check kernel script failed on coinstake %s, hashProof=%s \n", tx->GetHash().ToString().c_str(), hashProofOfStake.ToString().c_str());
     unsigned int nTime = block.nTime;
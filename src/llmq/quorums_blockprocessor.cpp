@@ -141,6 +141,23 @@ bool CQuorumBlockProcessor::ProcessBlock(const CBlock& block, const CBlockIndex*
         }
     }
 
+    // Verify the signatures of all commitments in parallel first. ProcessCommitment gets the results from the cache of
+    // verified commitments. Commitments failing the cheap checks are left to ProcessCommitment to reject
+    std::vector<std::future<bool>> sigChecks;
+    for (const auto& p : qcs) {
+        const auto& qc = p.second;
+        if (qc.IsNull() || qc.quorumHash.IsNull() || qc.quorumHash != GetQuorumBlockHash(p.first, pindex->nHeight)) {
+            continue;
+        }
+        auto members = CLLMQUtils::GetAllQuorumMembers(p.first, qc.quorumHash);
+        if (qc.Verify(members, false)) {
+            sigChecks.emplace_back(qc.AsyncVerifySigs(members));
+        }
+    }
+    for (auto& f : sigChecks) {
+        f.wait();
+    }
+
     for (auto& p : qcs) {
         auto& qc = p.second;
         if (!ProcessCommitment(pindex, qc, state)) {
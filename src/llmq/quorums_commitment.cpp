@@ -3,15 +3,19 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "quorums_commitment.h"
+#include "quorums_init.h"
 #include "quorums_utils.h"
 
 #include "chainparams.h"
 #include "validation.h"
 
+#include "bls/bls_worker.h"
 #include "evo/specialtx.h"
 
 #include <univalue.h>
 
+#include <atomic>
+
 namespace llmq
 {
 
@@ -27,6 +31,83 @@ CFinalCommitment::CFinalCommitment(const Consensus::LLMQParams& params, const ui
     LogPrintStr(strprintf("CFinalCommitment::%s -- %s", __func__, tinyformat::format(__VA_ARGS__))); \
 } while(0)
 
+// Results of the signature verification, keyed by the hash of the commitment. The quorum members are derived from
+// llmqType and quorumHash, so the result only depends on the commitment itself
+static const size_t MAX_VERIFIED_COMMITMENTS = 1000;
+static CCriticalSection cs_verifiedCommitments;
+static std::map<uint256, bool> mapVerifiedCommitments;
+
+static void AddVerifiedCommitment(const uint256& qcHash, bool valid)
+{
+    LOCK(cs_verifiedCommitments);
+    if (mapVerifiedCommitments.size() >= MAX_VERIFIED_COMMITMENTS) {
+        // keys are hashes, so this removes a random entry
+        mapVerifiedCommitments.erase(mapVerifiedCommitments.begin());
+    }
+    mapVerifiedCommitments.emplace(qcHash, valid);
+}
+
+std::future<bool> CFinalCommitment::AsyncVerifySigs(const std::vector<CDeterministicMNCPtr>& members) const
+{
+    uint256 qcHash = ::SerializeHash(*this);
+    {
+        LOCK(cs_verifiedCommitments);
+        auto it = mapVerifiedCommitments.find(qcHash);
+        if (it != mapVerifiedCommitments.end()) {
+            std::promise<bool> p;
+            p.set_value(it->second);
+            return p.get_future();
+        }
+    }
+
+    uint256 commitmentHash = CLLMQUtils::BuildCommitmentHash(llmqType, quorumHash, validMembers, quorumPublicKey, quorumVvecHash);
+
+    // the cache key commits to the operator keys, so a changed operator key never matches an old entry
+    CHashWriter hwPubKeys(SER_GETHASH, 0);
+    hwPubKeys << llmqType << quorumHash << DYNBITSET(signers);
+    std::vector<CBLSPublicKey> memberPubKeys;
+    for (size_t i = 0; i < members.size(); i++) {
+        if (!signers[i]) {
+            continue;
+        }
+        memberPubKeys.emplace_back(members[i]->pdmnState->pubKeyOperator.Get());
+        hwPubKeys << memberPubKeys.back().GetHash();
+    }
+
+    struct VerifyState {
+        std::atomic<int> nPending{2};
+        std::atomic<bool> fValid{true};
+        std::promise<bool> promise;
+    };
+    auto state = std::make_shared<VerifyState>();
+    auto done = [state, qcHash](bool valid) {
+        if (!valid) {
+            state->fValid = false;
+        }
+        if (--state->nPending == 0) {
+            AddVerifiedCommitment(qcHash, state->fValid);
+            state->promise.set_value(state->fValid);
+        }
+    };
+    auto ret = state->promise.get_future();
+
+    uint256 _quorumHash = quorumHash;
+    blsWorker->AsyncVerifySecureAggregatedSig(membersSig, memberPubKeys, commitmentHash, [done, _quorumHash](bool valid) {
+        if (!valid) {
+            LogPrintf("CFinalCommitment::AsyncVerifySigs -- invalid aggregated members signature, quorumHash=%s\n", _quorumHash.ToString());
+        }
+        done(valid);
+    }, &blsPubKeyAggregationCache, hwPubKeys.GetHash());
+    blsWorker->AsyncVerifySig(quorumSig, quorumPublicKey, commitmentHash, [done, _quorumHash](bool valid) {
+        if (!valid) {
+            LogPrintf("CFinalCommitment::AsyncVerifySigs -- invalid quorum signature, quorumHash=%s\n", _quorumHash.ToString());
+        }
+        done(valid);
+    });
+
+    return ret;
+}
+
 bool CFinalCommitment::Verify(const std::vector<CDeterministicMNCPtr>& members, bool checkSigs) const
 {
     if (nVersion == 0 || nVersion > CURRENT_VERSION) {
@@ -81,23 +162,8 @@ bool CFinalCommitment::Verify(const std::vector<CDeterministicMNCPtr>& members,
 
     // sigs are only checked when the block is processed
     if (checkSigs) {
-        uint256 commitmentHash = CLLMQUtils::BuildCommitmentHash((uint8_t)params.type, quorumHash, validMembers, quorumPublicKey, quorumVvecHash);
-
-        std::vector<CBLSPublicKey> memberPubKeys;
-        for (size_t i = 0; i < members.size(); i++) {
-            if (!signers[i]) {
-                continue;
-            }
-            memberPubKeys.emplace_back(members[i]->pdmnState->pubKeyOperator);
-        }
-
-        if (!membersSig.VerifySecureAggregated(memberPubKeys, commitmentHash)) {
-            LogPrintfFinalCommitment("invalid aggregated members signature\n");
-            return false;
-        }
-
-        if (!quorumSig.VerifyInsecure(quorumPublicKey, commitmentHash)) {
-            LogPrintfFinalCommitment("invalid quorum signature\n");
+        if (!AsyncVerifySigs(members).get()) {
+            LogPrintfFinalCommitment("invalid signatures\n");
             return false;
         }
     }
@@ -11,6 +11,8 @@
 
 #include "bls/bls.h"
 
+#include <future>
+
 namespace llmq
 {
 
@@ -49,6 +51,9 @@ public:
     }
 
     bool Verify(const std::vector<CDeterministicMNCPtr>& members, bool checkSigs) const;
+    // Verifies membersSig and quorumSig in parallel with blsWorker. Only valid after Verify(members, false) succeeded.
+    // Results are cached, so that commitments received via P2P or from a block checked before are not verified again
+    std::future<bool> AsyncVerifySigs(const std::vector<CDeterministicMNCPtr>& members) const;
     bool VerifyNull() const;
     bool VerifySizes(const Consensus::LLMQParams& params) const;
 
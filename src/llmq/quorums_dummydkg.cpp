@@ -6,8 +6,11 @@
 
 #include "quorums_blockprocessor.h"
 #include "quorums_commitment.h"
+#include "quorums_init.h"
 #include "quorums_utils.h"
 
+#include "bls/bls_worker.h"
+
 #include "evo/specialtx.h"
 
 #include "activemasternode.h"
@@ -47,7 +50,10 @@ void CDummyDKG::ProcessMessage(CNode* pfrom, const std::string& strCommand, CDat
             connman.RemoveAskFor(hash);
         }
 
-        ProcessDummyContribution(pfrom->id, qc);
+        LOCK(pendingCs);
+        if (PushPendingMessage(hash)) {
+            pendingContributions.emplace_back(pfrom->id, std::move(qc));
+        }
     } else if (strCommand == NetMsgType::QDCOMMITMENT) {
         if (!Params().GetConsensus().fLLMQAllowDummyCommitments) {
             Misbehaving(pfrom->id, 100);
@@ -66,11 +72,64 @@ void CDummyDKG::ProcessMessage(CNode* pfrom, const std::string& strCommand, CDat
             connman.RemoveAskFor(hash);
         }
 
-        ProcessDummyCommitment(pfrom->id, qc);
+        LOCK(pendingCs);
+        if (PushPendingMessage(hash)) {
+            pendingCommitments.emplace_back(pfrom->id, std::move(qc));
+        }
+    }
+}
+
+// pendingCs must be held while calling
+bool CDummyDKG::PushPendingMessage(const uint256& hash)
+{
+    AssertLockHeld(pendingCs);
+
+    if (pendingHashes.size() >= MAX_PENDING_MESSAGES) {
+        LogPrint("net", "CDummyDKG::%s -- too many pending messages, dropping %s\n", __func__, hash.ToString());
+        return false;
+    }
+    return pendingHashes.emplace(hash).second;
+}
+
+void CDummyDKG::ProcessPendingMessages()
+{
+    std::vector<std::pair<NodeId, CDummyContribution>> contributions;
+    std::vector<std::pair<NodeId, CDummyCommitment>> commitments;
+    {
+        LOCK(pendingCs);
+        contributions.swap(pendingContributions);
+        commitments.swap(pendingCommitments);
+    }
+
+    if (!contributions.empty()) {
+        ProcessDummyContributions(contributions);
+    }
+    if (!commitments.empty()) {
+        ProcessDummyCommitments(commitments);
+    }
+
+    // only forget about the hashes after processing, so that we don't request the same messages again in the meantime
+    LOCK(pendingCs);
+    for (const auto& p : contributions) {
+        pendingHashes.erase(::SerializeHash(p.second));
+    }
+    for (const auto& p : commitments) {
+        pendingHashes.erase(::SerializeHash(p.second));
     }
 }
 
 void CDummyDKG::ProcessDummyContribution(NodeId from, const llmq::CDummyContribution& qc)
+{
+    ProcessDummyContributions({std::make_pair(from, qc)});
+}
+
+void CDummyDKG::ProcessDummyCommitment(NodeId from, const llmq::CDummyCommitment& qc)
+{
+    ProcessDummyCommitments({std::make_pair(from, qc)});
+}
+
+// Performs all checks except signature verification. Returns the signer if the contribution should be verified
+CDeterministicMNCPtr CDummyDKG::PreVerifyDummyContribution(NodeId from, const llmq::CDummyContribution& qc)
 {
     if (!Params().GetConsensus().llmqs.count((Consensus::LLMQType)qc.llmqType)) {
         LOCK(cs_main);
@@ -79,7 +138,7 @@ void CDummyDKG::ProcessDummyContribution(NodeId from, const llmq::CDummyContribu
         if (from != -1) {
             Misbehaving(from, 100);
         }
-        return;
+        return nullptr;
     }
 
     auto type = (Consensus::LLMQType)qc.llmqType;
@@ -96,7 +155,7 @@ void CDummyDKG::ProcessDummyContribution(NodeId from, const llmq::CDummyContribu
     if (qc.quorumHash != quorumHash) {
         LogPrintf("CDummyDKG::%s -- dummy contrinution for wrong quorum, peer=%d\n", __func__,
                   from);
-        return;
+        return nullptr;
     }
 
     auto members = CLLMQUtils::GetAllQuorumMembers(type, qc.quorumHash);
@@ -107,7 +166,7 @@ void CDummyDKG::ProcessDummyContribution(NodeId from, const llmq::CDummyContribu
         if (from != -1) {
             Misbehaving(from, 100);
         }
-        return;
+        return nullptr;
     }
     if (qc.signer >= members.size()) {
         LOCK(cs_main);
@@ -116,7 +175,7 @@ void CDummyDKG::ProcessDummyContribution(NodeId from, const llmq::CDummyContribu
         if (from != -1) {
             Misbehaving(from, 100);
         }
-        return;
+        return nullptr;
     }
 
     auto signer = members[qc.signer];
@@ -124,36 +183,108 @@ void CDummyDKG::ProcessDummyContribution(NodeId from, const llmq::CDummyContribu
     {
         LOCK(sessionCs);
         if (curSessions[type].dummyContributionsFromMembers.count(signer->proTxHash)) {
-            return;
+            return nullptr;
         }
     }
 
-    // verify member sig
-    if (!qc.sig.VerifyInsecure(signer->pdmnState->pubKeyOperator, qc.GetSignHash())) {
-        LOCK(cs_main);
-        LogPrintf("CDummyDKG::%s -- invalid memberSig, peer=%d\n", __func__,
-                  from);
-        if (from != -1) {
-            Misbehaving(from, 100);
+    return signer;
+}
+
+void CDummyDKG::ProcessDummyContributions(const std::vector<std::pair<NodeId, CDummyContribution>>& qcs)
+{
+    std::vector<std::pair<NodeId, CDummyContribution>> toVerify;
+    std::vector<CDeterministicMNCPtr> signers;
+
+    for (const auto& p : qcs) {
+        auto signer = PreVerifyDummyContribution(p.first, p.second);
+        if (!signer) {
+            continue;
         }
+        // Multiple contributions of the same member are all verified, as an invalid one must not shadow a valid one.
+        // Only the first valid contribution is accepted (see ProcessPreVerifiedContributions)
+        toVerify.emplace_back(p);
+        signers.emplace_back(signer);
+    }
+    if (toVerify.empty()) {
         return;
     }
 
-    LogPrintf("CDummyDKG::%s -- processed dummy contribution for quorum %s:%d, signer=%d, peer=%d\n", __func__,
-              qc.quorumHash.ToString(), qc.llmqType, qc.signer, from);
+    ProcessPreVerifiedContributions(toVerify, signers);
+}
 
-    uint256 hash = ::SerializeHash(qc);
-    {
-        LOCK(sessionCs);
-        curSessions[type].dummyContributions[hash] = qc;
-        curSessions[type].dummyContributionsFromMembers[signer->proTxHash] = hash;
+void CDummyDKG::ProcessPreVerifiedContributions(const std::vector<std::pair<NodeId, CDummyContribution>>& qcs,
+                                                const std::vector<CDeterministicMNCPtr>& signers)
+{
+    assert(qcs.size() == signers.size());
+
+    std::vector<CDummyContribution> qcsToVerify;
+    BLSPublicKeyVector pubKeys;
+    qcsToVerify.reserve(qcs.size());
+    pubKeys.reserve(qcs.size());
+    for (size_t i = 0; i < qcs.size(); i++) {
+        qcsToVerify.emplace_back(qcs[i].second);
+        pubKeys.emplace_back(signers[i]->pdmnState->pubKeyOperator.Get());
+    }
+
+    // verify member sigs
+    auto valid = VerifyContributionSigs(*blsWorker, qcsToVerify, pubKeys);
+
+    for (size_t i = 0; i < qcs.size(); i++) {
+        NodeId from = qcs[i].first;
+        const auto& qc = qcs[i].second;
+        const auto& signer = signers[i];
+
+        if (!valid[i]) {
+            LOCK(cs_main);
+            LogPrintf("CDummyDKG::%s -- invalid memberSig, peer=%d\n", __func__,
+                      from);
+            if (from != -1) {
+                Misbehaving(from, 100);
+            }
+            continue;
+        }
+
+        uint256 hash = ::SerializeHash(qc);
+        {
+            LOCK(sessionCs);
+            auto& session = curSessions[(Consensus::LLMQType)qc.llmqType];
+            // only the first valid contribution of a member is accepted
+            if (!session.dummyContributionsFromMembers.emplace(signer->proTxHash, hash).second) {
+                continue;
+            }
+            session.dummyContributions[hash] = qc;
+        }
+
+        LogPrintf("CDummyDKG::%s -- processed dummy contribution for quorum %s:%d, signer=%d, peer=%d\n", __func__,
+                  qc.quorumHash.ToString(), qc.llmqType, qc.signer, from);
+
+        CInv inv(MSG_QUORUM_DUMMY_CONTRIBUTION, hash);
+        g_connman->RelayInv(inv, DMN_PROTO_VERSION);
+    }
+}
+
+std::vector<bool> CDummyDKG::VerifyContributionSigs(CBLSWorker& worker, const std::vector<CDummyContribution>& qcs,
+                                                    const BLSPublicKeyVector& pubKeys)
+{
+    assert(qcs.size() == pubKeys.size());
+
+    // Every sig is verified on its own (in parallel by the worker). An aggregated check can't tell which sig of a batch
+    // is invalid, so a peer is only punished for a sig that failed its own verification
+    std::vector<std::future<bool> > futures;
+    futures.reserve(qcs.size());
+    for (size_t i = 0; i < qcs.size(); i++) {
+        futures.emplace_back(worker.AsyncVerifySig(qcs[i].sig, pubKeys[i], qcs[i].GetSignHash()));
     }
 
-    CInv inv(MSG_QUORUM_DUMMY_CONTRIBUTION, hash);
-    g_connman->RelayInv(inv, DMN_PROTO_VERSION);
+    std::vector<bool> ret(qcs.size());
+    for (size_t i = 0; i < qcs.size(); i++) {
+        ret[i] = futures[i].get();
+    }
+    return ret;
 }
 
-void CDummyDKG::ProcessDummyCommitment(NodeId from, const llmq::CDummyCommitment& qc)
+// Performs all checks except signature verification. Returns the signer if the commitment should be verified
+CDeterministicMNCPtr CDummyDKG::PreVerifyDummyCommitment(NodeId from, const llmq::CDummyCommitment& qc)
 {
     if (!Params().GetConsensus().llmqs.count((Consensus::LLMQType)qc.llmqType)) {
         LOCK(cs_main);
@@ -162,7 +293,7 @@ void CDummyDKG::ProcessDummyCommitment(NodeId from, const llmq::CDummyCommitment
         if (from != -1) {
             Misbehaving(from, 100);
         }
-        return;
+        return nullptr;
     }
 
     auto type = (Consensus::LLMQType)qc.llmqType;
@@ -175,7 +306,7 @@ void CDummyDKG::ProcessDummyCommitment(NodeId from, const llmq::CDummyCommitment
         if (from != -1) {
             Misbehaving(from, 100);
         }
-        return;
+        return nullptr;
     }
 
     int curQuorumHeight;
@@ -189,7 +320,7 @@ void CDummyDKG::ProcessDummyCommitment(NodeId from, const llmq::CDummyCommitment
     if (qc.quorumHash != quorumHash) {
         LogPrintf("CDummyDKG::%s -- dummy commitment for wrong quorum, peer=%d\n", __func__,
                   from);
-        return;
+        return nullptr;
     }
 
     auto members = CLLMQUtils::GetAllQuorumMembers(type, qc.quorumHash);
@@ -200,7 +331,7 @@ void CDummyDKG::ProcessDummyCommitment(NodeId from, const llmq::CDummyCommitment
         if (from != -1) {
             Misbehaving(from, 100);
         }
-        return;
+        return nullptr;
     }
     if (qc.signer >= members.size()) {
         LOCK(cs_main);
@@ -209,7 +340,7 @@ void CDummyDKG::ProcessDummyCommitment(NodeId from, const llmq::CDummyCommitment
         if (from != -1) {
             Misbehaving(from, 100);
         }
-        return;
+        return nullptr;
     }
     if (qc.CountValidMembers() < params.minSize) {
         LOCK(cs_main);
@@ -218,72 +349,168 @@ void CDummyDKG::ProcessDummyCommitment(NodeId from, const llmq::CDummyCommitment
         if (from != -1) {
             Misbehaving(from, 100);
         }
-        return;
+        return nullptr;
     }
 
     auto signer = members[qc.signer];
 
     {
         LOCK(sessionCs);
-        for (const auto& p : curSessions[type].dummyCommitmentsFromMembers) {
-            if (p.second.count(signer->proTxHash)) {
-                return;
-            }
+        if (HasCommitmentFromMember(curSessions[type], signer->proTxHash)) {
+            return nullptr;
         }
     }
 
-    auto svec = BuildDeterministicSvec(type, qc.quorumHash);
-    auto vvec = BuildVvec(svec);
-    auto vvecHash = ::SerializeHash(vvec);
+    return signer;
+}
+
+void CDummyDKG::ProcessDummyCommitments(const std::vector<std::pair<NodeId, CDummyCommitment>>& qcs)
+{
+    struct QuorumVvec {
+        BLSVerificationVectorPtr vvec;
+        uint256 vvecHash;
+    };
+    // the (insecure) verification vector is the same for all commitments of a quorum, so it's only built once per batch
+    std::map<std::pair<uint8_t, uint256>, QuorumVvec> vvecs;
+
+    std::vector<std::pair<NodeId, CDummyCommitment>> toVerify;
+    std::vector<CDeterministicMNCPtr> signers;
+    std::vector<uint256> commitmentHashes;
+    BLSPublicKeyVector sharePubKeys;
+
+    for (const auto& p : qcs) {
+        NodeId from = p.first;
+        const auto& qc = p.second;
+
+        auto signer = PreVerifyDummyCommitment(from, qc);
+        if (!signer) {
+            continue;
+        }
+        // Multiple commitments of the same member are all verified, as an invalid one must not shadow a valid one.
+        // Only the first valid commitment is accepted (see ProcessPreVerifiedCommitments)
 
-    auto commitmentHash = CLLMQUtils::BuildCommitmentHash((uint8_t)type, qc.quorumHash, qc.validMembers, vvec[0], vvecHash);
+        auto type = (Consensus::LLMQType)qc.llmqType;
+        auto it = vvecs.find(std::make_pair(qc.llmqType, qc.quorumHash));
+        if (it == vvecs.end()) {
+            QuorumVvec v;
+            v.vvec = std::make_shared<BLSVerificationVector>(BuildVvec(BuildDeterministicSvec(type, qc.quorumHash)));
+            v.vvecHash = ::SerializeHash(*v.vvec);
+            it = vvecs.emplace(std::make_pair(qc.llmqType, qc.quorumHash), v).first;
+        }
+        const auto& vvec = *it->second.vvec;
 
-    // verify member sig
-    if (!qc.membersSig.VerifyInsecure(signer->pdmnState->pubKeyOperator, commitmentHash)) {
-        LOCK(cs_main);
-        LogPrintf("CDummyDKG::%s -- invalid memberSig, peer=%d\n", __func__,
-                  from);
-        if (from != -1) {
-            Misbehaving(from, 100);
+        // recover public key share
+        CBLSPublicKey sharePk = blsWorker->BuildPubKeyShare(it->second.vvec, CBLSId::FromHash(signer->proTxHash));
+        if (!sharePk.IsValid()) {
+            LOCK(cs_main);
+            LogPrintf("CDummyDKG::%s -- failed to recover public key share, peer=%d\n", __func__,
+                      from);
+            if (from != -1) {
+                Misbehaving(from, 100);
+            }
+            continue;
         }
+
+        toVerify.emplace_back(p);
+        signers.emplace_back(signer);
+        commitmentHashes.emplace_back(CLLMQUtils::BuildCommitmentHash(qc.llmqType, qc.quorumHash, qc.validMembers, vvec[0], it->second.vvecHash));
+        sharePubKeys.emplace_back(sharePk);
+    }
+    if (toVerify.empty()) {
         return;
     }
 
-    // recover public key share
-    CBLSPublicKey sharePk;
-    if (!sharePk.PublicKeyShare(vvec, CBLSId::FromHash(signer->proTxHash))) {
-        LOCK(cs_main);
-        LogPrintf("CDummyDKG::%s -- failed to recover public key share, peer=%d\n", __func__,
-                  from);
-        if (from != -1) {
-            Misbehaving(from, 100);
+    ProcessPreVerifiedCommitments(toVerify, signers, commitmentHashes, sharePubKeys);
+}
+
+void CDummyDKG::ProcessPreVerifiedCommitments(const std::vector<std::pair<NodeId, CDummyCommitment>>& qcs,
+                                              const std::vector<CDeterministicMNCPtr>& signers,
+                                              const std::vector<uint256>& commitmentHashes,
+                                              const BLSPublicKeyVector& sharePubKeys)
+{
+    assert(qcs.size() == signers.size() && qcs.size() == commitmentHashes.size() && qcs.size() == sharePubKeys.size());
+
+    std::vector<CDummyCommitment> qcsToVerify;
+    BLSPublicKeyVector pubKeys;
+    qcsToVerify.reserve(qcs.size());
+    pubKeys.reserve(qcs.size());
+    for (size_t i = 0; i < qcs.size(); i++) {
+        qcsToVerify.emplace_back(qcs[i].second);
+        pubKeys.emplace_back(signers[i]->pdmnState->pubKeyOperator.Get());
+    }
+
+    // verify member sigs and sig shares
+    auto valid = VerifyCommitmentSigs(*blsWorker, qcsToVerify, commitmentHashes, pubKeys, sharePubKeys);
+
+    for (size_t i = 0; i < qcs.size(); i++) {
+        NodeId from = qcs[i].first;
+        const auto& qc = qcs[i].second;
+        const auto& signer = signers[i];
+
+        if (!valid[i]) {
+            LOCK(cs_main);
+            LogPrintf("CDummyDKG::%s -- invalid memberSig or quorumSig, peer=%d\n", __func__,
+                      from);
+            if (from != -1) {
+                Misbehaving(from, 100);
+            }
+            continue;
         }
-        return;
+
+        uint256 hash = ::SerializeHash(qc);
+        {
+            LOCK(sessionCs);
+            auto& session = curSessions[(Consensus::LLMQType)qc.llmqType];
+            // only the first valid commitment of a member is accepted
+            if (HasCommitmentFromMember(session, signer->proTxHash)) {
+                continue;
+            }
+            session.dummyCommitments[hash] = qc;
+            session.dummyCommitmentsFromMembers[commitmentHashes[i]][signer->proTxHash] = hash;
+        }
+
+        LogPrintf("CDummyDKG::%s -- processed dummy commitment for quorum %s:%d, validMembers=%d, signer=%d, peer=%d\n", __func__,
+                  qc.quorumHash.ToString(), qc.llmqType, qc.CountValidMembers(), qc.signer, from);
+
+        CInv inv(MSG_QUORUM_DUMMY_COMMITMENT, hash);
+        g_connman->RelayInv(inv, DMN_PROTO_VERSION);
     }
+}
 
-    // verify sig share
-    if (!qc.quorumSig.VerifyInsecure(sharePk, commitmentHash)) {
-        LOCK(cs_main);
-        LogPrintf("CDummyDKG::%s -- invalid quorumSig, peer=%d\n", __func__,
-                  from);
-        if (from != -1) {
-            Misbehaving(from, 100);
+// sessionCs must be held while calling
+bool CDummyDKG::HasCommitmentFromMember(const CDummyDKGSession& session, const uint256& proTxHash)
+{
+    AssertLockHeld(sessionCs);
+
+    for (const auto& p : session.dummyCommitmentsFromMembers) {
+        if (p.second.count(proTxHash)) {
+            return true;
         }
-        return;
     }
+    return false;
+}
 
-    LogPrintf("CDummyDKG::%s -- processed dummy commitment for quorum %s:%d, validMembers=%d, signer=%d, peer=%d\n", __func__,
-              qc.quorumHash.ToString(), qc.llmqType, qc.CountValidMembers(), qc.signer, from);
+std::vector<bool> CDummyDKG::VerifyCommitmentSigs(CBLSWorker& worker, const std::vector<CDummyCommitment>& qcs,
+                                                  const std::vector<uint256>& commitmentHashes,
+                                                  const BLSPublicKeyVector& pubKeys, const BLSPublicKeyVector& sharePubKeys)
+{
+    assert(qcs.size() == commitmentHashes.size() && qcs.size() == pubKeys.size() && qcs.size() == sharePubKeys.size());
 
-    uint256 hash = ::SerializeHash(qc);
-    {
-        LOCK(sessionCs);
-        curSessions[type].dummyCommitments[hash] = qc;
-        curSessions[type].dummyCommitmentsFromMembers[commitmentHash][signer->proTxHash] = hash;
+    // Both sigs of every commitment are verified on their own (in parallel by the worker), see VerifyContributionSigs
+    std::vector<std::future<bool> > membersSigFutures;
+    std::vector<std::future<bool> > quorumSigFutures;
+    membersSigFutures.reserve(qcs.size());
+    quorumSigFutures.reserve(qcs.size());
+    for (size_t i = 0; i < qcs.size(); i++) {
+        membersSigFutures.emplace_back(worker.AsyncVerifySig(qcs[i].membersSig, pubKeys[i], commitmentHashes[i]));
+        quorumSigFutures.emplace_back(worker.AsyncVerifySig(qcs[i].quorumSig, sharePubKeys[i], commitmentHashes[i]));
     }
 
-    CInv inv(MSG_QUORUM_DUMMY_COMMITMENT, hash);
-    g_connman->RelayInv(inv, DMN_PROTO_VERSION);
+    std::vector<bool> ret(qcs.size());
+    for (size_t i = 0; i < qcs.size(); i++) {
+        ret[i] = membersSigFutures[i].get() && quorumSigFutures[i].get();
+    }
+    return ret;
 }
 
 void CDummyDKG::UpdatedBlockTip(const CBlockIndex* pindex, bool fInitialDownload)
@@ -471,7 +698,7 @@ void CDummyDKG::CreateFinalCommitment(Consensus::LLMQType llmqType, const CBlock
                 quorumSigIds.emplace_back(CBLSId::FromHash(proTxHash));
             }
             memberSigs.emplace_back(qc.membersSig);
-            memberPubKeys.emplace_back(members[signerIdx]->pdmnState->pubKeyOperator);
+            memberPubKeys.emplace_back(members[signerIdx]->pdmnState->pubKeyOperator.Get());
         }
 
         if (!fqc.quorumSig.Recover(quorumSigs, quorumSigIds)) {
@@ -557,6 +784,14 @@ BLSPublicKeyVector CDummyDKG::BuildVvec(const BLSSecretKeyVector& svec)
 
 bool CDummyDKG::HasDummyContribution(const uint256& hash)
 {
+    {
+        // don't request messages again that are waiting for verification
+        LOCK(pendingCs);
+        if (pendingHashes.count(hash)) {
+            return true;
+        }
+    }
+
     LOCK(sessionCs);
     for (const auto& p : curSessions) {
         auto it = p.second.dummyContributions.find(hash);
@@ -582,6 +817,13 @@ bool CDummyDKG::GetDummyContribution(const uint256& hash, CDummyContribution& re
 
 bool CDummyDKG::HasDummyCommitment(const uint256& hash)
 {
+    {
+        LOCK(pendingCs);
+        if (pendingHashes.count(hash)) {
+            return true;
+        }
+    }
+
     LOCK(sessionCs);
     for (const auto& p : curSessions) {
         auto it = p.second.dummyCommitments.find(hash);
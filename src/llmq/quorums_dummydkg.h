@@ -15,7 +15,9 @@
 #include "bls/bls.h"
 
 #include <map>
+#include <set>
 
+class CBLSWorker;
 class CNode;
 class CConnman;
 
@@ -126,13 +128,42 @@ public:
 class CDummyDKG
 {
 private:
+    // Large quorums produce hundreds of messages per phase, so we don't verify them one by one when they arrive.
+    // Instead, they are queued here and ProcessPendingMessages verifies all of them in one parallel pass
+    static const size_t MAX_PENDING_MESSAGES = 10000;
+
     CCriticalSection sessionCs;
     std::map<Consensus::LLMQType, CDummyDKGSession> curSessions;
 
+    CCriticalSection pendingCs;
+    std::vector<std::pair<NodeId, CDummyContribution>> pendingContributions;
+    std::vector<std::pair<NodeId, CDummyCommitment>> pendingCommitments;
+    std::set<uint256> pendingHashes;
+
 public:
     void ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStream& vRecv, CConnman& connman);
+    void ProcessPendingMessages();
     void ProcessDummyContribution(NodeId from, const CDummyContribution& qc);
     void ProcessDummyCommitment(NodeId from, const CDummyCommitment& qc);
+    void ProcessDummyContributions(const std::vector<std::pair<NodeId, CDummyContribution>>& qcs);
+    void ProcessDummyCommitments(const std::vector<std::pair<NodeId, CDummyCommitment>>& qcs);
+    // Verify the sigs of messages which passed all other checks and accept the valid ones. signers[i] is the member
+    // that signed qcs[i]. Only the first valid message of a member is accepted
+    void ProcessPreVerifiedContributions(const std::vector<std::pair<NodeId, CDummyContribution>>& qcs,
+                                         const std::vector<CDeterministicMNCPtr>& signers);
+    void ProcessPreVerifiedCommitments(const std::vector<std::pair<NodeId, CDummyCommitment>>& qcs,
+                                       const std::vector<CDeterministicMNCPtr>& signers,
+                                       const std::vector<uint256>& commitmentHashes,
+                                       const BLSPublicKeyVector& sharePubKeys);
+
+    // Verifies the sigs of many contributions in parallel, each sig on its own. pubKeys[i] is the operator key of the signer of qcs[i]
+    static std::vector<bool> VerifyContributionSigs(CBLSWorker& worker, const std::vector<CDummyContribution>& qcs,
+                                                    const BLSPublicKeyVector& pubKeys);
+    // Verifies membersSig and quorumSig of many commitments in parallel, each sig on its own. pubKeys[i] and sharePubKeys[i] are
+    // the operator key and the public key share of the signer of qcs[i], commitmentHashes[i] is the hash it signed
+    static std::vector<bool> VerifyCommitmentSigs(CBLSWorker& worker, const std::vector<CDummyCommitment>& qcs,
+                                                  const std::vector<uint256>& commitmentHashes,
+                                                  const BLSPublicKeyVector& pubKeys, const BLSPublicKeyVector& sharePubKeys);
 
     void UpdatedBlockTip(const CBlockIndex* pindex, bool fInitialDownload);
     void CreateDummyContribution(Consensus::LLMQType llmqType, const CBlockIndex* pindex);
@@ -145,6 +176,11 @@ public:
     bool GetDummyCommitment(const uint256& hash, CDummyCommitment& ret);
 
 private:
+    bool PushPendingMessage(const uint256& hash);
+    CDeterministicMNCPtr PreVerifyDummyContribution(NodeId from, const CDummyContribution& qc);
+    CDeterministicMNCPtr PreVerifyDummyCommitment(NodeId from, const CDummyCommitment& qc);
+    bool HasCommitmentFromMember(const CDummyDKGSession& session, const uint256& proTxHash);
+
     std::vector<bool> GetValidMembers(Consensus::LLMQType llmqType, const std::vector<CDeterministicMNCPtr>& members);
     BLSSecretKeyVector BuildDeterministicSvec(Consensus::LLMQType llmqType, const uint256& quorumHash);
     BLSPublicKeyVector BuildVvec(const BLSSecretKeyVector& svec);
@@ -8,21 +8,37 @@
 #include "quorums_commitment.h"
 #include "quorums_dummydkg.h"
 
+#include "bls/bls_worker.h"
+
 namespace llmq
 {
 
+// an aggregated public key needs a few hundred bytes, so this is well below 1 MB
+static const size_t PUBKEY_AGGREGATION_CACHE_SIZE = 1000;
+
+// declared before blsWorker, as jobs of the worker use it
+CBLSPubKeyAggregationCache blsPubKeyAggregationCache(PUBKEY_AGGREGATION_CACHE_SIZE);
+CBLSWorker* blsWorker;
+
 void InitLLMQSystem(CEvoDB& evoDb)
 {
+    blsWorker = new CBLSWorker();
     quorumBlockProcessor = new CQuorumBlockProcessor(evoDb);
     quorumDummyDKG = new CDummyDKG();
 }
 
 void DestroyLLMQSystem()
 {
+    // no worker jobs may run while the objects they use are destroyed
+    if (blsWorker) {
+        blsWorker->Stop();
+    }
     delete quorumDummyDKG;
     quorumDummyDKG = nullptr;
     delete quorumBlockProcessor;
     quorumBlockProcessor = nullptr;
+    delete blsWorker;
+    blsWorker = nullptr;
 }
 
 }
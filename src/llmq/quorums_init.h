@@ -5,11 +5,18 @@
 #ifndef DASH_QUORUMS_INIT_H
 #define DASH_QUORUMS_INIT_H
 
+class CBLSPubKeyAggregationCache;
+class CBLSWorker;
 class CEvoDB;
 
 namespace llmq
 {
 
+// aggregated operator keys of quorum signers
+extern CBLSPubKeyAggregationCache blsPubKeyAggregationCache;
+// used to verify the BLS signatures of quorum commitments in parallel. Only exists between InitLLMQSystem and DestroyLLMQSystem
+extern CBLSWorker* blsWorker;
+
 void InitLLMQSystem(CEvoDB& evoDb);
 void DestroyLLMQSystem();
 
@@ -388,7 +388,7 @@ void CMasternodeMan::AddDeterministicMasternodes()
 
             // make sure we use the splitted keys from now on
             mn->keyIDOwner = dmn->pdmnState->keyIDOwner;
-            mn->blsPubKeyOperator = dmn->pdmnState->pubKeyOperator;
+            mn->blsPubKeyOperator = dmn->pdmnState->pubKeyOperator.Get();
             mn->keyIDVoting = dmn->pdmnState->keyIDVoting;
             mn->addr = dmn->pdmnState->addr;
             mn->nProtocolVersion = DMN_PROTO_VERSION;
@@ -0,0 +1,185 @@
+// Copyright (c) 2019 The Polis Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "mempoolindex.h"
+
+#include "hash.h"
+#include "random.h"
+
+#include <boost/thread/locks.hpp>
+
+CMempoolAddressIndex::AddressKeyHasher::AddressKeyHasher() :
+    k0(GetRand(std::numeric_limits<uint64_t>::max())),
+    k1(GetRand(std::numeric_limits<uint64_t>::max()))
+{
+}
+
+size_t CMempoolAddressIndex::AddressKeyHasher::operator()(const AddressKey& key) const
+{
+    return CSipHasher(k0, k1).Write(key.first).Write(key.second.begin(), key.second.size()).Finalize();
+}
+
+void CMempoolAddressIndex::Add(const uint256& txhash, const std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> >& deltas)
+{
+    std::vector<CMempoolAddressDeltaKey> inserted;
+    inserted.reserve(deltas.size());
+
+    for (const auto& p : deltas) {
+        AddressKey addressKey(p.first.type, p.first.addressBytes);
+        Shard& shard = GetShard(addressKey);
+        {
+            boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+            shard.mapDeltas[addressKey].insert(p);
+        }
+        inserted.emplace_back(p.first);
+    }
+
+    LOCK(cs_inserted);
+    mapInserted.emplace(txhash, std::move(inserted));
+}
+
+void CMempoolAddressIndex::Remove(const uint256& txhash)
+{
+    std::vector<CMempoolAddressDeltaKey> keys;
+    {
+        LOCK(cs_inserted);
+        auto it = mapInserted.find(txhash);
+        if (it == mapInserted.end()) {
+            return;
+        }
+        keys = std::move(it->second);
+        mapInserted.erase(it);
+    }
+
+    for (const auto& key : keys) {
+        AddressKey addressKey(key.type, key.addressBytes);
+        Shard& shard = GetShard(addressKey);
+        boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+        auto it = shard.mapDeltas.find(addressKey);
+        if (it == shard.mapDeltas.end()) {
+            continue;
+        }
+        it->second.erase(key);
+        if (it->second.empty()) {
+            shard.mapDeltas.erase(it);
+        }
+    }
+}
+
+void CMempoolAddressIndex::Get(const std::vector<std::pair<uint160, int> >& addresses,
+                               std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> >& results) const
+{
+    for (const auto& address : addresses) {
+        AddressKey addressKey(address.second, address.first);
+        const Shard& shard = GetShard(addressKey);
+        boost::shared_lock<boost::shared_mutex> lock(shard.mutex);
+        auto it = shard.mapDeltas.find(addressKey);
+        if (it != shard.mapDeltas.end()) {
+            results.insert(results.end(), it->second.begin(), it->second.end());
+        }
+    }
+}
+
+void CMempoolAddressIndex::Clear()
+{
+    LOCK(cs_inserted);
+    for (auto& shard : shards) {
+        boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+        shard.mapDeltas.clear();
+    }
+    mapInserted.clear();
+}
+
+size_t CMempoolAddressIndex::Size() const
+{
+    size_t nSize = 0;
+    for (const auto& shard : shards) {
+        boost::shared_lock<boost::shared_mutex> lock(shard.mutex);
+        for (const auto& p : shard.mapDeltas) {
+            nSize += p.second.size();
+        }
+    }
+    return nSize;
+}
+
+CMempoolSpentIndex::SpentKeyHasher::SpentKeyHasher() :
+    k0(GetRand(std::numeric_limits<uint64_t>::max())),
+    k1(GetRand(std::numeric_limits<uint64_t>::max()))
+{
+}
+
+size_t CMempoolSpentIndex::SpentKeyHasher::operator()(const CSpentIndexKey& key) const
+{
+    return SipHashUint256Extra(k0, k1, key.txid, key.outputIndex);
+}
+
+void CMempoolSpentIndex::Add(const uint256& txhash, const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >& entries)
+{
+    std::vector<CSpentIndexKey> inserted;
+    inserted.reserve(entries.size());
+
+    for (const auto& p : entries) {
+        Shard& shard = GetShard(p.first);
+        {
+            boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+            shard.mapSpent.insert(p);
+        }
+        inserted.emplace_back(p.first);
+    }
+
+    LOCK(cs_inserted);
+    mapInserted.emplace(txhash, std::move(inserted));
+}
+
+void CMempoolSpentIndex::Remove(const uint256& txhash)
+{
+    std::vector<CSpentIndexKey> keys;
+    {
+        LOCK(cs_inserted);
+        auto it = mapInserted.find(txhash);
+        if (it == mapInserted.end()) {
+            return;
+        }
+        keys = std::move(it->second);
+        mapInserted.erase(it);
+    }
+
+    for (const auto& key : keys) {
+        Shard& shard = GetShard(key);
+        boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+        shard.mapSpent.erase(key);
+    }
+}
+
+bool CMempoolSpentIndex::Get(const CSpentIndexKey& key, CSpentIndexValue& valueRet) const
+{
+    const Shard& shard = GetShard(key);
+    boost::shared_lock<boost::shared_mutex> lock(shard.mutex);
+    auto it = shard.mapSpent.find(key);
+    if (it == shard.mapSpent.end()) {
+        return false;
+    }
+    valueRet = it->second;
+    return true;
+}
+
+void CMempoolSpentIndex::Clear()
+{
+    LOCK(cs_inserted);
+    for (auto& shard : shards) {
+        boost::unique_lock<boost::shared_mutex> lock(shard.mutex);
+        shard.mapSpent.clear();
+    }
+    mapInserted.clear();
+}
+
+size_t CMempoolSpentIndex::Size() const
+{
+    size_t nSize = 0;
+    for (const auto& shard : shards) {
+        boost::shared_lock<boost::shared_mutex> lock(shard.mutex);
+        nSize += shard.mapSpent.size();
+    }
+    return nSize;
+}
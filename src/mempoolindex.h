@@ -0,0 +1,122 @@
+// Copyright (c) 2019 The Polis Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef POLIS_MEMPOOLINDEX_H
+#define POLIS_MEMPOOLINDEX_H
+
+#include "addressindex.h"
+#include "spentindex.h"
+#include "sync.h"
+#include "uint256.h"
+
+#include <array>
+#include <map>
+#include <unordered_map>
+#include <vector>
+
+#include <boost/thread/shared_mutex.hpp>
+
+/**
+ * Mempool side of -addressindex.
+ *
+ * Entries are spread over a fixed number of shards by (salted) address hash. Every shard is
+ * guarded by its own shared mutex, so lookups (e.g. getaddressmempool) only take a shared lock
+ * on the shards of the requested addresses and never need the mempool lock. Writers only hold
+ * the exclusive lock of a single shard for the duration of a few map operations, so readers and
+ * AcceptToMemoryPool don't block each other unless they touch the same shard at the same time.
+ * As a consequence, a reader might see only part of the deltas of a transaction which is being
+ * added or removed concurrently.
+ */
+class CMempoolAddressIndex
+{
+public:
+    static const size_t SHARD_COUNT = 32;
+
+private:
+    // (type, addressBytes)
+    typedef std::pair<int, uint160> AddressKey;
+
+    struct AddressKeyHasher
+    {
+        const uint64_t k0, k1;
+        AddressKeyHasher();
+        size_t operator()(const AddressKey& key) const;
+    };
+
+    typedef std::map<CMempoolAddressDeltaKey, CMempoolAddressDelta, CMempoolAddressDeltaKeyCompare> DeltaMap;
+
+    struct Shard
+    {
+        mutable boost::shared_mutex mutex;
+        std::unordered_map<AddressKey, DeltaMap, AddressKeyHasher> mapDeltas;
+    };
+
+    AddressKeyHasher hasher;
+    std::array<Shard, SHARD_COUNT> shards;
+
+    // only needed by writers to find the keys of a removed transaction
+    CCriticalSection cs_inserted;
+    std::map<uint256, std::vector<CMempoolAddressDeltaKey> > mapInserted;
+
+    Shard& GetShard(const AddressKey& key) { return shards[hasher(key) % SHARD_COUNT]; }
+    const Shard& GetShard(const AddressKey& key) const { return shards[hasher(key) % SHARD_COUNT]; }
+
+public:
+    void Add(const uint256& txhash, const std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> >& deltas);
+    void Remove(const uint256& txhash);
+    /** Append all deltas for the given (addressHash, type) pairs to results, in index order per address */
+    void Get(const std::vector<std::pair<uint160, int> >& addresses,
+             std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> >& results) const;
+    void Clear();
+    size_t Size() const;
+};
+
+/**
+ * Mempool side of -spentindex, sharded by (salted) outpoint hash the same way as CMempoolAddressIndex.
+ */
+class CMempoolSpentIndex
+{
+public:
+    static const size_t SHARD_COUNT = 32;
+
+private:
+    struct SpentKeyHasher
+    {
+        const uint64_t k0, k1;
+        SpentKeyHasher();
+        size_t operator()(const CSpentIndexKey& key) const;
+    };
+
+    struct SpentKeyEqual
+    {
+        bool operator()(const CSpentIndexKey& a, const CSpentIndexKey& b) const
+        {
+            return a.txid == b.txid && a.outputIndex == b.outputIndex;
+        }
+    };
+
+    struct Shard
+    {
+        mutable boost::shared_mutex mutex;
+        std::unordered_map<CSpentIndexKey, CSpentIndexValue, SpentKeyHasher, SpentKeyEqual> mapSpent;
+    };
+
+    SpentKeyHasher hasher;
+    std::array<Shard, SHARD_COUNT> shards;
+
+    CCriticalSection cs_inserted;
+    std::map<uint256, std::vector<CSpentIndexKey> > mapInserted;
+
+    Shard& GetShard(const CSpentIndexKey& key) { return shards[hasher(key) % SHARD_COUNT]; }
+    const Shard& GetShard(const CSpentIndexKey& key) const { return shards[hasher(key) % SHARD_COUNT]; }
+
+public:
+    void Add(const uint256& txhash, const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >& entries);
+    void Remove(const uint256& txhash);
+    bool Get(const CSpentIndexKey& key, CSpentIndexValue& valueRet) const;
+    void Clear();
+    size_t Size() const;
+};
+
+#endif // POLIS_MEMPOOLINDEX_H
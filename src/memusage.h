@@ -6,6 +6,7 @@
 #define BITCOIN_MEMUSAGE_H
 
 #include "indirectmap.h"
+#include "support/allocators/pool.h"
 
 #include <stdlib.h>
 
@@ -181,6 +182,19 @@ static inline size_t DynamicUsage(const std::unordered_map<X, Y, Z>& m)
     return MallocUsage(sizeof(unordered_node<std::pair<const X, Y> >)) * m.size() + MallocUsage(sizeof(void*) * m.bucket_count());
 }
 
+template<typename X, typename Y, typename Z, typename E, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+static inline size_t DynamicUsage(const std::unordered_map<X, Y, Z, E, PoolAllocator<std::pair<const X, Y>, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES> >& m)
+{
+    // The nodes live in the pool's chunks, so account for whole chunks (including the currently unused
+    // parts and free lists) instead of per-node malloc overhead. Nodes which did not fit into the pool
+    // were allocated separately.
+    const auto* resource = m.get_allocator().GetResource();
+    size_t nChunkUsage = resource->NumAllocatedChunks() * MallocUsage(resource->ChunkSizeBytes());
+    size_t nNodeUsage = sizeof(unordered_node<std::pair<const X, Y> >) <= MAX_BLOCK_SIZE_BYTES ? 0 :
+        MallocUsage(sizeof(unordered_node<std::pair<const X, Y> >)) * m.size();
+    return nChunkUsage + nNodeUsage + MallocUsage(sizeof(void*) * m.bucket_count());
+}
+
 }
 
 #endif // BITCOIN_MEMUSAGE_H
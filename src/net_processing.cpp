@@ -11,6 +11,7 @@
 #include "blockencodings.h"
 #include "chainparams.h"
 #include "consensus/validation.h"
+#include "core_memusage.h"
 #include "hash.h"
 #include "init.h"
 #include "validation.h"
@@ -41,6 +42,7 @@
 #include "privatesend-client.h"
 #endif // ENABLE_WALLET
 #include "privatesend-server.h"
+#include "privatesend.h"
 
 #include "evo/deterministicmns.h"
 #include "evo/simplifiedmns.h"
@@ -78,6 +80,18 @@ void EraseOrphansFor(NodeId peer) EXCLUSIVE_LOCKS_REQUIRED(cs_main);
 static size_t vExtraTxnForCompactIt = 0;
 static std::vector<std::pair<uint256, CTransactionRef>> vExtraTxnForCompact GUARDED_BY(cs_main);
 
+/** Compact block reconstruction statistics, see GetCompactBlockStats */
+static std::atomic<uint64_t> nCompactBlocksReconstructed(0);
+static std::atomic<uint64_t> nCompactBlocksSpecialTxn(0);
+static std::atomic<uint64_t> nCompactBlocksRoundTripsAvoided(0);
+
+/** Block propagation latency instrumentation, see GetBlockRelayStats */
+static CCriticalSection cs_blockRelayStats;
+/** Time (in microseconds) when we first received a block (or its compact form) from the network */
+static std::map<uint256, int64_t> mapBlockFirstSeen GUARDED_BY(cs_blockRelayStats);
+static CBlockRelayStats blockRelayStats GUARDED_BY(cs_blockRelayStats);
+static const size_t MAX_BLOCKS_FIRST_SEEN = 100;
+
 static const uint64_t RANDOMIZER_ID_ADDRESS_RELAY = 0x3cac0035b5866b90ULL; // SHA256("main address relay")[0:8]
 
 // Internal stuff
@@ -641,6 +655,95 @@ void AddToCompactExtraTransactions(const CTransactionRef& tx)
     vExtraTxnForCompactIt = (vExtraTxnForCompactIt + 1) % max_extra_txn;
 }
 
+/**
+ * Collect InstantSend lock requests and PrivateSend broadcast txes which are not in our mempool
+ * (e.g. because they arrived while we were full or were evicted) so that compact block
+ * reconstruction can use them. The result is bounded by -blockreconstructionspecialpool megabytes.
+ */
+static void GetSpecialTxnForCompact(std::vector<std::pair<uint256, CTransactionRef>>& vSpecialTxnRet)
+{
+    vSpecialTxnRet.clear();
+
+    size_t nMaxUsage = std::max((int64_t)0, GetArg("-blockreconstructionspecialpool", DEFAULT_BLOCK_RECONSTRUCTION_SPECIAL_POOL)) * 1000000;
+    if (nMaxUsage == 0)
+        return;
+
+    std::vector<CTransactionRef> vtxCandidates;
+    instantsend.GetAcceptedLockRequestTxes(vtxCandidates);
+    CPrivateSend::GetUnconfirmedDSTXes(vtxCandidates);
+
+    size_t nUsage = 0;
+    for (const auto& tx : vtxCandidates) {
+        if (!tx || tx->IsNull() || mempool.exists(tx->GetHash()))
+            continue;
+        nUsage += memusage::DynamicUsage(tx) + RecursiveDynamicUsage(*tx);
+        if (nUsage > nMaxUsage)
+            break;
+        vSpecialTxnRet.emplace_back(tx->GetHash(), tx);
+    }
+}
+
+static void UpdateCompactBlockStats(const uint256& hash, size_t nSpecialCount, bool fComplete)
+{
+    nCompactBlocksReconstructed++;
+    nCompactBlocksSpecialTxn += nSpecialCount;
+    // We only avoided a getblocktxn round-trip if the special pool filled the last gaps
+    bool fRoundTripAvoided = fComplete && nSpecialCount > 0;
+    if (fRoundTripAvoided)
+        nCompactBlocksRoundTripsAvoided++;
+    LogPrint("cmpctblock", "%s -- block %s: %u txn from InstantSend/PrivateSend pool, round-trip avoided: %d\n",
+             __func__, hash.ToString(), nSpecialCount, fRoundTripAvoided);
+}
+
+void GetCompactBlockStats(CCompactBlockStats& stats)
+{
+    stats.nReconstructed = nCompactBlocksReconstructed;
+    stats.nSpecialTxn = nCompactBlocksSpecialTxn;
+    stats.nRoundTripsAvoided = nCompactBlocksRoundTripsAvoided;
+}
+
+static void MarkBlockFirstSeen(const uint256& hash, int64_t nTimeReceived)
+{
+    LOCK(cs_blockRelayStats);
+    if (mapBlockFirstSeen.size() >= MAX_BLOCKS_FIRST_SEEN && !mapBlockFirstSeen.count(hash)) {
+        // drop the oldest entry, it will most likely never be announced or connected
+        auto itOldest = std::min_element(mapBlockFirstSeen.begin(), mapBlockFirstSeen.end(),
+            [](const std::pair<const uint256, int64_t>& a, const std::pair<const uint256, int64_t>& b) { return a.second < b.second; });
+        mapBlockFirstSeen.erase(itOldest);
+    }
+    mapBlockFirstSeen.emplace(hash, nTimeReceived);
+}
+
+static void UpdateBlockRelayLatency(const uint256& hash, bool fConnected)
+{
+    LOCK(cs_blockRelayStats);
+    auto it = mapBlockFirstSeen.find(hash);
+    if (it == mapBlockFirstSeen.end()) {
+        // locally created block or one we've seen before the tracking window
+        return;
+    }
+    int64_t nLatency = GetTimeMicros() - it->second;
+    if (fConnected) {
+        blockRelayStats.nConnected++;
+        blockRelayStats.nConnectLatencyTotal += nLatency;
+        blockRelayStats.nConnectLatencyMax = std::max(blockRelayStats.nConnectLatencyMax, nLatency);
+        // nothing more to measure for this block
+        mapBlockFirstSeen.erase(it);
+    } else {
+        blockRelayStats.nAnnounced++;
+        blockRelayStats.nAnnounceLatencyTotal += nLatency;
+        blockRelayStats.nAnnounceLatencyMax = std::max(blockRelayStats.nAnnounceLatencyMax, nLatency);
+    }
+    LogPrint("cmpctblock", "%s -- block %s %s %.2fms after it was first seen\n",
+             __func__, hash.ToString(), fConnected ? "connected" : "announced", nLatency * 0.001);
+}
+
+void GetBlockRelayStats(CBlockRelayStats& stats)
+{
+    LOCK(cs_blockRelayStats);
+    stats = blockRelayStats;
+}
+
 bool AddOrphanTx(const CTransactionRef& tx, NodeId peer) EXCLUSIVE_LOCKS_REQUIRED(cs_main)
 {
     const uint256& hash = tx->GetHash();
@@ -834,6 +937,8 @@ void PeerLogicValidation::NewPoWValidBlock(const CBlockIndex *pindex, const std:
         most_recent_compact_block = pcmpctblock;
     }
 
+    UpdateBlockRelayLatency(hashBlock, false);
+
     connman->ForEachNode([this, &pcmpctblock, pindex, &msgMaker, &hashBlock](CNode* pnode) {
         // TODO: Avoid the repeated-serialization here
         if (pnode->fDisconnect)
@@ -857,6 +962,8 @@ void PeerLogicValidation::UpdatedBlockTip(const CBlockIndex *pindexNew, const CB
     const int nNewHeight = pindexNew->nHeight;
     connman->SetBestHeight(nNewHeight);
 
+    UpdateBlockRelayLatency(pindexNew->GetBlockHash(), true);
+
     if (!fInitialDownload) {
         // Find the hashes of all blocks that weren't previously in the best chain.
         std::vector<uint256> vHashes;
@@ -2531,6 +2638,8 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         CBlockHeaderAndShortTxIDs cmpctblock;
         vRecv >> cmpctblock;
 
+        MarkBlockFirstSeen(cmpctblock.header.GetHash(), nTimeReceived);
+
         {
         LOCK(cs_main);
 
@@ -2621,7 +2730,9 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                 }
 
                 PartiallyDownloadedBlock& partialBlock = *(*queuedBlockIt)->partialBlock;
-                ReadStatus status = partialBlock.InitData(cmpctblock, vExtraTxnForCompact);
+                std::vector<std::pair<uint256, CTransactionRef>> vSpecialTxn;
+                GetSpecialTxnForCompact(vSpecialTxn);
+                ReadStatus status = partialBlock.InitData(cmpctblock, vExtraTxnForCompact, vSpecialTxn);
                 if (status == READ_STATUS_INVALID) {
                     MarkBlockAsReceived(pindex->GetBlockHash()); // Reset in-flight state in case of whitelist
                     Misbehaving(pfrom->GetId(), 100);
@@ -2640,6 +2751,7 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                     if (!partialBlock.IsTxAvailable(i))
                         req.indexes.push_back(i);
                 }
+                UpdateCompactBlockStats(pindex->GetBlockHash(), partialBlock.GetSpecialCount(), req.indexes.empty());
                 if (req.indexes.empty()) {
                     // Dirty hack to jump to BLOCKTXN code (TODO: move message handling into their own functions)
                     BlockTransactions txn;
@@ -2657,15 +2769,19 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
                 // Optimistically try to reconstruct anyway since we might be
                 // able to without any round trips.
                 PartiallyDownloadedBlock tempBlock(&mempool);
-                ReadStatus status = tempBlock.InitData(cmpctblock, vExtraTxnForCompact);
+                std::vector<std::pair<uint256, CTransactionRef>> vSpecialTxn;
+                GetSpecialTxnForCompact(vSpecialTxn);
+                ReadStatus status = tempBlock.InitData(cmpctblock, vExtraTxnForCompact, vSpecialTxn);
                 if (status != READ_STATUS_OK) {
                     // TODO: don't ignore failures
                     return true;
                 }
+                size_t nSpecialCount = tempBlock.GetSpecialCount();
                 std::vector<CTransactionRef> dummy;
                 status = tempBlock.FillBlock(*pblock, dummy);
                 if (status == READ_STATUS_OK) {
                     fBlockReconstructed = true;
+                    UpdateCompactBlockStats(pindex->GetBlockHash(), nSpecialCount, true);
                 }
             }
         } else {
@@ -2824,6 +2940,8 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
         bool forceProcessing = false;
         const uint256 hash(pblock->GetHash());
 
+        MarkBlockFirstSeen(hash, nTimeReceived);
+
         auto it = mapBlockIndex.find(pblock->hashPrevBlock);
         if (it != mapBlockIndex.end() && ((it->second->nStatus & BLOCK_HAVE_DATA) == 0))
         {
@@ -3110,10 +3228,13 @@ bool static ProcessMessage(CNode* pfrom, const std::string& strCommand, CDataStr
 
         LOCK(cs_main);
 
-        CSimplifiedMNListDiff mnListDiff;
+        CSimplifiedMNListDiffCache::Payload payload;
         std::string strError;
-        if (BuildSimplifiedMNListDiff(cmd.baseBlockHash, cmd.blockHash, mnListDiff, strError)) {
-            connman.PushMessage(pfrom, msgMaker.Make(NetMsgType::MNLISTDIFF, mnListDiff));
+        if (mnListDiffCache.GetDiff(cmd.baseBlockHash, cmd.blockHash, payload, strError)) {
+            CSerializedNetMsg msg;
+            msg.command = NetMsgType::MNLISTDIFF;
+            msg.data = *payload;
+            connman.PushMessage(pfrom, std::move(msg));
         } else {
             LogPrint("net", "getmnlistdiff failed for baseBlockHash=%s, blockHash=%s. error=%s\n", cmd.baseBlockHash.ToString(), cmd.blockHash.ToString(), strError);
             Misbehaving(pfrom->id, 1);
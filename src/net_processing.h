@@ -35,6 +35,8 @@ static constexpr int64_t MINIMUM_CONNECT_TIME = 30;
 
 /** Default number of orphan+recently-replaced txn to keep around for block reconstruction */
 static const unsigned int DEFAULT_BLOCK_RECONSTRUCTION_EXTRA_TXN = 100;
+/** Default for -blockreconstructionspecialpool, maximum memory in megabytes used by InstantSend/PrivateSend txes for block reconstruction */
+static const int64_t DEFAULT_BLOCK_RECONSTRUCTION_SPECIAL_POOL = 5;
 
 /** Register with a network node to receive its signals */
 void RegisterNodeSignals(CNodeSignals& nodeSignals);
@@ -61,6 +63,27 @@ struct CNodeStateStats {
     std::vector<int> vHeightInFlight;
 };
 
+struct CCompactBlockStats {
+    uint64_t nReconstructed;
+    uint64_t nSpecialTxn;
+    uint64_t nRoundTripsAvoided;
+};
+
+/** Get compact block reconstruction statistics */
+void GetCompactBlockStats(CCompactBlockStats& stats);
+
+/** Block propagation latencies in microseconds, measured from the time we first received a block */
+struct CBlockRelayStats {
+    uint64_t nAnnounced{0};
+    int64_t nAnnounceLatencyTotal{0};
+    int64_t nAnnounceLatencyMax{0};
+    uint64_t nConnected{0};
+    int64_t nConnectLatencyTotal{0};
+    int64_t nConnectLatencyMax{0};
+};
+
+/** Get block propagation latency statistics */
+void GetBlockRelayStats(CBlockRelayStats& stats);
 /** Get statistics from node state */
 bool GetNodeStateStats(NodeId nodeid, CNodeStateStats &stats);
 /** Increase a node's misbehavior score. */
@@ -556,6 +556,15 @@ CPrivateSendBroadcastTx CPrivateSend::GetDSTX(const uint256& hash)
     return (it == mapDSTX.end()) ? CPrivateSendBroadcastTx() : it->second;
 }
 
+void CPrivateSend::GetUnconfirmedDSTXes(std::vector<CTransactionRef>& vtxRet)
+{
+    LOCK(cs_mapdstx);
+    for (const auto& pair : mapDSTX) {
+        if (pair.second.IsConfirmed()) continue;
+        vtxRet.emplace_back(pair.second.tx);
+    }
+}
+
 void CPrivateSend::CheckDSTXes(int nHeight)
 {
     LOCK(cs_mapdstx);
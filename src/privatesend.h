@@ -309,6 +309,7 @@ public:
     bool CheckSignature(const CKeyID& keyIDOperator, const CBLSPublicKey& blsPubKey) const;
 
     void SetConfirmedHeight(int nConfirmedHeightIn) { nConfirmedHeight = nConfirmedHeightIn; }
+    bool IsConfirmed() const { return nConfirmedHeight != -1; }
     bool IsExpired(int nHeight);
 };
 
@@ -417,6 +418,8 @@ public:
 
     static void AddDSTX(const CPrivateSendBroadcastTx& dstx);
     static CPrivateSendBroadcastTx GetDSTX(const uint256& hash);
+    /// Get transactions of all unconfirmed DSTXes (used for compact block reconstruction)
+    static void GetUnconfirmedDSTXes(std::vector<CTransactionRef>& vtxRet);
 
     static void UpdatedBlockTip(const CBlockIndex* pindex);
     static void SyncTransaction(const CTransaction& tx, const CBlockIndex* pindex, int posInBlock);
@@ -3,6 +3,7 @@
 // Distributed under the MIT software license, see the accompanying
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
+#include "blockrange.h"
 #include "chain.h"
 #include "chainparams.h"
 #include "primitives/block.h"
@@ -13,6 +14,8 @@
 #include "streams.h"
 #include "sync.h"
 #include "txmempool.h"
+#include "undo.h"
+#include "util.h"
 #include "utilstrencodings.h"
 #include "version.h"
 
@@ -58,13 +61,179 @@ struct CCoin {
     }
 };
 
+/** An output spent by a block, as included in the /rest/block/withprevouts/ binary format */
+struct CSpentOutput {
+    uint32_t nHeight;
+    bool fCoinBase;
+    CTxOut out;
+
+    ADD_SERIALIZE_METHODS;
+
+    CSpentOutput() : nHeight(0), fCoinBase(false) {}
+    CSpentOutput(const Coin& coin) : nHeight(coin.nHeight), fCoinBase(coin.fCoinBase), out(coin.out) {}
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action)
+    {
+        READWRITE(nHeight);
+        READWRITE(fCoinBase);
+        READWRITE(out);
+    }
+};
+
 extern void TxToJSON(const CTransaction& tx, const uint256 hashBlock, UniValue& entry);
-extern UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false);
+extern UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails, int confirmations, const CBlockIndex* pnext);
 extern UniValue mempoolInfoToJSON();
 extern UniValue mempoolToJSON(bool fVerbose = false);
 extern void ScriptPubKeyToJSON(const CScript& scriptPubKey, UniValue& out, bool fIncludeHex);
 extern UniValue blockheaderToJSON(const CBlockIndex* blockindex);
 
+/**
+ * Writes JSON directly into the body of an HTTP reply instead of building the whole document as a
+ * UniValue and serializing it at the end. Nested values can still be passed as (small) UniValues.
+ * The output is the same as UniValue::write() without indentation.
+ */
+class CJSONReplyWriter
+{
+private:
+    static const size_t FLUSH_SIZE = 64 * 1024;
+
+    HTTPRequest* req;
+    std::string strBuffer;
+    //! one entry per open object/array: whether something was written into it already
+    std::vector<bool> vHasElements;
+    bool fAfterKey;
+
+    void Separate()
+    {
+        if (fAfterKey) {
+            fAfterKey = false;
+        } else if (!vHasElements.empty()) {
+            if (vHasElements.back())
+                strBuffer += ',';
+            vHasElements.back() = true;
+        }
+    }
+
+    void Flush()
+    {
+        req->WriteReplyPart(strBuffer.data(), strBuffer.size());
+        strBuffer.clear();
+    }
+
+    void MaybeFlush()
+    {
+        if (strBuffer.size() >= FLUSH_SIZE)
+            Flush();
+    }
+
+public:
+    CJSONReplyWriter(HTTPRequest* reqIn) : req(reqIn), fAfterKey(false)
+    {
+        strBuffer.reserve(FLUSH_SIZE + 4096);
+    }
+
+    void BeginObject() { Separate(); strBuffer += '{'; vHasElements.push_back(false); }
+    void EndObject() { strBuffer += '}'; vHasElements.pop_back(); MaybeFlush(); }
+    void BeginArray() { Separate(); strBuffer += '['; vHasElements.push_back(false); }
+    void EndArray() { strBuffer += ']'; vHasElements.pop_back(); MaybeFlush(); }
+
+    void Key(const std::string& key)
+    {
+        Separate();
+        strBuffer += UniValue(key).write();
+        strBuffer += ':';
+        fAfterKey = true;
+    }
+
+    void Value(const UniValue& value)
+    {
+        Separate();
+        strBuffer += value.write();
+        MaybeFlush();
+    }
+
+    void KeyValue(const std::string& key, const UniValue& value)
+    {
+        Key(key);
+        Value(value);
+    }
+
+    //! Send the reply, the writer must not be used afterwards
+    void Finish()
+    {
+        assert(vHasElements.empty());
+        Flush();
+        req->WriteHeader("Content-Type", "application/json");
+        req->WriteReply(HTTP_OK, "\n");
+    }
+};
+
+static UniValue SpentOutputToJSON(const Coin& coin)
+{
+    UniValue prevout(UniValue::VOBJ);
+    prevout.push_back(Pair("value", ValueFromAmount(coin.out.nValue)));
+    prevout.push_back(Pair("height", (int64_t)coin.nHeight));
+    prevout.push_back(Pair("coinbase", (bool)coin.fCoinBase));
+    UniValue scriptPubKey(UniValue::VOBJ);
+    ScriptPubKeyToJSON(coin.out.scriptPubKey, scriptPubKey, true);
+    prevout.push_back(Pair("scriptPubKey", scriptPubKey));
+    return prevout;
+}
+
+/**
+ * Same as blockToJSON, but the transactions are converted and written one at a time. If pblockUndo
+ * is given, every input gets a "prevout" object describing the output it spends.
+ */
+static void WriteBlockJSON(CJSONReplyWriter& writer, const CBlock& block, const CBlockIndex* pblockindex,
+                           int confirmations, const CBlockIndex* pnext, bool showTxDetails, const CBlockUndo* pblockUndo)
+{
+    // without details, the transaction list is just the txids
+    const UniValue objBlock = blockToJSON(block, pblockindex, false, confirmations, pnext);
+
+    writer.BeginObject();
+    for (size_t i = 0; i < objBlock.size(); i++) {
+        const std::string& strKey = objBlock.getKeys()[i];
+        if (strKey != "tx" || !showTxDetails) {
+            writer.KeyValue(strKey, objBlock.getValues()[i]);
+            continue;
+        }
+
+        writer.Key("tx");
+        writer.BeginArray();
+        for (size_t nTx = 0; nTx < block.vtx.size(); nTx++) {
+            UniValue objTx(UniValue::VOBJ);
+            TxToJSON(*block.vtx[nTx], uint256(), objTx);
+            if (pblockUndo == NULL || nTx == 0) {
+                writer.Value(objTx);
+                continue;
+            }
+
+            const CTxUndo& txundo = pblockUndo->vtxundo[nTx - 1];
+            writer.BeginObject();
+            for (size_t k = 0; k < objTx.size(); k++) {
+                const std::string& strTxKey = objTx.getKeys()[k];
+                if (strTxKey != "vin") {
+                    writer.KeyValue(strTxKey, objTx.getValues()[k]);
+                    continue;
+                }
+                const UniValue& vin = objTx.getValues()[k];
+                writer.Key("vin");
+                writer.BeginArray();
+                for (size_t j = 0; j < vin.size(); j++) {
+                    UniValue in = vin[j];
+                    in.push_back(Pair("prevout", SpentOutputToJSON(txundo.vprevout[j])));
+                    writer.Value(in);
+                }
+                writer.EndArray();
+            }
+            writer.EndObject();
+        }
+        writer.EndArray();
+    }
+    writer.EndObject();
+}
+
 static bool RESTERR(HTTPRequest* req, enum HTTPStatusCode status, std::string message)
 {
     req->WriteHeader("Content-Type", "text/plain");
@@ -202,7 +371,8 @@ static bool rest_headers(HTTPRequest* req,
 
 static bool rest_block(HTTPRequest* req,
                        const std::string& strURIPart,
-                       bool showTxDetails)
+                       bool showTxDetails,
+                       bool showPrevouts = false)
 {
     if (!CheckWarmup(req))
         return false;
@@ -214,22 +384,44 @@ static bool rest_block(HTTPRequest* req,
         return RESTERR(req, HTTP_BAD_REQUEST, "Invalid hash: " + hashStr);
 
     CBlock block;
+    CBlockUndo blockUndo;
     CBlockIndex* pblockindex = NULL;
+    int confirmations = -1;
+    const CBlockIndex* pnext = NULL;
     {
         LOCK(cs_main);
         if (mapBlockIndex.count(hash) == 0)
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
 
         pblockindex = mapBlockIndex[hash];
+        // Only report confirmations if the block is on the main chain
+        if (chainActive.Contains(pblockindex))
+            confirmations = chainActive.Height() - pblockindex->nHeight + 1;
+        pnext = chainActive.Next(pblockindex);
         if (fHavePruned && !(pblockindex->nStatus & BLOCK_HAVE_DATA) && pblockindex->nTx > 0)
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not available (pruned data)");
 
         if (!ReadBlockFromDisk(block, pblockindex, Params().GetConsensus()))
             return RESTERR(req, HTTP_NOT_FOUND, hashStr + " not found");
+
+        if (showPrevouts && pblockindex->pprev) {
+            if (!(pblockindex->nStatus & BLOCK_HAVE_UNDO) ||
+                !UndoReadFromDisk(blockUndo, pblockindex->GetUndoPos(), pblockindex->pprev->GetBlockHash()))
+                return RESTERR(req, HTTP_NOT_FOUND, hashStr + " undo data not available");
+            if (blockUndo.vtxundo.size() + 1 != block.vtx.size())
+                return RESTERR(req, HTTP_INTERNAL_SERVER_ERROR, hashStr + " undo data inconsistent");
+        }
     }
 
     CDataStream ssBlock(SER_NETWORK, PROTOCOL_VERSION);
     ssBlock << block;
+    if (showPrevouts) {
+        // the outputs spent by each transaction (but the coinbase), in input order
+        std::vector<std::vector<CSpentOutput> > vSpent(blockUndo.vtxundo.size());
+        for (size_t i = 0; i < blockUndo.vtxundo.size(); i++)
+            vSpent[i].assign(blockUndo.vtxundo[i].vprevout.begin(), blockUndo.vtxundo[i].vprevout.end());
+        ssBlock << vSpent;
+    }
 
     switch (rf) {
     case RF_BINARY: {
@@ -247,10 +439,9 @@ static bool rest_block(HTTPRequest* req,
     }
 
     case RF_JSON: {
-        UniValue objBlock = blockToJSON(block, pblockindex, showTxDetails);
-        std::string strJSON = objBlock.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        CJSONReplyWriter writer(req);
+        WriteBlockJSON(writer, block, pblockindex, confirmations, pnext, showTxDetails || showPrevouts, showPrevouts ? &blockUndo : NULL);
+        writer.Finish();
         return true;
     }
 
@@ -273,6 +464,93 @@ static bool rest_block_notxdetails(HTTPRequest* req, const std::string& strURIPa
     return rest_block(req, strURIPart, false);
 }
 
+static bool rest_block_withprevouts(HTTPRequest* req, const std::string& strURIPart)
+{
+    return rest_block(req, strURIPart, true, true);
+}
+
+static bool rest_blocks(HTTPRequest* req, const std::string& strURIPart)
+{
+    if (!CheckWarmup(req))
+        return false;
+    std::string param;
+    const RetFormat rf = ParseDataFormat(param, strURIPart);
+    std::vector<std::string> path;
+    boost::split(path, param, boost::is_any_of("/"));
+
+    if (path.size() != 2)
+        return RESTERR(req, HTTP_BAD_REQUEST, "No block count specified. Use /rest/blocks/<start>/<count>.<ext>.");
+
+    int nStart, nCount;
+    if (!ParseInt32(path[0], &nStart))
+        return RESTERR(req, HTTP_BAD_REQUEST, "Invalid block height: " + path[0]);
+    if (!ParseInt32(path[1], &nCount) || nCount < 1 || nCount > MAX_BLOCK_RANGE_COUNT)
+        return RESTERR(req, HTTP_BAD_REQUEST, "Block count out of range: " + path[1]);
+
+    std::string strContentType;
+    switch (rf) {
+    case RF_BINARY: strContentType = "application/octet-stream"; break;
+    case RF_HEX: strContentType = "text/plain"; break;
+    case RF_JSON: strContentType = "application/json"; break;
+    default:
+        return RESTERR(req, HTTP_NOT_FOUND, "output format not found (available: " + AvailableDataFormatsString() + ")");
+    }
+
+    std::vector<const CBlockIndex*> vBlocks;
+    int nTipHeight;
+    const CBlockIndex* pindexNext;
+    std::string strError;
+    if (!GetActiveChainRange(nStart, nCount, vBlocks, nTipHeight, pindexNext, strError))
+        return RESTERR(req, HTTP_NOT_FOUND, strError);
+
+    // Each block is converted into its own slot by the decoding threads, the slots of a batch are then
+    // sent as one chunk and released again
+    std::vector<std::string> vParts(vBlocks.size());
+    auto process = [&](size_t nIndex, const CBlockIndex* pindex, const CBlock& block, const std::vector<char>& vchRaw) {
+        switch (rf) {
+        case RF_BINARY:
+            vParts[nIndex].assign(vchRaw.begin(), vchRaw.end());
+            break;
+        case RF_HEX:
+            vParts[nIndex] = HexStr(vchRaw.begin(), vchRaw.end()) + "\n";
+            break;
+        default: {
+            // runs without cs_main, the chain position comes from the snapshot taken with the range
+            const CBlockIndex* pnext = nIndex + 1 < vBlocks.size() ? vBlocks[nIndex + 1] : pindexNext;
+            vParts[nIndex] = (nIndex == 0 ? "[" : ",") + blockToJSON(block, pindex, true, nTipHeight - pindex->nHeight + 1, pnext).write();
+            break;
+        }
+        }
+    };
+
+    bool fStarted = false;
+    auto batch = [&](size_t nFirst, size_t nBatch) {
+        if (!fStarted) {
+            // Only start the reply once the first batch was read, so a failure up to here is still reported properly
+            req->WriteHeader("Content-Type", strContentType);
+            req->StartReplyChunks(HTTP_OK);
+            fStarted = true;
+        }
+        std::string strChunk;
+        for (size_t i = nFirst; i < nFirst + nBatch; i++) {
+            strChunk += vParts[i];
+            std::string().swap(vParts[i]);
+        }
+        if (rf == RF_JSON && nFirst + nBatch == vParts.size())
+            strChunk += "]\n";
+        return req->WriteReplyChunk(strChunk);
+    };
+
+    if (!ReadBlockRange(vBlocks, Params().GetConsensus(), 0, process, batch, strError)) {
+        if (!fStarted)
+            return RESTERR(req, HTTP_NOT_FOUND, strError);
+        // The status was sent already, all that's left is to cut the reply short
+        LogPrintf("%s: %s, reply truncated\n", __func__, strError);
+    }
+    req->EndReplyChunks();
+    return true;
+}
+
 // A bit of a hack - dependency on a function defined in rpc/blockchain.cpp
 UniValue getblockchaininfo(const JSONRPCRequest& request);
 
@@ -389,9 +667,9 @@ static bool rest_tx(HTTPRequest* req, const std::string& strURIPart)
     case RF_JSON: {
         UniValue objTx(UniValue::VOBJ);
         TxToJSON(*tx, hashBlock, objTx);
-        std::string strJSON = objTx.write() + "\n";
-        req->WriteHeader("Content-Type", "application/json");
-        req->WriteReply(HTTP_OK, strJSON);
+        CJSONReplyWriter writer(req);
+        writer.Value(objTx);
+        writer.Finish();
         return true;
     }
 
@@ -594,21 +872,27 @@ static bool rest_getutxos(HTTPRequest* req, const std::string& strURIPart)
 static const struct {
     const char* prefix;
     bool (*handler)(HTTPRequest* req, const std::string& strReq);
+    HTTPWorkClass workClass;
 } uri_prefixes[] = {
-      {"/rest/tx/", rest_tx},
-      {"/rest/block/notxdetails/", rest_block_notxdetails},
-      {"/rest/block/", rest_block_extended},
-      {"/rest/chaininfo", rest_chaininfo},
-      {"/rest/mempool/info", rest_mempool_info},
-      {"/rest/mempool/contents", rest_mempool_contents},
-      {"/rest/headers/", rest_headers},
-      {"/rest/getutxos", rest_getutxos},
+      {"/rest/tx/", rest_tx, HTTP_WORK_NORMAL},
+      {"/rest/blocks/", rest_blocks, HTTP_WORK_HEAVY},
+      {"/rest/block/notxdetails/", rest_block_notxdetails, HTTP_WORK_NORMAL},
+      {"/rest/block/withprevouts/", rest_block_withprevouts, HTTP_WORK_NORMAL},
+      {"/rest/block/", rest_block_extended, HTTP_WORK_NORMAL},
+      {"/rest/chaininfo", rest_chaininfo, HTTP_WORK_CHEAP},
+      {"/rest/mempool/info", rest_mempool_info, HTTP_WORK_CHEAP},
+      {"/rest/mempool/contents", rest_mempool_contents, HTTP_WORK_HEAVY},
+      {"/rest/headers/", rest_headers, HTTP_WORK_NORMAL},
+      {"/rest/getutxos", rest_getutxos, HTTP_WORK_NORMAL},
 };
 
 bool StartREST()
 {
-    for (unsigned int i = 0; i < ARRAYLEN(uri_prefixes); i++)
-        RegisterHTTPHandler(uri_prefixes[i].prefix, false, uri_prefixes[i].handler);
+    for (unsigned int i = 0; i < ARRAYLEN(uri_prefixes); i++) {
+        const HTTPWorkClass workClass = uri_prefixes[i].workClass;
+        RegisterHTTPHandler(uri_prefixes[i].prefix, false, uri_prefixes[i].handler,
+                            [workClass](HTTPRequest*, const std::string&) { return workClass; });
+    }
     return true;
 }
 
@@ -5,12 +5,14 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "amount.h"
+#include "blockrange.h"
 #include "chain.h"
 #include "chainparams.h"
 #include "checkpoints.h"
 #include "coins.h"
 #include "core_io.h"
 #include "consensus/validation.h"
+#include "indexbuilder.h"
 #include "instantx.h"
 #include "validation.h"
 #include "policy/policy.h"
@@ -109,14 +111,14 @@ UniValue blockheaderToJSON(const CBlockIndex* blockindex)
     return result;
 }
 
-UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false)
+/**
+ * Same as below, but with the chain position given by the caller, so it doesn't need cs_main.
+ * confirmations is -1 for blocks which are not in the main chain, pnext is the following main chain block.
+ */
+UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails, int confirmations, const CBlockIndex* pnext)
 {
     UniValue result(UniValue::VOBJ);
     result.push_back(Pair("hash", blockindex->GetBlockHash().GetHex()));
-    int confirmations = -1;
-    // Only report confirmations if the block is on the main chain
-    if (chainActive.Contains(blockindex))
-        confirmations = chainActive.Height() - blockindex->nHeight + 1;
     result.push_back(Pair("confirmations", confirmations));
     result.push_back(Pair("size", (int)::GetSerializeSize(block, SER_NETWORK, PROTOCOL_VERSION)));
     result.push_back(Pair("height", blockindex->nHeight));
@@ -159,12 +161,20 @@ UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool tx
 
     if (blockindex->pprev)
         result.push_back(Pair("previousblockhash", blockindex->pprev->GetBlockHash().GetHex()));
-    CBlockIndex *pnext = chainActive.Next(blockindex);
     if (pnext)
         result.push_back(Pair("nextblockhash", pnext->GetBlockHash().GetHex()));
     return result;
 }
 
+UniValue blockToJSON(const CBlock& block, const CBlockIndex* blockindex, bool txDetails = false)
+{
+    int confirmations = -1;
+    // Only report confirmations if the block is on the main chain
+    if (chainActive.Contains(blockindex))
+        confirmations = chainActive.Height() - blockindex->nHeight + 1;
+    return blockToJSON(block, blockindex, txDetails, confirmations, chainActive.Next(blockindex));
+}
+
 UniValue getblockcount(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 0)
@@ -412,12 +422,13 @@ UniValue mempoolToJSON(bool fVerbose = false)
     {
         LOCK(mempool.cs);
         UniValue o(UniValue::VOBJ);
+        o.reserve(mempool.mapTx.size());
         BOOST_FOREACH(const CTxMemPoolEntry& e, mempool.mapTx)
         {
             const uint256& hash = e.GetTx().GetHash();
             UniValue info(UniValue::VOBJ);
             entryToJSON(info, e);
-            o.push_back(Pair(hash.ToString(), info));
+            o.pushKV(hash.ToString(), std::move(info));
         }
         return o;
     }
@@ -918,6 +929,58 @@ UniValue getblock(const JSONRPCRequest& request)
     return blockToJSON(block, pblockindex, verbosity >= 2);
 }
 
+UniValue getblocks(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() < 2 || request.params.size() > 3)
+        throw std::runtime_error(
+            "getblocks height count ( verbosity )\n"
+            "\nReturns up to 'count' consecutive blocks of the main chain, starting at 'height'. Stops early at the tip.\n"
+            "This is much faster than calling getblock for each of them, the blocks are read in one go and decoded in parallel.\n"
+            "\nArguments:\n"
+            "1. height                 (numeric, required) The height of the first block\n"
+            "2. count                  (numeric, required) The number of blocks, at most " + std::to_string(MAX_BLOCK_RANGE_COUNT) + "\n"
+            "3. verbosity              (numeric, optional, default=1) 0 for hex-encoded data, 1 for a json object, and 2 for json object with transaction data\n"
+            "\nResult:\n"
+            "[                         (array) One entry per block, in the format of getblock with the same verbosity\n"
+            "  ...\n"
+            "]\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getblocks", "1000 100")
+            + HelpExampleRpc("getblocks", "1000, 100")
+        );
+
+    int nStart = request.params[0].get_int();
+    int nCount = request.params[1].get_int();
+    int verbosity = 1;
+    if (request.params.size() > 2)
+        verbosity = request.params[2].get_int();
+
+    std::vector<const CBlockIndex*> vBlocks;
+    int nTipHeight;
+    const CBlockIndex* pindexNext;
+    std::string strError;
+    if (!GetActiveChainRange(nStart, nCount, vBlocks, nTipHeight, pindexNext, strError))
+        throw JSONRPCError(RPC_INVALID_PARAMETER, strError);
+
+    std::vector<UniValue> vResults(vBlocks.size());
+    auto process = [&](size_t nIndex, const CBlockIndex* pindex, const CBlock& block, const std::vector<char>& vchRaw) {
+        if (verbosity <= 0) {
+            vResults[nIndex] = HexStr(vchRaw.begin(), vchRaw.end());
+        } else {
+            // runs without cs_main, the chain position comes from the snapshot taken with the range
+            const CBlockIndex* pnext = nIndex + 1 < vBlocks.size() ? vBlocks[nIndex + 1] : pindexNext;
+            vResults[nIndex] = blockToJSON(block, pindex, verbosity >= 2, nTipHeight - pindex->nHeight + 1, pnext);
+        }
+    };
+    auto batch = [](size_t, size_t) { return true; };
+    if (!ReadBlockRange(vBlocks, Params().GetConsensus(), 0, process, batch, strError))
+        throw JSONRPCError(RPC_INTERNAL_ERROR, strError);
+
+    UniValue result(UniValue::VARR);
+    result.push_backV(vResults);
+    return result;
+}
+
 struct CCoinsStats
 {
     int nHeight;
@@ -1515,6 +1578,65 @@ UniValue getmempoolinfo(const JSONRPCRequest& request)
     return mempoolInfoToJSON();
 }
 
+UniValue getindexbuildinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getindexbuildinfo\n"
+            "\nReturns the state of the background build of -addressindex, -spentindex and -timestampindex.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"building\": true|false,     (boolean) Whether indexes are currently being built\n"
+            "  \"indexes\": [ \"name\", ... ], (array) The indexes being built\n"
+            "  \"height\": xxxxx,             (numeric) The height up to which the indexes have been built\n"
+            "  \"tip\": xxxxx,                (numeric) The height of the active chain\n"
+            "  \"progress\": xxxxx,           (numeric) Estimate of the build progress [0..1]\n"
+            "  \"enabled\": [ \"name\", ... ], (array) The indexes which are available\n"
+            "  \"error\": \"xxxx\"            (string, optional) Why the build stopped\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getindexbuildinfo", "")
+            + HelpExampleRpc("getindexbuildinfo", "")
+        );
+
+    int nTipHeight;
+    UniValue enabled(UniValue::VARR);
+    {
+        LOCK(cs_main);
+        nTipHeight = chainActive.Height();
+        if (fAddressIndex)
+            enabled.push_back("addressindex");
+        if (fSpentIndex)
+            enabled.push_back("spentindex");
+        if (fTimestampIndex)
+            enabled.push_back("timestampindex");
+    }
+
+    UniValue obj(UniValue::VOBJ);
+    bool fBuilding = indexBuilder.IsRunning();
+    obj.push_back(Pair("building", fBuilding));
+    UniValue indexes(UniValue::VARR);
+    if (fBuilding || !indexBuilder.GetError().empty()) {
+        int nIndexes = indexBuilder.GetIndexes();
+        if (nIndexes & CIndexBuilder::INDEX_ADDRESS)
+            indexes.push_back("addressindex");
+        if (nIndexes & CIndexBuilder::INDEX_SPENT)
+            indexes.push_back("spentindex");
+        if (nIndexes & CIndexBuilder::INDEX_TIMESTAMP)
+            indexes.push_back("timestampindex");
+    }
+    obj.push_back(Pair("indexes", indexes));
+    int nHeight = indexBuilder.GetHeight();
+    obj.push_back(Pair("height", nHeight));
+    obj.push_back(Pair("tip", nTipHeight));
+    obj.push_back(Pair("progress", nTipHeight > 0 ? std::max(0, nHeight) / (double)nTipHeight : 0.0));
+    obj.push_back(Pair("enabled", enabled));
+    std::string strError = indexBuilder.GetError();
+    if (!strError.empty())
+        obj.push_back(Pair("error", strError));
+    return obj;
+}
+
 UniValue preciousblock(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1)
@@ -1742,12 +1864,14 @@ static const CRPCCommand commands[] =
     { "blockchain",         "getbestblockhash",       &getbestblockhash,       true,  {} },
     { "blockchain",         "getblockcount",          &getblockcount,          true,  {} },
     { "blockchain",         "getblock",               &getblock,               true,  {"blockhash","verbosity|verbose"} },
+    { "blockchain",         "getblocks",              &getblocks,              true,  {"height","count","verbosity"} },
     { "blockchain",         "getblockhashes",         &getblockhashes,         true,  {"high","low"} },
     { "blockchain",         "getblockhash",           &getblockhash,           true,  {"height"} },
     { "blockchain",         "getblockheader",         &getblockheader,         true,  {"blockhash","verbose"} },
     { "blockchain",         "getblockheaders",        &getblockheaders,        true,  {"blockhash","count","verbose"} },
     { "blockchain",         "getchaintips",           &getchaintips,           true,  {"count","branchlen"} },
     { "blockchain",         "getdifficulty",          &getdifficulty,          true,  {} },
+    { "blockchain",         "getindexbuildinfo",      &getindexbuildinfo,      true,  {} },
     { "blockchain",         "getmempoolancestors",    &getmempoolancestors,    true,  {"txid","verbose"} },
     { "blockchain",         "getmempooldescendants",  &getmempooldescendants,  true,  {"txid","verbose"} },
     { "blockchain",         "getmempoolentry",        &getmempoolentry,        true,  {"txid"} },
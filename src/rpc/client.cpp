@@ -100,6 +100,9 @@ static const CRPCConvertParam vRPCConvertParams[] =
     { "listunspent", 2, "addresses" },
     { "listunspent", 3, "include_unsafe" },
     { "getblock", 1, "verbosity" },
+    { "getblocks", 0, "height" },
+    { "getblocks", 1, "count" },
+    { "getblocks", 2, "verbosity" },
     { "getblockheader", 1, "verbose" },
     { "getblockheaders", 1, "count" },
     { "getblockheaders", 2, "verbose" },
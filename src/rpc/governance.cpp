@@ -722,6 +722,7 @@ UniValue ListObjects(const std::string& strCachedSignal, const std::string& strT
 
     std::vector<const CGovernanceObject*> objs = governance.GetAllNewerThan(nStartTime);
     governance.UpdateLastDiffTime(GetTime());
+    objResult.reserve(objs.size());
 
     // CREATE RESULTS FOR USER
 
@@ -761,7 +762,7 @@ UniValue ListObjects(const std::string& strCachedSignal, const std::string& strT
         bObj.push_back(Pair("fCachedDelete",  pGovObj->IsSetCachedDelete()));
         bObj.push_back(Pair("fCachedEndorsed",  pGovObj->IsSetCachedEndorsed()));
 
-        objResult.push_back(Pair(pGovObj->GetHash().ToString(), bObj));
+        objResult.pushKV(pGovObj->GetHash().ToString(), std::move(bObj));
     }
 
     return objResult;
@@ -912,6 +912,7 @@ UniValue masternodelist(const JSONRPCRequest& request)
         }
     } else {
         std::map<COutPoint, CMasternode> mapMasternodes = mnodeman.GetFullMasternodeMap();
+        obj.reserve(mapMasternodes.size());
         for (const auto& mnpair : mapMasternodes) {
             CMasternode mn = mnpair.second;
             std::string strOutpoint = mnpair.first.ToStringShort();
@@ -1007,6 +1008,7 @@ UniValue masternodelist(const JSONRPCRequest& request)
                 if (strFilter !="" && strInfo.find(strFilter) == std::string::npos &&
                     strOutpoint.find(strFilter) == std::string::npos) continue;
                 UniValue objMN(UniValue::VOBJ);
+                objMN.reserve(14);
                 objMN.push_back(Pair("address", mn.addr.ToString()));
                 objMN.push_back(Pair("payee", payeeStr));
                 objMN.push_back(Pair("status", mn.GetStatus()));
@@ -1021,7 +1023,7 @@ UniValue masternodelist(const JSONRPCRequest& request)
                 objMN.push_back(Pair("owneraddress", CBitcoinAddress(mn.keyIDOwner).ToString()));
                 objMN.push_back(Pair("votingaddress", CBitcoinAddress(mn.keyIDVoting).ToString()));
                 objMN.push_back(Pair("collateraladdress", collateralAddressStr));
-                obj.push_back(Pair(strOutpoint, objMN));
+                obj.pushKV(strOutpoint, std::move(objMN));
             } else if (strMode == "keyid") {
                 if (strFilter !="" && strOutpoint.find(strFilter) == std::string::npos) continue;
                 obj.push_back(Pair(strOutpoint, HexStr(mn.legacyKeyIDOperator)));
@@ -5,11 +5,13 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "base58.h"
+#include "crypto/common.h"
 #include "clientversion.h"
 #include "init.h"
 #include "net.h"
 #include "netbase.h"
 #include "rpc/server.h"
+#include "streams.h"
 #include "timedata.h"
 #include "txmempool.h"
 #include "util.h"
@@ -663,6 +665,130 @@ bool timestampSort(std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> a,
     return a.second.time < b.second.time;
 }
 
+/**
+ * Reads the optional "limit" and "cursor" fields of an address index query into limit and
+ * cursor. Returns false if no page was requested, i.e. the whole result should be returned.
+ */
+static bool getPageFromParams(const UniValue& params, int& limit, CDataStream& cursor)
+{
+    if (!params[0].isObject())
+        return false;
+
+    UniValue limitValue = find_value(params[0].get_obj(), "limit");
+    if (limitValue.isNull())
+        return false;
+    limit = limitValue.get_int();
+    if (limit <= 0)
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Limit is expected to be positive");
+
+    UniValue cursorValue = find_value(params[0].get_obj(), "cursor");
+    if (!cursorValue.isNull()) {
+        std::string strCursor = cursorValue.get_str();
+        if (!IsHex(strCursor))
+            throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        std::vector<unsigned char> vchCursor = ParseHex(strCursor);
+        cursor.write((const char*)vchCursor.data(), vchCursor.size());
+    }
+    return true;
+}
+
+template <typename T>
+static void readCursor(CDataStream& cursor, T& obj)
+{
+    try {
+        cursor >> obj;
+    } catch (const std::exception&) {
+        throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+    }
+}
+
+static UniValue pageToJSON(const std::string& name, const UniValue& items, const CDataStream* pnext)
+{
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair(name, items));
+    result.push_back(Pair("cursor", pnext ? UniValue(HexStr(pnext->begin(), pnext->end())) : NullUniValue));
+    return result;
+}
+
+static bool isSameAddressIndexKey(const CAddressIndexKey& a, const CAddressIndexKey& b)
+{
+    return a.type == b.type && a.hashBytes == b.hashBytes && a.blockHeight == b.blockHeight && a.txindex == b.txindex &&
+           a.txhash == b.txhash && a.index == b.index && a.spending == b.spending;
+}
+
+/**
+ * Order of getaddressutxos results: by height, then by position of the address in the request,
+ * then in index order (txhash, then little endian output index).
+ */
+struct CAddressUnspentSortKey
+{
+    int height;
+    uint32_t nAddress;
+    uint256 txhash;
+    uint32_t index;
+
+    ADD_SERIALIZE_METHODS;
+
+    template <typename Stream, typename Operation>
+    inline void SerializationOp(Stream& s, Operation ser_action) {
+        READWRITE(height);
+        READWRITE(nAddress);
+        READWRITE(txhash);
+        READWRITE(index);
+    }
+
+    bool operator<(const CAddressUnspentSortKey& b) const {
+        if (height != b.height)
+            return height < b.height;
+        if (nAddress != b.nAddress)
+            return nAddress < b.nAddress;
+        if (txhash != b.txhash)
+            return txhash < b.txhash;
+        unsigned char a1[4], b1[4];
+        WriteLE32(a1, index);
+        WriteLE32(b1, b.index);
+        return memcmp(a1, b1, 4) < 0;
+    }
+};
+
+static UniValue addressUnspentToJSON(const CAddressUnspentKey& key, const CAddressUnspentValue& value)
+{
+    std::string address;
+    if (!getAddressFromIndex(key.type, key.hashBytes, address)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
+    }
+
+    UniValue output(UniValue::VOBJ);
+    output.push_back(Pair("address", address));
+    output.push_back(Pair("txid", key.txhash.GetHex()));
+    output.push_back(Pair("outputIndex", (int)key.index));
+    output.push_back(Pair("script", HexStr(value.script.begin(), value.script.end())));
+    output.push_back(Pair("satoshis", value.satoshis));
+    output.push_back(Pair("height", value.blockHeight));
+    return output;
+}
+
+static UniValue addressDeltaToJSON(const CAddressIndexKey& key, CAmount amount)
+{
+    std::string address;
+    if (!getAddressFromIndex(key.type, key.hashBytes, address)) {
+        throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
+    }
+
+    UniValue delta(UniValue::VOBJ);
+    delta.push_back(Pair("satoshis", amount));
+    delta.push_back(Pair("txid", key.txhash.GetHex()));
+    delta.push_back(Pair("index", (int)key.index));
+    delta.push_back(Pair("blockindex", (int)key.txindex));
+    delta.push_back(Pair("height", key.blockHeight));
+    delta.push_back(Pair("address", address));
+    return delta;
+}
+
+static const std::string strPageHelp =
+    "  \"limit\" (number, optional) Return at most this many results per call, together with a cursor for the next page\n"
+    "  \"cursor\" (string, optional) The cursor returned with the previous page\n";
+
 UniValue getaddressmempool(const JSONRPCRequest& request)
 {
     if (request.fHelp || request.params.size() != 1)
@@ -747,6 +873,7 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
             "      \"address\"  (string) The base58check encoded address\n"
             "      ,...\n"
             "    ]\n"
+            + strPageHelp +
             "}\n"
             "\nResult:\n"
             "[\n"
@@ -759,8 +886,14 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
             "    \"height\"  (number) The block height\n"
             "  }\n"
             "]\n"
+            "\nResult (with limit):\n"
+            "{\n"
+            "  \"utxos\"  (array) The next page of unspent outputs, as above\n"
+            "  \"cursor\"  (string) The cursor for the next page, null if there are no more results\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"PK6NyLfYDqXyKXZz8EhJWjz3rReqT4VR4a\"]}'")
+            + HelpExampleCli("getaddressutxos", "'{\"addresses\": [\"PK6NyLfYDqXyKXZz8EhJWjz3rReqT4VR4a\"], \"limit\": 1000}'")
             + HelpExampleRpc("getaddressutxos", "{\"addresses\": [\"PK6NyLfYDqXyKXZz8EhJWjz3rReqT4VR4a\"]}")
         );
 
@@ -770,6 +903,50 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    int limit = 0;
+    CDataStream cursor(SER_DISK, CLIENT_VERSION);
+    if (getPageFromParams(request.params, limit, cursor)) {
+        bool fHaveCursor = !cursor.empty();
+        CAddressUnspentSortKey cursorKey;
+        if (fHaveCursor) {
+            readCursor(cursor, cursorKey);
+        }
+
+        // The outputs are not stored in result order, so go through all of them but only keep the
+        // smallest limit + 1 after the cursor (one more to know whether there is another page).
+        std::map<CAddressUnspentSortKey, std::pair<CAddressUnspentKey, CAddressUnspentValue> > mapPage;
+        for (uint32_t i = 0; i < addresses.size(); i++) {
+            bool fOk = ForEachAddressUnspent(addresses[i].first, addresses[i].second, [&](const CAddressUnspentKey& key, const CAddressUnspentValue& value) {
+                CAddressUnspentSortKey sortKey{value.blockHeight, i, key.txhash, (uint32_t)key.index};
+                if (fHaveCursor && !(cursorKey < sortKey))
+                    return true;
+                if ((int)mapPage.size() > limit && !(sortKey < mapPage.rbegin()->first))
+                    return true;
+                mapPage.emplace(sortKey, std::make_pair(key, value));
+                if ((int)mapPage.size() > limit + 1)
+                    mapPage.erase(std::prev(mapPage.end()));
+                return true;
+            });
+            if (!fOk) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+        }
+
+        bool fMore = (int)mapPage.size() > limit;
+        if (fMore)
+            mapPage.erase(std::prev(mapPage.end()));
+
+        UniValue utxos(UniValue::VARR);
+        for (const auto& p : mapPage) {
+            utxos.push_back(addressUnspentToJSON(p.second.first, p.second.second));
+        }
+
+        CDataStream next(SER_DISK, CLIENT_VERSION);
+        if (fMore)
+            next << mapPage.rbegin()->first;
+        return pageToJSON("utxos", utxos, fMore ? &next : nullptr);
+    }
+
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > unspentOutputs;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
@@ -778,24 +955,13 @@ UniValue getaddressutxos(const JSONRPCRequest& request)
         }
     }
 
-    std::sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
+    // stable, so outputs of the same height stay in address and index order, like the pages above
+    std::stable_sort(unspentOutputs.begin(), unspentOutputs.end(), heightSort);
 
     UniValue result(UniValue::VARR);
 
     for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=unspentOutputs.begin(); it!=unspentOutputs.end(); it++) {
-        UniValue output(UniValue::VOBJ);
-        std::string address;
-        if (!getAddressFromIndex(it->first.type, it->first.hashBytes, address)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
-        }
-
-        output.push_back(Pair("address", address));
-        output.push_back(Pair("txid", it->first.txhash.GetHex()));
-        output.push_back(Pair("outputIndex", (int)it->first.index));
-        output.push_back(Pair("script", HexStr(it->second.script.begin(), it->second.script.end())));
-        output.push_back(Pair("satoshis", it->second.satoshis));
-        output.push_back(Pair("height", it->second.blockHeight));
-        result.push_back(output);
+        result.push_back(addressUnspentToJSON(it->first, it->second));
     }
 
     return result;
@@ -816,6 +982,7 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
             "    ]\n"
             "  \"start\" (number) The start block height\n"
             "  \"end\" (number) The end block height\n"
+            + strPageHelp +
             "}\n"
             "\nResult:\n"
             "[\n"
@@ -828,8 +995,14 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
             "    \"address\"  (string) The base58check encoded address\n"
             "  }\n"
             "]\n"
+            "\nResult (with limit):\n"
+            "{\n"
+            "  \"deltas\"  (array) The next page of changes, as above\n"
+            "  \"cursor\"  (string) The cursor for the next page, null if there are no more results\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"PK6NyLfYDqXyKXZz8EhJWjz3rReqT4VR4a\"]}'")
+            + HelpExampleCli("getaddressdeltas", "'{\"addresses\": [\"PK6NyLfYDqXyKXZz8EhJWjz3rReqT4VR4a\"], \"limit\": 1000}'")
             + HelpExampleRpc("getaddressdeltas", "{\"addresses\": [\"PK6NyLfYDqXyKXZz8EhJWjz3rReqT4VR4a\"]}")
         );
 
@@ -854,6 +1027,49 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
+    int limit = 0;
+    CDataStream cursor(SER_DISK, CLIENT_VERSION);
+    if (getPageFromParams(request.params, limit, cursor)) {
+        // cursor: position of the address in the request and the last returned key of it
+        uint32_t nAddress = 0;
+        CAddressIndexKey keyFrom;
+        bool fHaveCursor = !cursor.empty();
+        if (fHaveCursor) {
+            readCursor(cursor, nAddress);
+            readCursor(cursor, keyFrom);
+            if (nAddress >= addresses.size())
+                throw JSONRPCError(RPC_INVALID_PARAMETER, "Invalid cursor");
+        }
+
+        UniValue deltas(UniValue::VARR);
+        bool fMore = false;
+        uint32_t nLastAddress = nAddress;
+        CAddressIndexKey lastKey;
+        for (uint32_t i = nAddress; i < addresses.size() && !fMore; i++) {
+            const CAddressIndexKey* pkeyFrom = (fHaveCursor && i == nAddress) ? &keyFrom : nullptr;
+            bool fOk = ForEachAddressIndex(addresses[i].first, addresses[i].second, [&](const CAddressIndexKey& key, CAmount amount) {
+                if (pkeyFrom && isSameAddressIndexKey(key, *pkeyFrom))
+                    return true;
+                if ((int)deltas.size() == limit) {
+                    fMore = true;
+                    return false;
+                }
+                deltas.push_back(addressDeltaToJSON(key, amount));
+                nLastAddress = i;
+                lastKey = key;
+                return true;
+            }, (start > 0 && end > 0) ? start : 0, (start > 0 && end > 0) ? end : 0, pkeyFrom);
+            if (!fOk) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+        }
+
+        CDataStream next(SER_DISK, CLIENT_VERSION);
+        if (fMore)
+            next << nLastAddress << lastKey;
+        return pageToJSON("deltas", deltas, fMore ? &next : nullptr);
+    }
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
@@ -871,19 +1087,7 @@ UniValue getaddressdeltas(const JSONRPCRequest& request)
     UniValue result(UniValue::VARR);
 
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        std::string address;
-        if (!getAddressFromIndex(it->first.type, it->first.hashBytes, address)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Unknown address type");
-        }
-
-        UniValue delta(UniValue::VOBJ);
-        delta.push_back(Pair("satoshis", it->second));
-        delta.push_back(Pair("txid", it->first.txhash.GetHex()));
-        delta.push_back(Pair("index", (int)it->first.index));
-        delta.push_back(Pair("blockindex", (int)it->first.txindex));
-        delta.push_back(Pair("height", it->first.blockHeight));
-        delta.push_back(Pair("address", address));
-        result.push_back(delta);
+        result.push_back(addressDeltaToJSON(it->first, it->second));
     }
 
     return result;
@@ -919,22 +1123,17 @@ UniValue getaddressbalance(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "Invalid address");
     }
 
-    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
-
-    for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
-        if (!GetAddressIndex((*it).first, (*it).second, addressIndex)) {
-            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
-        }
-    }
-
     CAmount balance = 0;
     CAmount received = 0;
 
-    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=addressIndex.begin(); it!=addressIndex.end(); it++) {
-        if (it->second > 0) {
-            received += it->second;
+    for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+        CAmount addressBalance = 0;
+        CAmount addressReceived = 0;
+        if (!GetAddressBalance((*it).first, (*it).second, addressBalance, addressReceived)) {
+            throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
         }
-        balance += it->second;
+        balance += addressBalance;
+        received += addressReceived;
     }
 
     UniValue result(UniValue::VOBJ);
@@ -960,14 +1159,21 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
             "    ]\n"
             "  \"start\" (number) The start block height\n"
             "  \"end\" (number) The end block height\n"
+            + strPageHelp +
             "}\n"
             "\nResult:\n"
             "[\n"
             "  \"transactionid\"  (string) The transaction id\n"
             "  ,...\n"
             "]\n"
+            "\nResult (with limit):\n"
+            "{\n"
+            "  \"txids\"  (array) The next page of transaction ids, as above\n"
+            "  \"cursor\"  (string) The cursor for the next page, null if there are no more results\n"
+            "}\n"
             "\nExamples:\n"
             + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"PK6NyLfYDqXyKXZz8EhJWjz3rReqT4VR4a\"]}'")
+            + HelpExampleCli("getaddresstxids", "'{\"addresses\": [\"PK6NyLfYDqXyKXZz8EhJWjz3rReqT4VR4a\"], \"limit\": 1000}'")
             + HelpExampleRpc("getaddresstxids", "{\"addresses\": [\"PK6NyLfYDqXyKXZz8EhJWjz3rReqT4VR4a\"]}")
         );
 
@@ -988,6 +1194,84 @@ UniValue getaddresstxids(const JSONRPCRequest& request)
         }
     }
 
+    int limit = 0;
+    CDataStream cursor(SER_DISK, CLIENT_VERSION);
+    if (getPageFromParams(request.params, limit, cursor)) {
+        bool fHaveCursor = !cursor.empty();
+        int indexStart = (start > 0 && end > 0) ? start : 0;
+        int indexEnd = (start > 0 && end > 0) ? end : 0;
+        UniValue txidsPage(UniValue::VARR);
+        CDataStream next(SER_DISK, CLIENT_VERSION);
+        bool fMore = false;
+
+        if (addresses.size() == 1) {
+            // Index order, which is (height, position in block), so the entries of a transaction are
+            // adjacent. cursor: height and position in block of the last returned transaction.
+            int nLastHeight = -1;
+            uint32_t nLastTxIndex = 0;
+            CAddressIndexKey keyFrom;
+            if (fHaveCursor) {
+                readCursor(cursor, nLastHeight);
+                readCursor(cursor, nLastTxIndex);
+                keyFrom = CAddressIndexKey(addresses[0].second, addresses[0].first, nLastHeight, nLastTxIndex + 1, uint256(), 0, false);
+            }
+            bool fOk = ForEachAddressIndex(addresses[0].first, addresses[0].second, [&](const CAddressIndexKey& key, CAmount amount) {
+                if (key.blockHeight == nLastHeight && key.txindex == nLastTxIndex)
+                    return true;
+                if ((int)txidsPage.size() == limit) {
+                    fMore = true;
+                    return false;
+                }
+                txidsPage.push_back(key.txhash.GetHex());
+                nLastHeight = key.blockHeight;
+                nLastTxIndex = key.txindex;
+                return true;
+            }, indexStart, indexEnd, fHaveCursor ? &keyFrom : nullptr);
+            if (!fOk) {
+                throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+            }
+            if (fMore)
+                next << nLastHeight << nLastTxIndex;
+        } else {
+            // Sorted by (height, txid) over all addresses, keep the smallest limit + 1 after the cursor.
+            std::pair<int, std::string> cursorTxid;
+            if (fHaveCursor) {
+                readCursor(cursor, cursorTxid.first);
+                readCursor(cursor, cursorTxid.second);
+            }
+            std::set<std::pair<int, std::string> > setPage;
+            for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
+                bool fOk = ForEachAddressIndex((*it).first, (*it).second, [&](const CAddressIndexKey& key, CAmount amount) {
+                    if (fHaveCursor && key.blockHeight < cursorTxid.first)
+                        return true;
+                    // entries come by height, nothing later of this address can make it into the page
+                    if ((int)setPage.size() > limit && key.blockHeight > setPage.rbegin()->first)
+                        return false;
+                    std::pair<int, std::string> txid(key.blockHeight, key.txhash.GetHex());
+                    if (fHaveCursor && !(cursorTxid < txid))
+                        return true;
+                    setPage.insert(txid);
+                    if ((int)setPage.size() > limit + 1)
+                        setPage.erase(std::prev(setPage.end()));
+                    return true;
+                }, indexStart, indexEnd);
+                if (!fOk) {
+                    throw JSONRPCError(RPC_INVALID_ADDRESS_OR_KEY, "No information available for address");
+                }
+            }
+            fMore = (int)setPage.size() > limit;
+            if (fMore)
+                setPage.erase(std::prev(setPage.end()));
+            for (const auto& txid : setPage) {
+                txidsPage.push_back(txid.second);
+            }
+            if (fMore)
+                next << setPage.rbegin()->first << setPage.rbegin()->second;
+        }
+
+        return pageToJSON("txids", txidsPage, fMore ? &next : nullptr);
+    }
+
     std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
 
     for (std::vector<std::pair<uint160, int> >::iterator it = addresses.begin(); it != addresses.end(); it++) {
@@ -426,6 +426,19 @@ UniValue getnetworkinfo(const JSONRPCRequest& request)
             "  }\n"
             "  ,...\n"
             "  ]\n"
+            "  \"compactblocks\": {                   (object) compact block reconstruction statistics\n"
+            "    \"reconstructed\": xxx,              (numeric) compact blocks we tried to reconstruct\n"
+            "    \"specialtxn\": xxx,                 (numeric) transactions taken from InstantSend/PrivateSend txes not in our mempool\n"
+            "    \"roundtripsavoided\": xxx           (numeric) getblocktxn round-trips avoided thanks to these transactions\n"
+            "  }\n"
+            "  \"blockrelay\": {                      (object) block propagation latencies, measured from when we first received a block\n"
+            "    \"announced\": xxx,                  (numeric) blocks announced via cmpctblock before being connected\n"
+            "    \"avgannouncelatency\": xxx,         (numeric) average time until the announcement in milliseconds\n"
+            "    \"maxannouncelatency\": xxx,         (numeric) maximum time until the announcement in milliseconds\n"
+            "    \"connected\": xxx,                  (numeric) blocks connected to the tip\n"
+            "    \"avgconnectlatency\": xxx,          (numeric) average time until the block was connected in milliseconds\n"
+            "    \"maxconnectlatency\": xxx           (numeric) maximum time until the block was connected in milliseconds\n"
+            "  }\n"
             "  \"warnings\": \"...\"                    (string) any network warnings\n"
             "}\n"
             "\nExamples:\n"
@@ -462,6 +475,23 @@ UniValue getnetworkinfo(const JSONRPCRequest& request)
         }
     }
     obj.push_back(Pair("localaddresses", localAddresses));
+    CCompactBlockStats cmpctStats;
+    GetCompactBlockStats(cmpctStats);
+    UniValue cmpctObj(UniValue::VOBJ);
+    cmpctObj.push_back(Pair("reconstructed", cmpctStats.nReconstructed));
+    cmpctObj.push_back(Pair("specialtxn", cmpctStats.nSpecialTxn));
+    cmpctObj.push_back(Pair("roundtripsavoided", cmpctStats.nRoundTripsAvoided));
+    obj.push_back(Pair("compactblocks", cmpctObj));
+    CBlockRelayStats relayStats;
+    GetBlockRelayStats(relayStats);
+    UniValue relayObj(UniValue::VOBJ);
+    relayObj.push_back(Pair("announced", relayStats.nAnnounced));
+    relayObj.push_back(Pair("avgannouncelatency", relayStats.nAnnounced ? relayStats.nAnnounceLatencyTotal * 0.001 / relayStats.nAnnounced : 0.0));
+    relayObj.push_back(Pair("maxannouncelatency", relayStats.nAnnounceLatencyMax * 0.001));
+    relayObj.push_back(Pair("connected", relayStats.nConnected));
+    relayObj.push_back(Pair("avgconnectlatency", relayStats.nConnected ? relayStats.nConnectLatencyTotal * 0.001 / relayStats.nConnected : 0.0));
+    relayObj.push_back(Pair("maxconnectlatency", relayStats.nConnectLatencyMax * 0.001));
+    obj.push_back(Pair("blockrelay", relayObj));
     obj.push_back(Pair("warnings",       GetWarnings("statusbar")));
     return obj;
 }
@@ -34,22 +34,35 @@ UniValue JSONRPCRequestObj(const std::string& strMethod, const UniValue& params,
     return request;
 }
 
-UniValue JSONRPCReplyObj(const UniValue& result, const UniValue& error, const UniValue& id)
+UniValue JSONRPCReplyObj(UniValue result, UniValue error, UniValue id)
 {
     UniValue reply(UniValue::VOBJ);
+    reply.reserve(3);
     if (!error.isNull())
-        reply.push_back(Pair("result", NullUniValue));
+        reply.pushKV("result", NullUniValue);
     else
-        reply.push_back(Pair("result", result));
-    reply.push_back(Pair("error", error));
-    reply.push_back(Pair("id", id));
+        reply.pushKV("result", std::move(result));
+    reply.pushKV("error", std::move(error));
+    reply.pushKV("id", std::move(id));
     return reply;
 }
 
 std::string JSONRPCReply(const UniValue& result, const UniValue& error, const UniValue& id)
 {
-    UniValue reply = JSONRPCReplyObj(result, error, id);
-    return reply.write() + "\n";
+    // Written directly instead of through JSONRPCReplyObj, which would copy the (possibly huge) result
+    std::string strReply;
+    strReply.reserve(1024);
+    strReply += "{\"result\":";
+    if (!error.isNull())
+        NullUniValue.write(strReply);
+    else
+        result.write(strReply);
+    strReply += ",\"error\":";
+    error.write(strReply);
+    strReply += ",\"id\":";
+    id.write(strReply);
+    strReply += "}\n";
+    return strReply;
 }
 
 UniValue JSONRPCError(int code, const std::string& message)
@@ -24,6 +24,8 @@
 #include "evo/simplifiedmns.h"
 
 #include "bls/bls.h"
+#include "bls/bls_worker.h"
+#include "llmq/quorums_init.h"
 
 #ifdef ENABLE_WALLET
 extern UniValue signrawtransaction(const JSONRPCRequest& request);
@@ -602,7 +604,7 @@ UniValue protx_update_service(const JSONRPCRequest& request)
         throw std::runtime_error(strprintf("masternode with proTxHash %s not found", ptx.proTxHash.ToString()));
     }
 
-    if (keyOperator.GetPublicKey() != dmn->pdmnState->pubKeyOperator) {
+    if (keyOperator.GetPublicKey() != dmn->pdmnState->pubKeyOperator.Get()) {
         throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("the operator key does not belong to the registered public key"));
     }
 
@@ -685,7 +687,7 @@ UniValue protx_update_registrar(const JSONRPCRequest& request)
     if (!dmn) {
         throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("masternode %s not found", ptx.proTxHash.ToString()));
     }
-    ptx.pubKeyOperator = dmn->pdmnState->pubKeyOperator;
+    ptx.pubKeyOperator = dmn->pdmnState->pubKeyOperator.Get();
     ptx.keyIDVoting = dmn->pdmnState->keyIDVoting;
     ptx.scriptPayout = dmn->pdmnState->scriptPayout;
 
@@ -773,7 +775,7 @@ UniValue protx_revoke(const JSONRPCRequest& request)
         throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("masternode %s not found", ptx.proTxHash.ToString()));
     }
 
-    if (keyOperator.GetPublicKey() != dmn->pdmnState->pubKeyOperator) {
+    if (keyOperator.GetPublicKey() != dmn->pdmnState->pubKeyOperator.Get()) {
         throw JSONRPCError(RPC_INVALID_PARAMETER, strprintf("the operator key does not belong to the registered public key"));
     }
 
@@ -964,6 +966,7 @@ UniValue protx_list(const JSONRPCRequest& request)
 
         CDeterministicMNList mnList = deterministicMNManager->GetListForBlock(chainActive[height]->GetBlockHash());
         bool onlyValid = type == "valid";
+        ret.reserve(onlyValid ? mnList.GetValidMNsCount() : mnList.GetAllMNsCount());
         mnList.ForEachMN(onlyValid, [&](const CDeterministicMNCPtr& dmn) {
             ret.push_back(BuildDMNListEntry(dmn, detailed));
         });
@@ -1158,6 +1161,41 @@ UniValue bls_generate(const JSONRPCRequest& request)
     return ret;
 }
 
+void bls_cacheinfo_help()
+{
+    throw std::runtime_error(
+            "bls cacheinfo\n"
+            "\nReturns statistics of the cache of aggregated public keys of quorum signers.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"entries\": n,          (numeric) Number of cached aggregated public keys\n"
+            "  \"maxentries\": n,       (numeric) Max. number of cached aggregated public keys\n"
+            "  \"hits\": n,             (numeric) Number of verifications which used a cached key\n"
+            "  \"misses\": n,           (numeric) Number of verifications which had to aggregate the keys\n"
+            "  \"evictions\": n         (numeric) Number of keys removed to stay below the max. number of entries\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("bls cacheinfo", "")
+    );
+}
+
+UniValue bls_cacheinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 1) {
+        bls_cacheinfo_help();
+    }
+
+    auto& cache = llmq::blsPubKeyAggregationCache;
+
+    UniValue ret(UniValue::VOBJ);
+    ret.push_back(Pair("entries", (uint64_t)cache.GetEntryCount()));
+    ret.push_back(Pair("maxentries", (uint64_t)cache.GetMaxEntries()));
+    ret.push_back(Pair("hits", cache.GetHits()));
+    ret.push_back(Pair("misses", cache.GetMisses()));
+    ret.push_back(Pair("evictions", cache.GetEvictions()));
+    return ret;
+}
+
 [[ noreturn ]] void bls_help()
 {
     throw std::runtime_error(
@@ -1168,6 +1206,7 @@ UniValue bls_generate(const JSONRPCRequest& request)
             "1. \"command\"        (string, required) The command to execute\n"
             "\nAvailable commands:\n"
             "  generate          - Create a BLS secret/public key pair\n"
+            "  cacheinfo         - Return statistics of the cache of aggregated public keys\n"
             );
 }
 
@@ -1184,15 +1223,45 @@ UniValue _bls(const JSONRPCRequest& request)
 
     if (command == "generate") {
         return bls_generate(request);
+    } else if (command == "cacheinfo") {
+        return bls_cacheinfo(request);
     } else {
         bls_help();
     }
 }
 
+UniValue getmnlistdiffcacheinfo(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0) {
+        throw std::runtime_error(
+            "getmnlistdiffcacheinfo\n"
+            "\nReturns statistics of the cache of mnlistdiff messages served to SPV clients.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"entries\": n,       (numeric) Number of cached diffs\n"
+            "  \"size\": n,          (numeric) Size of the cached diffs in bytes\n"
+            "  \"maxsize\": n,       (numeric) Max. size of the cache in bytes (-mnlistdiffcachesize)\n"
+            "  \"hits\": n,          (numeric) Number of requests served from the cache\n"
+            "  \"misses\": n,        (numeric) Number of requests which required building the diff\n"
+            "  \"precomputed\": n,   (numeric) Number of diffs built in advance on new tips\n"
+            "  \"evicted\": n        (numeric) Number of diffs removed to stay below the max. size\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getmnlistdiffcacheinfo", "")
+            + HelpExampleRpc("getmnlistdiffcacheinfo", "")
+        );
+    }
+
+    UniValue ret;
+    mnListDiffCache.ToJson(ret);
+    return ret;
+}
+
 static const CRPCCommand commands[] =
 { //  category              name                      actor (function)         okSafeMode
   //  --------------------- ------------------------  -----------------------  ----------
     { "evo",                "bls",                    &_bls,                   false, {}  },
+    { "evo",                "getmnlistdiffcacheinfo", &getmnlistdiffcacheinfo, true,  {}  },
     { "evo",                "protx",                  &protx,                  false, {}  },
 };
 
@@ -27,7 +27,9 @@
 #include <boost/algorithm/string/split.hpp>
 
 #include <algorithm>
+#include <atomic>
 #include <memory> // for unique_ptr
+#include <thread>
 #include <unordered_map>
 
 static bool fRPCRunning = false;
@@ -322,6 +324,157 @@ UniValue stop(const JSONRPCRequest& jsonRequest)
     return "Polis Core server stopping";
 }
 
+static const char* const cheapRPCMethods[] = {
+    "getbestblockhash", "getblockcount", "getblockhash", "getconnectioncount", "getdifficulty",
+    "getindexbuildinfo", "getinfo", "getmempoolinfo", "getmnlistdiffcacheinfo", "getnetworkinfo", "getrpcmetrics", "help",
+    "masternode", "mnsync", "ping", "spork", "stop",
+};
+static const char* const heavyRPCMethods[] = {
+    "dumpwallet", "getaddressdeltas", "getaddressmempool", "getaddresstxids", "getaddressutxos",
+    "getblockhashes", "getblocks", "getchaintips", "getrawmempool", "getspecialtxes", "gettxoutsetinfo",
+    "gobject", "importaddress", "importelectrumwallet", "importmulti", "importprivkey", "importpubkey",
+    "importwallet", "masternodelist", "protx", "verifychain",
+};
+
+//! Work classes of all methods which aren't HTTP_WORK_NORMAL, only changed before the HTTP server starts
+static std::map<std::string, HTTPWorkClass> mapRPCWorkClasses;
+
+bool InitRPCWorkClasses(std::string& strError)
+{
+    mapRPCWorkClasses.clear();
+    for (const char* method : cheapRPCMethods)
+        mapRPCWorkClasses[method] = HTTP_WORK_CHEAP;
+    for (const char* method : heavyRPCMethods)
+        mapRPCWorkClasses[method] = HTTP_WORK_HEAVY;
+
+    if (mapMultiArgs.count("-rpcmethodclass")) {
+        for (const std::string& strArg : mapMultiArgs.at("-rpcmethodclass")) {
+            size_t nPos = strArg.find(':');
+            HTTPWorkClass workClass;
+            if (nPos == std::string::npos || nPos == 0 || !ParseHTTPWorkClass(strArg.substr(nPos + 1), workClass)) {
+                strError = strprintf("Invalid -rpcmethodclass=%s, expected <method>:<cheap|normal|heavy>", strArg);
+                return false;
+            }
+            mapRPCWorkClasses[strArg.substr(0, nPos)] = workClass;
+        }
+    }
+    return true;
+}
+
+HTTPWorkClass GetRPCWorkClass(const std::string& strMethod)
+{
+    auto it = mapRPCWorkClasses.find(strMethod);
+    return it != mapRPCWorkClasses.end() ? it->second : HTTP_WORK_NORMAL;
+}
+
+struct CRPCMethodMetrics
+{
+    uint64_t nCalls{0};
+    uint64_t nErrors{0};
+    int64_t nExecTime{0};
+    int64_t nMaxExecTime{0};
+    uint64_t nQueued{0};
+    int64_t nQueueTime{0};
+    int64_t nMaxQueueTime{0};
+};
+
+static CCriticalSection cs_rpcMetrics;
+//! Timing statistics of the methods called since startup
+static std::map<std::string, CRPCMethodMetrics> mapRPCMetrics;
+
+void RecordRPCQueueTime(const std::string& strMethod, int64_t nQueueTime)
+{
+    // Only keep track of existing methods, so clients can't make this grow without bounds
+    if (!tableRPC[strMethod])
+        return;
+    LOCK(cs_rpcMetrics);
+    CRPCMethodMetrics& metrics = mapRPCMetrics[strMethod];
+    metrics.nQueued++;
+    metrics.nQueueTime += nQueueTime;
+    metrics.nMaxQueueTime = std::max(metrics.nMaxQueueTime, nQueueTime);
+}
+
+static void RecordRPCExecTime(const std::string& strMethod, int64_t nExecTime, bool fError)
+{
+    LOCK(cs_rpcMetrics);
+    CRPCMethodMetrics& metrics = mapRPCMetrics[strMethod];
+    metrics.nCalls++;
+    if (fError)
+        metrics.nErrors++;
+    metrics.nExecTime += nExecTime;
+    metrics.nMaxExecTime = std::max(metrics.nMaxExecTime, nExecTime);
+}
+
+UniValue getrpcmetrics(const JSONRPCRequest& jsonRequest)
+{
+    if (jsonRequest.fHelp || jsonRequest.params.size() != 0)
+        throw std::runtime_error(
+            "getrpcmetrics\n"
+            "\nReturns the state of the RPC work queues and timing statistics of the RPC methods called since startup.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"queues\": [             (array) One entry per work class\n"
+            "    {\n"
+            "      \"class\": \"xxxx\",     (string) The work class: cheap, normal or heavy\n"
+            "      \"threads\": n,        (numeric) The number of worker threads\n"
+            "      \"depth\": n,          (numeric) The number of requests waiting for a worker thread\n"
+            "      \"maxdepth\": n,       (numeric) Requests beyond this depth are rejected\n"
+            "      \"processed\": n,      (numeric) The number of requests handled\n"
+            "      \"rejected\": n        (numeric) The number of requests rejected because the queue was full\n"
+            "    }, ...\n"
+            "  ],\n"
+            "  \"methods\": {\n"
+            "    \"method\": {\n"
+            "      \"class\": \"xxxx\",     (string) The work class of the method\n"
+            "      \"calls\": n,          (numeric) The number of calls\n"
+            "      \"errors\": n,         (numeric) The number of calls which failed\n"
+            "      \"queuetime_avg\": n,  (numeric) The average time calls waited for a worker thread, in microseconds\n"
+            "      \"queuetime_max\": n,  (numeric) The longest time a call waited for a worker thread, in microseconds\n"
+            "      \"exectime_avg\": n,   (numeric) The average execution time, in microseconds\n"
+            "      \"exectime_max\": n    (numeric) The longest execution time, in microseconds\n"
+            "    }, ...\n"
+            "  }\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getrpcmetrics", "")
+            + HelpExampleRpc("getrpcmetrics", "")
+        );
+
+    UniValue queues(UniValue::VARR);
+    for (const HTTPWorkQueueStats& stats : GetHTTPWorkQueueStats()) {
+        UniValue obj(UniValue::VOBJ);
+        obj.push_back(Pair("class", HTTPWorkClassName(stats.workClass)));
+        obj.push_back(Pair("threads", stats.nThreads));
+        obj.push_back(Pair("depth", (uint64_t)stats.nDepth));
+        obj.push_back(Pair("maxdepth", (uint64_t)stats.nMaxDepth));
+        obj.push_back(Pair("processed", stats.nProcessed));
+        obj.push_back(Pair("rejected", stats.nRejected));
+        queues.push_back(obj);
+    }
+
+    UniValue methods(UniValue::VOBJ);
+    {
+        LOCK(cs_rpcMetrics);
+        for (const auto& pair : mapRPCMetrics) {
+            const CRPCMethodMetrics& metrics = pair.second;
+            UniValue obj(UniValue::VOBJ);
+            obj.push_back(Pair("class", HTTPWorkClassName(GetRPCWorkClass(pair.first))));
+            obj.push_back(Pair("calls", metrics.nCalls));
+            obj.push_back(Pair("errors", metrics.nErrors));
+            obj.push_back(Pair("queuetime_avg", metrics.nQueued ? metrics.nQueueTime / (int64_t)metrics.nQueued : 0));
+            obj.push_back(Pair("queuetime_max", metrics.nMaxQueueTime));
+            obj.push_back(Pair("exectime_avg", metrics.nCalls ? metrics.nExecTime / (int64_t)metrics.nCalls : 0));
+            obj.push_back(Pair("exectime_max", metrics.nMaxExecTime));
+            methods.push_back(Pair(pair.first, obj));
+        }
+    }
+
+    UniValue result(UniValue::VOBJ);
+    result.push_back(Pair("queues", queues));
+    result.push_back(Pair("methods", methods));
+    return result;
+}
+
 /**
  * Call Table
  */
@@ -329,6 +482,7 @@ static const CRPCCommand vRPCCommands[] =
 { //  category              name                      actor (function)         okSafe argNames
   //  --------------------- ------------------------  -----------------------  ------ ----------
     /* Overall control/query calls */
+    { "control",            "getrpcmetrics",          &getrpcmetrics,          true,  {}  },
     { "control",            "help",                   &help,                   true,  {"command"}  },
     { "control",            "stop",                   &stop,                   true,  {}  },
 };
@@ -455,7 +609,7 @@ static UniValue JSONRPCExecOne(const UniValue& req)
         jreq.parse(req);
 
         UniValue result = tableRPC.execute(jreq);
-        rpc_result = JSONRPCReplyObj(result, NullUniValue, jreq.id);
+        rpc_result = JSONRPCReplyObj(std::move(result), NullUniValue, jreq.id);
     }
     catch (const UniValue& objError)
     {
@@ -470,12 +624,50 @@ static UniValue JSONRPCExecOne(const UniValue& req)
     return rpc_result;
 }
 
+/** Methods which only read, so calls to them don't depend on the order they are executed in */
+static const char* const parallelRPCMethods[] = {
+    "decoderawtransaction", "decodescript", "getaddressbalance", "getaddressdeltas", "getaddressmempool",
+    "getaddresstxids", "getaddressutxos", "getbestblockhash", "getblock", "getblockcount", "getblockhash",
+    "getblockhashes", "getblockheader", "getblockheaders", "getblocks", "getmempoolentry", "getrawtransaction",
+    "getspecialtxes", "getspentinfo", "gettxout", "gettxoutproof", "verifytxoutproof",
+};
+
+static bool CanExecBatchInParallel(const UniValue& vReq)
+{
+    static const std::set<std::string> setParallelMethods(std::begin(parallelRPCMethods), std::end(parallelRPCMethods));
+    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++) {
+        const UniValue& method = vReq[reqIdx].isObject() ? find_value(vReq[reqIdx], "method") : NullUniValue;
+        if (!method.isStr() || !setParallelMethods.count(method.get_str()))
+            return false;
+    }
+    return true;
+}
+
 std::string JSONRPCExecBatch(const UniValue& vReq)
 {
-    UniValue ret(UniValue::VARR);
-    for (unsigned int reqIdx = 0; reqIdx < vReq.size(); reqIdx++)
-        ret.push_back(JSONRPCExecOne(vReq[reqIdx]));
+    int nThreads = std::min((int)GetArg("-rpcbatchthreads", DEFAULT_RPC_BATCH_THREADS), MAX_RPC_BATCH_THREADS);
+    if ((size_t)nThreads > vReq.size())
+        nThreads = vReq.size();
+    if (nThreads > 1 && !CanExecBatchInParallel(vReq))
+        nThreads = 1;
+
+    std::vector<UniValue> vReplies(vReq.size());
+    std::atomic<size_t> nNext(0);
+    auto worker = [&]() {
+        size_t n;
+        while ((n = nNext++) < vReq.size())
+            vReplies[n] = JSONRPCExecOne(vReq[n]);
+    };
+
+    std::vector<std::thread> vThreads;
+    for (int i = 1; i < nThreads; i++)
+        vThreads.emplace_back(worker);
+    worker();
+    for (auto& thread : vThreads)
+        thread.join();
 
+    UniValue ret(UniValue::VARR);
+    ret.push_backV(vReplies);
     return ret.write() + "\n";
 }
 
@@ -545,19 +737,29 @@ UniValue CRPCTable::execute(const JSONRPCRequest &request) const
 
     g_rpcSignals.PreCommand(*pcmd);
 
+    const int64_t nTimeStart = GetTimeMicros();
     try
     {
         // Execute, convert arguments to array if necessary
+        UniValue result;
         if (request.params.isObject()) {
-            return pcmd->actor(transformNamedArguments(request, pcmd->argNames));
+            result = pcmd->actor(transformNamedArguments(request, pcmd->argNames));
         } else {
-            return pcmd->actor(request);
+            result = pcmd->actor(request);
         }
+        RecordRPCExecTime(pcmd->name, GetTimeMicros() - nTimeStart, false);
+        return result;
     }
     catch (const std::exception& e)
     {
+        RecordRPCExecTime(pcmd->name, GetTimeMicros() - nTimeStart, true);
         throw JSONRPCError(RPC_MISC_ERROR, e.what());
     }
+    catch (...)
+    {
+        RecordRPCExecTime(pcmd->name, GetTimeMicros() - nTimeStart, true);
+        throw;
+    }
 
     g_rpcSignals.PostCommand(*pcmd);
 }
@@ -7,6 +7,7 @@
 #define BITCOIN_RPCSERVER_H
 
 #include "amount.h"
+#include "httpserver.h"
 #include "rpc/protocol.h"
 #include "uint256.h"
 
@@ -21,6 +22,10 @@
 
 class CRPCCommand;
 
+//! -rpcbatchthreads default, max. number of threads executing the calls of a batch request
+static const int DEFAULT_RPC_BATCH_THREADS = 4;
+static const int MAX_RPC_BATCH_THREADS = 16;
+
 namespace RPCServer
 {
     void OnStarted(boost::function<void ()> slot);
@@ -178,6 +183,18 @@ public:
 
 extern CRPCTable tableRPC;
 
+/**
+ * Work class of a RPC method, i.e. the HTTP work queue calls to it are handled by. Unless changed
+ * with -rpcmethodclass, cheap status calls are HTTP_WORK_CHEAP, calls which can take seconds (index
+ * lookups, listing all governance objects or masternodes, ...) are HTTP_WORK_HEAVY and everything
+ * else is HTTP_WORK_NORMAL.
+ */
+HTTPWorkClass GetRPCWorkClass(const std::string& strMethod);
+/** Apply -rpcmethodclass, before the HTTP server is started */
+bool InitRPCWorkClasses(std::string& strError);
+/** Record the time (in microseconds) a call to strMethod waited for a worker thread, for getrpcmetrics */
+void RecordRPCQueueTime(const std::string& strMethod, int64_t nQueueTime);
+
 /**
  * Utilities: convert hex-encoded Values
  * (throws error if not hex).
@@ -205,6 +222,11 @@ extern void EnsureWalletIsUnlocked();
 bool StartRPC();
 void InterruptRPC();
 void StopRPC();
+/**
+ * Execute a batch request. If all of its calls are to read-only methods, they are executed concurrently
+ * by up to -rpcbatchthreads threads, otherwise one after the other. Either way, the replies are in
+ * request order.
+ */
 std::string JSONRPCExecBatch(const UniValue& vReq);
 void RPCNotifyBlockChange(bool ibd, const CBlockIndex *);
 
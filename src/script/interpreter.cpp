@@ -11,6 +11,7 @@
 #include "crypto/sha256.h"
 #include "pubkey.h"
 #include "script/script.h"
+#include "streams.h"
 #include "uint256.h"
 
 typedef std::vector<unsigned char> valtype;
@@ -1119,7 +1120,34 @@ public:
 
 } // anon namespace
 
-uint256 SignatureHash(const CScript& scriptCode, const CTransaction& txTo, unsigned int nIn, int nHashType)
+PrecomputedTransactionData::PrecomputedTransactionData(const CTransaction& txTo)
+{
+    // single input txs don't profit from the midstates
+    if (txTo.vin.size() < 2) {
+        return;
+    }
+
+    // an empty scriptCode serializes just like the blanked out scripts of the other inputs
+    CScript emptyScript;
+    CTransactionSignatureSerializer txTmp(txTo, emptyScript, 0, SIGHASH_ALL);
+    CVectorWriter(SER_GETHASH, 0, vchBlankedTx, 0, txTmp);
+
+    // each input is serialized as prevout (36 bytes), script (1 byte) and nSequence (4 bytes)
+    size_t nOffset = sizeof(int32_t) + GetSizeOfCompactSize(txTo.vin.size()) + 36;
+    vScriptOffsets.reserve(txTo.vin.size());
+    vMidstates.reserve(txTo.vin.size());
+
+    CHashWriter ss(SER_GETHASH, 0);
+    size_t nHashed = 0;
+    for (size_t i = 0; i < txTo.vin.size(); i++, nOffset += 41) {
+        ss.write((const char*)&vchBlankedTx[nHashed], nOffset - nHashed);
+        nHashed = nOffset;
+        vScriptOffsets.emplace_back(nOffset);
+        vMidstates.emplace_back(ss);
+    }
+}
+
+uint256 SignatureHash(const CScript& scriptCode, const CTransaction& txTo, unsigned int nIn, int nHashType, const PrecomputedTransactionData* cache)
 {
     static const uint256 one(uint256S("0000000000000000000000000000000000000000000000000000000000000001"));
     if (nIn >= txTo.vin.size()) {
@@ -1138,6 +1166,18 @@ uint256 SignatureHash(const CScript& scriptCode, const CTransaction& txTo, unsig
     // Wrapper to serialize only the necessary parts of the transaction being signed
     CTransactionSignatureSerializer txTmp(txTo, scriptCode, nIn, nHashType);
 
+    bool fSighashAll = !(nHashType & SIGHASH_ANYONECANPAY) && (nHashType & 0x1f) != SIGHASH_SINGLE && (nHashType & 0x1f) != SIGHASH_NONE;
+    if (cache && fSighashAll && !cache->vMidstates.empty()) {
+        assert(cache->vMidstates.size() == txTo.vin.size());
+        // continue after everything in front of this input's script, replace the blanked out script and reuse the rest
+        size_t nRestOffset = cache->vScriptOffsets[nIn] + 1;
+        CHashWriter ss(cache->vMidstates[nIn]);
+        txTmp.SerializeScriptCode(ss);
+        ss.write((const char*)&cache->vchBlankedTx[nRestOffset], cache->vchBlankedTx.size() - nRestOffset);
+        ss << nHashType;
+        return ss.GetHash();
+    }
+
     // Serialize and hash
     CHashWriter ss(SER_GETHASH, 0);
     ss << txTmp << nHashType;
@@ -1162,7 +1202,7 @@ bool TransactionSignatureChecker::CheckSig(const std::vector<unsigned char>& vch
     int nHashType = vchSig.back();
     vchSig.pop_back();
 
-    uint256 sighash = SignatureHash(scriptCode, *txTo, nIn, nHashType);
+    uint256 sighash = SignatureHash(scriptCode, *txTo, nIn, nHashType, txdata);
 
     if (!VerifySignature(vchSig, pubkey, sighash))
         return false;
@@ -0,0 +1,192 @@
+// Copyright (c) 2019 The Polis Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef POLIS_SUPPORT_ALLOCATORS_POOL_H
+#define POLIS_SUPPORT_ALLOCATORS_POOL_H
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <list>
+#include <new>
+#include <utility>
+
+/**
+ * A memory resource which hands out small, equally aligned blocks from large chunks.
+ *
+ * Node based containers like std::unordered_map make one allocation per element. With millions of
+ * elements (e.g. the coins cache during IBD) the general purpose allocator's per-allocation overhead
+ * and the resulting fragmentation become significant. PoolResource instead carves blocks of up to
+ * MAX_BLOCK_SIZE_BYTES out of chunks of CHUNK_SIZE_BYTES, keeps freed blocks in one free list per
+ * block size and only returns memory to the system when the resource itself is destroyed. Larger
+ * or over-aligned requests are forwarded to ::operator new.
+ *
+ * This is not thread-safe, the owner has to synchronize accesses (just like for the container).
+ */
+template <std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+class PoolResource
+{
+    static_assert(ALIGN_BYTES > 0 && (ALIGN_BYTES & (ALIGN_BYTES - 1)) == 0, "ALIGN_BYTES must be a power of two");
+    static_assert(ALIGN_BYTES <= alignof(std::max_align_t), "chunks are only aligned to max_align_t");
+
+    /** In-place linked list of free blocks. */
+    struct ListNode
+    {
+        ListNode* next;
+        explicit ListNode(ListNode* nextIn) : next(nextIn) {}
+    };
+
+public:
+    static const std::size_t ELEM_ALIGN_BYTES = ALIGN_BYTES > alignof(ListNode) ? ALIGN_BYTES : alignof(ListNode);
+    static const std::size_t DEFAULT_CHUNK_SIZE_BYTES = 256 * 1024;
+
+private:
+    static_assert(ELEM_ALIGN_BYTES >= sizeof(ListNode), "a free block must be able to hold a ListNode");
+
+    const std::size_t nChunkSizeBytes;
+    std::list<void*> allocatedChunks;
+    /** Free lists, indexed by block size in multiples of ELEM_ALIGN_BYTES */
+    std::array<ListNode*, MAX_BLOCK_SIZE_BYTES / ELEM_ALIGN_BYTES + 1> freeLists;
+    /** Not yet handed out part of the current chunk */
+    char* pAvailableBegin{nullptr};
+    char* pAvailableEnd{nullptr};
+
+    static std::size_t NumElemAlignBytes(std::size_t bytes)
+    {
+        return (bytes + ELEM_ALIGN_BYTES - 1) / ELEM_ALIGN_BYTES + (bytes == 0);
+    }
+
+    static bool IsFreeListUsable(std::size_t bytes, std::size_t alignment)
+    {
+        return alignment <= ELEM_ALIGN_BYTES && bytes <= MAX_BLOCK_SIZE_BYTES;
+    }
+
+    void PushFree(void* p, std::size_t nNumAlignments)
+    {
+        freeLists[nNumAlignments] = new (p) ListNode(freeLists[nNumAlignments]);
+    }
+
+    void AllocateChunk()
+    {
+        // keep the rest of the current chunk, it fits into exactly one free list
+        std::size_t nRemaining = pAvailableEnd - pAvailableBegin;
+        if (nRemaining != 0) {
+            PushFree(pAvailableBegin, nRemaining / ELEM_ALIGN_BYTES);
+        }
+
+        void* pChunk = ::operator new(nChunkSizeBytes);
+        allocatedChunks.emplace_back(pChunk);
+        pAvailableBegin = static_cast<char*>(pChunk);
+        pAvailableEnd = pAvailableBegin + nChunkSizeBytes;
+    }
+
+public:
+    explicit PoolResource(std::size_t nChunkSizeBytesIn = DEFAULT_CHUNK_SIZE_BYTES) :
+        nChunkSizeBytes(NumElemAlignBytes(nChunkSizeBytesIn) * ELEM_ALIGN_BYTES)
+    {
+        assert(nChunkSizeBytes >= MAX_BLOCK_SIZE_BYTES);
+        freeLists.fill(nullptr);
+    }
+
+    PoolResource(const PoolResource&) = delete;
+    PoolResource& operator=(const PoolResource&) = delete;
+
+    ~PoolResource()
+    {
+        for (void* pChunk : allocatedChunks) {
+            ::operator delete(pChunk);
+        }
+    }
+
+    void* Allocate(std::size_t bytes, std::size_t alignment)
+    {
+        if (!IsFreeListUsable(bytes, alignment)) {
+            return ::operator new(bytes);
+        }
+
+        const std::size_t nNumAlignments = NumElemAlignBytes(bytes);
+        if (freeLists[nNumAlignments] != nullptr) {
+            ListNode* pNode = freeLists[nNumAlignments];
+            freeLists[nNumAlignments] = pNode->next;
+            pNode->~ListNode();
+            return pNode;
+        }
+
+        const std::size_t nRoundedBytes = nNumAlignments * ELEM_ALIGN_BYTES;
+        if (nRoundedBytes > static_cast<std::size_t>(pAvailableEnd - pAvailableBegin)) {
+            AllocateChunk();
+        }
+        void* p = pAvailableBegin;
+        pAvailableBegin += nRoundedBytes;
+        return p;
+    }
+
+    void Deallocate(void* p, std::size_t bytes, std::size_t alignment) noexcept
+    {
+        if (!IsFreeListUsable(bytes, alignment)) {
+            ::operator delete(p);
+            return;
+        }
+        PushFree(p, NumElemAlignBytes(bytes));
+    }
+
+    std::size_t NumAllocatedChunks() const { return allocatedChunks.size(); }
+    std::size_t ChunkSizeBytes() const { return nChunkSizeBytes; }
+};
+
+/**
+ * STL compatible allocator which takes its memory from a PoolResource. All copies (including
+ * rebound ones) share the resource, which must outlive the container using the allocator.
+ */
+template <class T, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES = alignof(T)>
+class PoolAllocator
+{
+public:
+    typedef PoolResource<MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES> ResourceType;
+    typedef T value_type;
+
+    template <typename U>
+    struct rebind {
+        typedef PoolAllocator<U, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES> other;
+    };
+
+private:
+    ResourceType* resource;
+
+public:
+    PoolAllocator(ResourceType* resourceIn) noexcept : resource(resourceIn) {}
+    PoolAllocator(const PoolAllocator& other) noexcept = default;
+    PoolAllocator& operator=(const PoolAllocator& other) noexcept = default;
+
+    template <typename U>
+    PoolAllocator(const PoolAllocator<U, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& other) noexcept : resource(other.GetResource()) {}
+
+    T* allocate(std::size_t n)
+    {
+        return static_cast<T*>(resource->Allocate(n * sizeof(T), alignof(T)));
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept
+    {
+        resource->Deallocate(p, n * sizeof(T), alignof(T));
+    }
+
+    ResourceType* GetResource() const noexcept { return resource; }
+};
+
+template <class T1, class T2, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+bool operator==(const PoolAllocator<T1, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& a,
+                const PoolAllocator<T2, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& b) noexcept
+{
+    return a.GetResource() == b.GetResource();
+}
+
+template <class T1, class T2, std::size_t MAX_BLOCK_SIZE_BYTES, std::size_t ALIGN_BYTES>
+bool operator!=(const PoolAllocator<T1, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& a,
+                const PoolAllocator<T2, MAX_BLOCK_SIZE_BYTES, ALIGN_BYTES>& b) noexcept
+{
+    return !(a == b);
+}
+
+#endif // POLIS_SUPPORT_ALLOCATORS_POOL_H
@@ -4,9 +4,12 @@
 
 #include "util.h"
 
+#include "support/allocators/pool.h"
 #include "support/allocators/secure.h"
 #include "test/test_polis.h"
 
+#include <unordered_map>
+
 #include <boost/test/unit_test.hpp>
 
 BOOST_FIXTURE_TEST_SUITE(allocator_tests, BasicTestingSetup)
@@ -231,4 +234,60 @@ BOOST_AUTO_TEST_CASE(lockedpool_tests_live)
     BOOST_CHECK(pool.stats().used == initial.used);
 }
 
+BOOST_AUTO_TEST_CASE(pool_resource_tests)
+{
+    PoolResource<32, 8> resource(1024);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 0U);
+
+    // Blocks are handed out from one chunk until it is full
+    void* a = resource.Allocate(8, 8);
+    void* b = resource.Allocate(16, 8);
+    BOOST_CHECK(a != b);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 1U);
+    BOOST_CHECK_EQUAL(static_cast<char*>(b) - static_cast<char*>(a), 8);
+
+    // Freed blocks are reused for the same size only
+    resource.Deallocate(a, 8, 8);
+    void* c = resource.Allocate(16, 8);
+    BOOST_CHECK(c != a);
+    void* d = resource.Allocate(7, 8);
+    BOOST_CHECK(d == a);
+
+    // Too large or over-aligned requests don't use the pool
+    void* big = resource.Allocate(33, 8);
+    resource.Deallocate(big, 33, 8);
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 1U);
+
+    // Running out of space allocates a new chunk
+    std::vector<void*> blocks;
+    for (int i = 0; i < 40; i++) {
+        blocks.push_back(resource.Allocate(32, 8));
+    }
+    BOOST_CHECK_EQUAL(resource.NumAllocatedChunks(), 2U);
+    for (void* p : blocks) {
+        resource.Deallocate(p, 32, 8);
+    }
+    resource.Deallocate(b, 16, 8);
+    resource.Deallocate(c, 16, 8);
+    resource.Deallocate(d, 8, 8);
+
+    // Containers work on top of it
+    typedef PoolAllocator<std::pair<const int, int>, 64, alignof(void*)> Alloc;
+    Alloc::ResourceType mapResource;
+    {
+        std::unordered_map<int, int, std::hash<int>, std::equal_to<int>, Alloc> map(0, std::hash<int>(), std::equal_to<int>(), Alloc(&mapResource));
+        for (int i = 0; i < 1000; i++) {
+            map[i] = i * 2;
+        }
+        for (int i = 0; i < 1000; i += 2) {
+            map.erase(i);
+        }
+        BOOST_CHECK_EQUAL(map.size(), 500U);
+        for (int i = 1; i < 1000; i += 2) {
+            BOOST_CHECK_EQUAL(map[i], i * 2);
+        }
+    }
+    BOOST_CHECK_EQUAL(mapResource.NumAllocatedChunks(), 1U);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
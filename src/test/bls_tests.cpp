@@ -0,0 +1,229 @@
+// Copyright (c) 2018 The Polis Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "test/test_polis.h"
+#include "test/test_random.h"
+
+#include "bls/bls.h"
+#include "bls/bls_worker.h"
+#include "clientversion.h"
+#include "random.h"
+#include "streams.h"
+
+#include <algorithm>
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(bls_tests, BasicTestingSetup)
+
+static void BuildSigners(size_t count, const uint256& msgHash, BLSPublicKeyVector& pks, BLSSignatureVector& sigs)
+{
+    pks.clear();
+    sigs.clear();
+    for (size_t i = 0; i < count; i++) {
+        CBLSSecretKey sk;
+        sk.MakeNewKey();
+        pks.emplace_back(sk.GetPublicKey());
+        sigs.emplace_back(sk.Sign(msgHash));
+    }
+}
+
+static void CheckAggregateSecure(const BLSPublicKeyVector& pks, const BLSSignatureVector& sigs, const uint256& msgHash)
+{
+    CBLSSignature aggSig = CBLSSignature::AggregateSecure(sigs, pks, msgHash);
+    CBLSPublicKey aggPk = CBLSPublicKey::AggregateSecure(pks);
+    BOOST_CHECK(aggSig.IsValid() && aggPk.IsValid());
+    BOOST_CHECK(aggSig.VerifySecureAggregated(pks, msgHash));
+    BOOST_CHECK(aggSig.VerifyInsecure(aggPk, msgHash));
+
+    uint256 otherHash = GetRandHash();
+    BOOST_CHECK_EQUAL(aggSig.VerifySecureAggregated(pks, otherHash), aggSig.VerifyInsecure(aggPk, otherHash));
+    BOOST_CHECK(!aggSig.VerifyInsecure(aggPk, otherHash));
+}
+
+BOOST_AUTO_TEST_CASE(bls_pubkey_aggregate_secure)
+{
+    BLSPublicKeyVector pks;
+    BLSSignatureVector sigs;
+
+    for (size_t count : {(size_t)1, (size_t)2, (size_t)3, (size_t)10, (size_t)(1 + insecure_rand() % 20)}) {
+        uint256 msgHash = GetRandHash();
+        BuildSigners(count, msgHash, pks, sigs);
+        CheckAggregateSecure(pks, sigs, msgHash);
+
+        // the coefficients don't depend on the order of the keys
+        std::vector<size_t> order(count);
+        for (size_t i = 0; i < count; i++) {
+            order[i] = i;
+        }
+        std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return pks[b].GetHash() < pks[a].GetHash(); });
+        BLSPublicKeyVector unsortedPks;
+        BLSSignatureVector unsortedSigs;
+        for (size_t i : order) {
+            unsortedPks.emplace_back(pks[i]);
+            unsortedSigs.emplace_back(sigs[i]);
+        }
+        CheckAggregateSecure(unsortedPks, unsortedSigs, msgHash);
+        BOOST_CHECK(CBLSPublicKey::AggregateSecure(unsortedPks) == CBLSPublicKey::AggregateSecure(pks));
+    }
+
+    // secure aggregation is not the same as insecure aggregation
+    uint256 msgHash = GetRandHash();
+    BuildSigners(3, msgHash, pks, sigs);
+    BOOST_CHECK(CBLSPublicKey::AggregateSecure(pks) != CBLSPublicKey::AggregateInsecure(pks));
+
+    BOOST_CHECK(!CBLSPublicKey::AggregateSecure(BLSPublicKeyVector()).IsValid());
+    pks.emplace_back(CBLSPublicKey());
+    BOOST_CHECK(!CBLSPublicKey::AggregateSecure(pks).IsValid());
+}
+
+BOOST_AUTO_TEST_CASE(bls_pubkey_aggregation_cache)
+{
+    BLSPublicKeyVector pks;
+    BLSSignatureVector sigs;
+    BuildSigners(3, GetRandHash(), pks, sigs);
+
+    CBLSPubKeyAggregationCache cache(2);
+    CBLSPublicKey pk;
+    uint256 key1 = GetRandHash(), key2 = GetRandHash(), key3 = GetRandHash();
+
+    BOOST_CHECK(!cache.Get(key1, pk));
+    BOOST_CHECK_EQUAL(cache.GetMisses(), 1);
+
+    cache.Put(key1, pks[0]);
+    cache.Put(key2, pks[1]);
+    BOOST_CHECK_EQUAL(cache.GetEntryCount(), 2);
+    BOOST_CHECK(cache.Get(key1, pk) && pk == pks[0]);
+    BOOST_CHECK_EQUAL(cache.GetHits(), 1);
+
+    // key2 is now the least recently used entry
+    cache.Put(key3, pks[2]);
+    BOOST_CHECK_EQUAL(cache.GetEntryCount(), 2);
+    BOOST_CHECK_EQUAL(cache.GetEvictions(), 1);
+    BOOST_CHECK(!cache.Get(key2, pk));
+    BOOST_CHECK(cache.Get(key1, pk) && pk == pks[0]);
+    BOOST_CHECK(cache.Get(key3, pk) && pk == pks[2]);
+
+    // existing entries are not replaced
+    cache.Put(key3, pks[0]);
+    BOOST_CHECK(cache.Get(key3, pk) && pk == pks[2]);
+
+    BOOST_CHECK_EQUAL(cache.GetHits(), 4);
+    BOOST_CHECK_EQUAL(cache.GetMisses(), 2);
+    BOOST_CHECK_EQUAL(cache.GetEvictions(), 1);
+
+    cache.Clear();
+    BOOST_CHECK_EQUAL(cache.GetEntryCount(), 0);
+    BOOST_CHECK(!cache.Get(key1, pk));
+
+    CBLSPubKeyAggregationCache disabledCache(0);
+    disabledCache.Put(key1, pks[0]);
+    BOOST_CHECK_EQUAL(disabledCache.GetEntryCount(), 0);
+}
+
+BOOST_AUTO_TEST_CASE(bls_worker_verify_secure_aggregated_cached)
+{
+    CBLSWorker worker;
+    CBLSPubKeyAggregationCache cache(10);
+
+    BLSPublicKeyVector pks;
+    BLSSignatureVector sigs;
+    uint256 msgHash = GetRandHash();
+    BuildSigners(5, msgHash, pks, sigs);
+    CBLSSignature aggSig = CBLSSignature::AggregateSecure(sigs, pks, msgHash);
+    uint256 cacheKey = GetRandHash();
+
+    // the first verification aggregates the keys and fills the cache, the second one only uses the cached key
+    BOOST_CHECK(worker.AsyncVerifySecureAggregatedSig(aggSig, pks, msgHash, &cache, cacheKey).get());
+    BOOST_CHECK_EQUAL(cache.GetMisses(), 1);
+    BOOST_CHECK_EQUAL(cache.GetEntryCount(), 1);
+    BOOST_CHECK(worker.AsyncVerifySecureAggregatedSig(aggSig, pks, msgHash, &cache, cacheKey).get());
+    BOOST_CHECK_EQUAL(cache.GetHits(), 1);
+
+    BOOST_CHECK(!worker.AsyncVerifySecureAggregatedSig(aggSig, pks, GetRandHash(), &cache, cacheKey).get());
+    BOOST_CHECK(!worker.AsyncVerifySecureAggregatedSig(sigs[0], pks, msgHash, &cache, cacheKey).get());
+    BOOST_CHECK(worker.AsyncVerifySecureAggregatedSig(aggSig, pks, msgHash).get());
+
+    worker.Stop();
+}
+
+BOOST_AUTO_TEST_CASE(bls_verify_insecure_batched)
+{
+    BLSPublicKeyVector pks;
+    BLSSignatureVector sigs;
+    std::vector<uint256> msgHashes;
+    for (size_t i = 0; i < 16; i++) {
+        CBLSSecretKey sk;
+        sk.MakeNewKey();
+        msgHashes.emplace_back(GetRandHash());
+        pks.emplace_back(sk.GetPublicKey());
+        sigs.emplace_back(sk.Sign(msgHashes.back()));
+    }
+    BOOST_CHECK(CBLSSignature::VerifyInsecureBatched(sigs, pks, msgHashes));
+
+    // two invalid sigs which cancel each other out pass an insecure aggregated check, but not the batched one
+    CBLSSecretKey sk;
+    sk.MakeNewKey();
+    CBLSSignature x = sk.Sign(GetRandHash());
+    BLSSignatureVector badSigs = sigs;
+    badSigs[3].AggregateInsecure(x);
+    badSigs[7].SubInsecure(x);
+    BOOST_CHECK(!badSigs[3].VerifyInsecure(pks[3], msgHashes[3]) && !badSigs[7].VerifyInsecure(pks[7], msgHashes[7]));
+    BOOST_CHECK(CBLSSignature::AggregateInsecure(badSigs).VerifyInsecureAggregated(pks, msgHashes));
+    BOOST_CHECK(!CBLSSignature::VerifyInsecureBatched(badSigs, pks, msgHashes));
+
+    // the worker finds exactly the invalid sigs, no matter how large the batches are
+    CBLSWorker worker;
+    for (size_t batchSize : {(size_t)1, (size_t)3, (size_t)16}) {
+        auto valid = worker.VerifySigBatch(badSigs, pks, msgHashes, batchSize);
+        BOOST_REQUIRE_EQUAL(valid.size(), badSigs.size());
+        for (size_t i = 0; i < valid.size(); i++) {
+            BOOST_CHECK_EQUAL(valid[i], i != 3 && i != 7);
+        }
+    }
+    worker.Stop();
+}
+
+BOOST_AUTO_TEST_CASE(bls_lazy_pubkey)
+{
+    CBLSSecretKey sk;
+    sk.MakeNewKey();
+    CBLSPublicKey pk = sk.GetPublicKey();
+
+    // round trip through the serialized form, which is the same as the one of the eager type
+    CDataStream ds(SER_DISK, CLIENT_VERSION);
+    ds << pk;
+    std::string eagerBytes = ds.str();
+    CBLSLazyPublicKey lazy;
+    ds >> lazy;
+    BOOST_CHECK(lazy.GetHash() == pk.GetHash());
+    BOOST_CHECK(lazy.Get() == pk);
+    ds << lazy;
+    BOOST_CHECK(ds.str() == eagerBytes);
+
+    // comparison works on the serialized form, no matter if the object was deserialized or not
+    CBLSLazyPublicKey lazy2;
+    ds >> lazy2;
+    BOOST_CHECK(lazy == lazy2);
+    BOOST_CHECK(lazy2 == CBLSLazyPublicKey(pk));
+    CBLSSecretKey sk2;
+    sk2.MakeNewKey();
+    BOOST_CHECK(lazy2 != CBLSLazyPublicKey(sk2.GetPublicKey()));
+    BOOST_CHECK(CBLSLazyPublicKey() == CBLSLazyPublicKey(CBLSPublicKey()));
+    BOOST_CHECK(!CBLSLazyPublicKey().Get().IsValid());
+
+    // invalid bytes result in an invalid object, but the bytes and the hash are kept
+    std::vector<unsigned char> invalidBytes(CBLSPublicKey::SerSize, 0xff);
+    ds.write((const char*)invalidBytes.data(), invalidBytes.size());
+    CBLSLazyPublicKey invalid;
+    ds >> invalid;
+    uint256 invalidHash = invalid.GetHash();
+    BOOST_CHECK(!invalid.Get().IsValid());
+    BOOST_CHECK(invalid.GetHash() == invalidHash);
+    BOOST_CHECK(invalid != CBLSLazyPublicKey());
+    ds << invalid;
+    BOOST_CHECK(std::vector<unsigned char>(ds.begin(), ds.end()) == invalidBytes);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "coins.h"
+#include "txdb.h"
 #include "script/standard.h"
 #include "uint256.h"
 #include "undo.h"
@@ -587,7 +588,8 @@ void GetCoinsMapEntry(const CCoinsMap& map, CAmount& value, char& flags)
 
 void WriteCoinsViewEntry(CCoinsView& view, CAmount value, char flags)
 {
-    CCoinsMap map;
+    CCoinsMapMemoryResource resource;
+    CCoinsMap map(0, SaltedOutpointHasher(), CCoinsMap::key_equal(), &resource);
     InsertCoinsMapEntry(map, value, flags);
     view.BatchWrite(map, {});
 }
@@ -856,4 +858,75 @@ BOOST_AUTO_TEST_CASE(ccoins_write)
                     CheckWriteCoins(parent_value, child_value, parent_value, parent_flags, child_flags, parent_flags);
 }
 
+BOOST_AUTO_TEST_CASE(ccoins_async_flush)
+{
+    CCoinsViewDB db(1 << 20, true, false, true);
+    CCoinsViewCache cache(&db);
+
+    std::vector<COutPoint> outpoints;
+    for (int round = 0; round < 3; round++) {
+        for (int i = 0; i < 100; i++) {
+            COutPoint outpoint(GetRandHash(), 0);
+            Coin coin;
+            coin.out.nValue = 1000 + i;
+            coin.out.scriptPubKey.assign(1, OP_TRUE);
+            coin.nHeight = round;
+            cache.AddCoin(outpoint, std::move(coin), false);
+            outpoints.push_back(outpoint);
+        }
+        // spend one coin from the previous round, it must not come back after the flush
+        if (round > 0) {
+            BOOST_CHECK(cache.SpendCoin(outpoints[(round - 1) * 100]));
+        }
+        uint256 hashBlock = GetRandHash();
+        cache.SetBestBlock(hashBlock);
+        BOOST_CHECK(cache.Flush());
+
+        // the write might still be running, but the new state is visible right away
+        BOOST_CHECK(db.GetBestBlock() == hashBlock);
+        for (size_t i = 0; i < outpoints.size(); i++) {
+            bool fSpent = i % 100 == 0 && i / 100 < (size_t)round;
+            BOOST_CHECK_EQUAL(cache.HaveCoin(outpoints[i]), !fSpent);
+        }
+    }
+
+    BOOST_CHECK(db.FinishAsyncFlush());
+    for (size_t i = 0; i < outpoints.size(); i++) {
+        Coin coin;
+        bool fSpent = i % 100 == 0 && i / 100 < 2;
+        BOOST_CHECK_EQUAL(db.GetCoin(outpoints[i], coin), !fSpent);
+        if (!fSpent) {
+            BOOST_CHECK_EQUAL(coin.out.nValue, 1000 + (CAmount)(i % 100));
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(ccoins_async_flush_hook)
+{
+    CCoinsViewDB db(1 << 20, true, false, true);
+    CCoinsViewCache cache(&db);
+
+    std::atomic<int> nWrites(0);
+    bool fHookResult = true;
+    db.SetAfterWriteHook([&]() { nWrites++; return fHookResult; });
+
+    COutPoint outpoint(GetRandHash(), 0);
+    Coin coin;
+    coin.out.nValue = 1000;
+    coin.out.scriptPubKey.assign(1, OP_TRUE);
+    cache.AddCoin(outpoint, std::move(coin), false);
+    cache.SetBestBlock(GetRandHash());
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(db.FinishAsyncFlush());
+    BOOST_CHECK_EQUAL(nWrites.load(), 1);
+    BOOST_CHECK_EQUAL(db.PendingMemoryUsage(), 0U);
+
+    // a failing hook is reported like a failed write
+    fHookResult = false;
+    cache.SetBestBlock(GetRandHash());
+    BOOST_CHECK(cache.Flush());
+    BOOST_CHECK(!db.FinishAsyncFlush());
+    BOOST_CHECK_EQUAL(nWrites.load(), 2);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -3,6 +3,7 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "dbwrapper.h"
+#include "txdb.h"
 #include "uint256.h"
 #include "random.h"
 #include "test/test_polis.h"
@@ -319,5 +320,78 @@ BOOST_AUTO_TEST_CASE(iterator_string_ordering)
 }
 
 
+// Index entries written into the block tree database by older versions move to the index databases
+BOOST_AUTO_TEST_CASE(blocktree_index_migration)
+{
+    CBlockTreeDB blocktree(1 << 20, true);
+
+    uint256 txid = GetRandHash();
+    CDiskTxPos pos(CDiskBlockPos(1, 2), 3);
+    CSpentIndexKey spentKey(GetRandHash(), 1);
+    CSpentIndexValue spentValue(GetRandHash(), 2, 100, 5000, 1, uint160());
+    CTimestampIndexKey timestampKey(1000, GetRandHash());
+    uint256 hashBuilt = GetRandHash();
+
+    BOOST_CHECK(blocktree.Write(std::make_pair('t', txid), pos));
+    BOOST_CHECK(blocktree.Write(std::make_pair('p', spentKey), spentValue));
+    BOOST_CHECK(blocktree.Write(std::make_pair('s', timestampKey), 0));
+    BOOST_CHECK(blocktree.Write('I', std::make_pair(1, hashBuilt)));
+    BOOST_CHECK(blocktree.WriteFlag("txindex", true));
+
+    BOOST_CHECK(blocktree.MigrateIndexes());
+
+    CDiskTxPos posRead;
+    BOOST_CHECK(blocktree.ReadTxIndex(txid, posRead));
+    BOOST_CHECK(posRead.nFile == pos.nFile && posRead.nPos == pos.nPos && posRead.nTxOffset == pos.nTxOffset);
+    CSpentIndexValue spentRead;
+    BOOST_CHECK(blocktree.ReadSpentIndex(spentKey, spentRead));
+    BOOST_CHECK(spentRead.txid == spentValue.txid && spentRead.inputIndex == spentValue.inputIndex);
+    std::vector<uint256> hashes;
+    BOOST_CHECK(blocktree.ReadTimestampIndex(2000, 0, hashes));
+    BOOST_CHECK(hashes.size() == 1 && hashes[0] == timestampKey.blockHash);
+    int nIndexes = 0;
+    uint256 hashRead;
+    BOOST_CHECK(blocktree.ReadIndexBuildState(nIndexes, hashRead));
+    BOOST_CHECK(nIndexes == 1 && hashRead == hashBuilt);
+
+    // nothing is left behind in the block tree database, but its own data is untouched
+    BOOST_CHECK(!blocktree.Exists(std::make_pair('t', txid)));
+    BOOST_CHECK(!blocktree.Exists(std::make_pair('p', spentKey)));
+    BOOST_CHECK(!blocktree.Exists(std::make_pair('s', timestampKey)));
+    BOOST_CHECK(!blocktree.Exists('I'));
+    bool fTxIndex = false;
+    BOOST_CHECK(blocktree.ReadFlag("txindex", fTxIndex) && fTxIndex);
+
+    // running it again is a no-op
+    BOOST_CHECK(blocktree.MigrateIndexes());
+    BOOST_CHECK(blocktree.ReadTxIndex(txid, posRead));
+}
+
+BOOST_AUTO_TEST_CASE(address_balance_replay)
+{
+    CBlockTreeDB blocktree(1 << 20, true);
+    uint160 addressHash;
+    GetRandBytes(addressHash.begin(), addressHash.size());
+
+    std::vector<std::pair<CAddressIndexKey, CAmount> > vect;
+    vect.push_back(std::make_pair(CAddressIndexKey(1, addressHash, 10, 0, GetRandHash(), 0, false), 5000));
+    vect.push_back(std::make_pair(CAddressIndexKey(1, addressHash, 11, 0, GetRandHash(), 0, true), -2000));
+
+    CAddressBalanceValue value;
+    BOOST_CHECK(blocktree.WriteAddressIndex(vect));
+    BOOST_CHECK(blocktree.ReadAddressBalance(addressHash, 1, value));
+    BOOST_CHECK(value.balance == 3000 && value.received == 5000);
+
+    // blocks connected again after an unclean shutdown must not be counted twice
+    BOOST_CHECK(blocktree.WriteAddressIndex(vect));
+    BOOST_CHECK(blocktree.ReadAddressBalance(addressHash, 1, value));
+    BOOST_CHECK(value.balance == 3000 && value.received == 5000);
+
+    // same for disconnecting
+    BOOST_CHECK(blocktree.EraseAddressIndex(vect));
+    BOOST_CHECK(blocktree.EraseAddressIndex(vect));
+    BOOST_CHECK(blocktree.ReadAddressBalance(addressHash, 1, value));
+    BOOST_CHECK(value.IsNull());
+}
 
 BOOST_AUTO_TEST_SUITE_END()
@@ -333,6 +333,29 @@ BOOST_FIXTURE_TEST_CASE(dip3_protx, TestChainDIP3Setup)
     auto dmn = deterministicMNManager->GetListAtChainTip().GetMN(dmnHashes[0]);
     BOOST_ASSERT(dmn != nullptr && dmn->pdmnState->addr.GetPort() == 1000);
 
+    // test that signature checks can be deferred to the check queue and still fail there
+    {
+        CBLSSecretKey wrongOperatorKey;
+        wrongOperatorKey.MakeNewKey();
+        auto badTx = CreateProUpServTx(utxos, dmnHashes[0], wrongOperatorKey, 1001, CScript(), coinbaseKey);
+
+        CValidationState state;
+        BOOST_CHECK(!CheckSpecialTx(badTx, chainActive.Tip(), state));
+        BOOST_CHECK_EQUAL(state.GetRejectReason(), "bad-protx-sig");
+
+        std::vector<CSpecialTxCheck> vChecks;
+        CValidationState state2;
+        BOOST_CHECK(CheckSpecialTx(badTx, chainActive.Tip(), state2, &vChecks));
+        BOOST_CHECK_EQUAL(vChecks.size(), 1U);
+        BOOST_CHECK(!vChecks[0]());
+
+        auto goodTx = CreateProUpServTx(utxos, dmnHashes[0], operatorKeys[dmnHashes[0]], 1001, CScript(), coinbaseKey);
+        vChecks.clear();
+        BOOST_CHECK(CheckSpecialTx(goodTx, chainActive.Tip(), state2, &vChecks));
+        BOOST_CHECK_EQUAL(vChecks.size(), 1U);
+        BOOST_CHECK(vChecks[0]());
+    }
+
     // test ProUpRevTx
     tx = CreateProUpRevTx(utxos, dmnHashes[0], operatorKeys[dmnHashes[0]], coinbaseKey);
     CreateAndProcessBlock({tx}, coinbaseKey);
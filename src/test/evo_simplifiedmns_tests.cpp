@@ -3,10 +3,18 @@
 // file COPYING or http://www.opensource.org/licenses/mit-license.php.
 
 #include "test/test_polis.h"
+#include "test/test_random.h"
 
 #include "bls/bls.h"
+#include "consensus/merkle.h"
 #include "evo/simplifiedmns.h"
 #include "netbase.h"
+#include "random.h"
+#include "validation.h"
+
+#include <map>
+
+#include <univalue.h>
 
 #include <boost/test/unit_test.hpp>
 
@@ -69,5 +77,155 @@ BOOST_AUTO_TEST_CASE(simplifiedmns_merkleroots)
     //printf("merkleRoot=\"%s\",\n", calculatedMerkleRoot.c_str());
 
     BOOST_CHECK(expectedMerkleRoot == calculatedMerkleRoot);
+
+    std::vector<std::pair<uint256, uint256>> vLeaves;
+    for (const auto& smle : sml.mnList) {
+        vLeaves.emplace_back(smle.proRegTxHash, smle.CalcHash());
+    }
+    CSimplifiedMNListMerkleTree tree;
+    tree.Build(vLeaves);
+    BOOST_CHECK(expectedMerkleRoot == tree.CalcRoot().ToString());
 }
+
+BOOST_AUTO_TEST_CASE(simplifiedmns_merkletree)
+{
+    seed_insecure_rand(true);
+
+    for (int i = 0; i < 50; i++) {
+        std::map<uint256, uint256> mapLeaves;
+        CSimplifiedMNListMerkleTree tree;
+
+        size_t nInitial = insecure_rand() % 40;
+        for (size_t j = 0; j < nInitial; j++) {
+            mapLeaves.emplace(GetRandHash(), GetRandHash());
+        }
+        tree.Build(std::vector<std::pair<uint256, uint256>>(mapLeaves.begin(), mapLeaves.end()));
+
+        for (int step = 0; step < 30; step++) {
+            // apply a few changes at once, like a block does
+            int nChanges = 1 + insecure_rand() % 4;
+            for (int c = 0; c < nChanges; c++) {
+                uint32_t nOp = insecure_rand() % 4;
+                if (nOp == 0 || mapLeaves.empty()) {
+                    uint256 key = GetRandHash();
+                    mapLeaves[key] = GetRandHash();
+                    tree.Update(key, mapLeaves[key]);
+                    continue;
+                }
+                auto it = std::next(mapLeaves.begin(), insecure_rand() % mapLeaves.size());
+                if (nOp == 1) {
+                    tree.Remove(it->first);
+                    mapLeaves.erase(it);
+                } else if (nOp == 2) {
+                    it->second = GetRandHash();
+                    tree.Update(it->first, it->second);
+                } else if (std::next(it) != mapLeaves.end()) {
+                    // duplicate a leaf hash, which must be reported as mutation if both are siblings
+                    std::next(it)->second = it->second;
+                    tree.Update(std::next(it)->first, it->second);
+                }
+            }
+
+            std::vector<uint256> leaves;
+            for (const auto& p : mapLeaves) {
+                leaves.emplace_back(p.second);
+            }
+            bool fMutated1, fMutated2;
+            uint256 root1 = ComputeMerkleRoot(leaves, &fMutated1);
+            uint256 root2 = tree.CalcRoot(&fMutated2);
+            BOOST_CHECK(root1 == root2);
+            BOOST_CHECK_EQUAL(fMutated1, fMutated2);
+            BOOST_CHECK_EQUAL(tree.size(), mapLeaves.size());
+        }
+    }
+}
+
+struct MNListDiffCacheSetup : public TestChainSetup
+{
+    MNListDiffCacheSetup() : TestChainSetup(10) {}
+};
+
+static uint64_t GetCacheStat(const CSimplifiedMNListDiffCache& cache, const std::string& strKey)
+{
+    UniValue obj;
+    cache.ToJson(obj);
+    return find_value(obj, strKey).get_int64();
+}
+
+BOOST_FIXTURE_TEST_CASE(simplifiedmns_diffcache, MNListDiffCacheSetup)
+{
+    CSimplifiedMNListDiffCache cache;
+    CSimplifiedMNListDiffCache::Payload payload, payload2;
+    std::string strError;
+
+    LOCK(cs_main);
+    const uint256 tipHash = chainActive.Tip()->GetBlockHash();
+
+    // the second request for the same pair is served from the cache, with the same data
+    BOOST_CHECK(cache.GetDiff(chainActive[1]->GetBlockHash(), tipHash, payload, strError));
+    BOOST_CHECK(cache.GetDiff(chainActive[1]->GetBlockHash(), tipHash, payload2, strError));
+    BOOST_CHECK(payload == payload2);
+    BOOST_CHECK_EQUAL(GetCacheStat(cache, "misses"), 1);
+    BOOST_CHECK_EQUAL(GetCacheStat(cache, "hits"), 1);
+    BOOST_CHECK_EQUAL(GetCacheStat(cache, "entries"), 1);
+
+    CSimplifiedMNListDiff mnListDiff;
+    BOOST_CHECK(BuildSimplifiedMNListDiff(chainActive[1]->GetBlockHash(), tipHash, mnListDiff, strError));
+    CDataStream ss(SER_NETWORK, PROTOCOL_VERSION);
+    ss << mnListDiff;
+    BOOST_CHECK(std::vector<unsigned char>(ss.begin(), ss.end()) == *payload);
+
+    // unknown blocks fail and are not cached
+    BOOST_CHECK(!cache.GetDiff(GetRandHash(), tipHash, payload2, strError));
+    BOOST_CHECK_EQUAL(GetCacheStat(cache, "entries"), 1);
+
+    // all diffs to the tip have the same size, room for two and a half of them evicts the least recently used ones
+    cache.SetMaxSize(payload->size() * 5 / 2);
+    for (int i = 2; i < 6; i++) {
+        BOOST_CHECK(cache.GetDiff(chainActive[i]->GetBlockHash(), tipHash, payload2, strError));
+    }
+    BOOST_CHECK_EQUAL(GetCacheStat(cache, "entries"), 2);
+    BOOST_CHECK_EQUAL(GetCacheStat(cache, "evicted"), 3);
+    BOOST_CHECK(cache.GetDiff(chainActive[5]->GetBlockHash(), tipHash, payload2, strError));
+    BOOST_CHECK_EQUAL(GetCacheStat(cache, "hits"), 2);
+    BOOST_CHECK(cache.GetDiff(chainActive[1]->GetBlockHash(), tipHash, payload2, strError));
+    BOOST_CHECK_EQUAL(GetCacheStat(cache, "misses"), 7);
+
+    // shrinking the cache counts as eviction as well
+    cache.SetMaxSize(0);
+    BOOST_CHECK_EQUAL(GetCacheStat(cache, "entries"), 0);
+    BOOST_CHECK_EQUAL(GetCacheStat(cache, "evicted"), 6);
+}
+
+BOOST_FIXTURE_TEST_CASE(simplifiedmns_diffcache_precompute, MNListDiffCacheSetup)
+{
+    CSimplifiedMNListDiffCache cache;
+    CSimplifiedMNListDiffCache::Payload payload;
+    std::string strError;
+    uint256 baseBlockHash;
+
+    {
+        LOCK(cs_main);
+        cache.UpdatedBlockTip(chainActive.Tip(), chainActive.Tip()->pprev, false);
+        baseBlockHash = chainActive[1]->GetBlockHash();
+        BOOST_CHECK(cache.GetDiff(baseBlockHash, chainActive.Tip()->GetBlockHash(), payload, strError));
+    }
+
+    CreateAndProcessBlock({}, coinbaseKey);
+
+    LOCK(cs_main);
+    // the diff to the new tip is only built by PrecomputeDiffs, not in the validation callback
+    cache.UpdatedBlockTip(chainActive.Tip(), chainActive.Tip()->pprev, false);
+    BOOST_CHECK_EQUAL(GetCacheStat(cache, "precomputed"), 0);
+    cache.PrecomputeDiffs();
+    BOOST_CHECK_EQUAL(GetCacheStat(cache, "precomputed"), 1);
+
+    BOOST_CHECK(cache.GetDiff(baseBlockHash, chainActive.Tip()->GetBlockHash(), payload, strError));
+    BOOST_CHECK_EQUAL(GetCacheStat(cache, "hits"), 1);
+
+    // nothing left to do
+    cache.PrecomputeDiffs();
+    BOOST_CHECK_EQUAL(GetCacheStat(cache, "precomputed"), 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -0,0 +1,102 @@
+// Copyright (c) 2018 The Polis Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "test/test_polis.h"
+
+#include "bls/bls.h"
+#include "evo/deterministicmns.h"
+#include "llmq/quorums_dummydkg.h"
+#include "random.h"
+
+#include <boost/test/unit_test.hpp>
+
+BOOST_FIXTURE_TEST_SUITE(llmq_dummydkg_tests, TestingSetup)
+
+static CDeterministicMNCPtr MakeMember(const CBLSSecretKey& operatorKey)
+{
+    auto state = std::make_shared<CDeterministicMNState>();
+    state->pubKeyOperator = operatorKey.GetPublicKey();
+
+    auto dmn = std::make_shared<CDeterministicMN>();
+    dmn->proTxHash = GetRandHash();
+    dmn->pdmnState = state;
+    return dmn;
+}
+
+static llmq::CDummyContribution MakeContribution(const uint256& quorumHash, uint16_t signer, const CBLSSecretKey& sk)
+{
+    llmq::CDummyContribution qc;
+    qc.llmqType = Consensus::LLMQ_50_60;
+    qc.quorumHash = quorumHash;
+    qc.signer = signer;
+    qc.sig = sk.Sign(qc.GetSignHash());
+    return qc;
+}
+
+static llmq::CDummyCommitment MakeCommitment(const uint256& quorumHash, uint16_t signer, const uint256& commitmentHash,
+                                             const CBLSSecretKey& sk, const CBLSSecretKey& shareSk)
+{
+    llmq::CDummyCommitment qc;
+    qc.llmqType = Consensus::LLMQ_50_60;
+    qc.quorumHash = quorumHash;
+    qc.signer = signer;
+    qc.validMembers.resize(50, true);
+    qc.membersSig = sk.Sign(commitmentHash);
+    qc.quorumSig = shareSk.Sign(commitmentHash);
+    return qc;
+}
+
+BOOST_AUTO_TEST_CASE(dummydkg_invalid_contribution_does_not_shadow_valid_one)
+{
+    llmq::CDummyDKG dkg;
+
+    CBLSSecretKey operatorKey, forgerKey;
+    operatorKey.MakeNewKey();
+    forgerKey.MakeNewKey();
+    auto member = MakeMember(operatorKey);
+    uint256 quorumHash = GetRandHash();
+
+    // a forged contribution claiming the same signer is queued before the honest one
+    auto forged = MakeContribution(quorumHash, 1, forgerKey);
+    auto honest = MakeContribution(quorumHash, 1, operatorKey);
+    dkg.ProcessPreVerifiedContributions({std::make_pair((NodeId)-1, forged), std::make_pair((NodeId)-1, honest)}, {member, member});
+
+    BOOST_CHECK(!dkg.HasDummyContribution(::SerializeHash(forged)));
+    BOOST_CHECK(dkg.HasDummyContribution(::SerializeHash(honest)));
+
+    // only the first valid contribution of a member is accepted
+    auto second = MakeContribution(quorumHash, 2, operatorKey);
+    dkg.ProcessPreVerifiedContributions({std::make_pair((NodeId)-1, second)}, {member});
+    BOOST_CHECK(!dkg.HasDummyContribution(::SerializeHash(second)));
+}
+
+BOOST_AUTO_TEST_CASE(dummydkg_invalid_commitment_does_not_shadow_valid_one)
+{
+    llmq::CDummyDKG dkg;
+
+    CBLSSecretKey operatorKey, shareKey, forgerKey;
+    operatorKey.MakeNewKey();
+    shareKey.MakeNewKey();
+    forgerKey.MakeNewKey();
+    auto member = MakeMember(operatorKey);
+    uint256 quorumHash = GetRandHash();
+    uint256 commitmentHash = GetRandHash();
+
+    auto forged = MakeCommitment(quorumHash, 1, commitmentHash, forgerKey, shareKey);
+    auto honest = MakeCommitment(quorumHash, 1, commitmentHash, operatorKey, shareKey);
+    dkg.ProcessPreVerifiedCommitments({std::make_pair((NodeId)-1, forged), std::make_pair((NodeId)-1, honest)}, {member, member},
+                                      {commitmentHash, commitmentHash}, {shareKey.GetPublicKey(), shareKey.GetPublicKey()});
+
+    BOOST_CHECK(!dkg.HasDummyCommitment(::SerializeHash(forged)));
+    BOOST_CHECK(dkg.HasDummyCommitment(::SerializeHash(honest)));
+
+    // only the first valid commitment of a member is accepted, even if it signs another commitment hash
+    uint256 otherCommitmentHash = GetRandHash();
+    auto second = MakeCommitment(quorumHash, 1, otherCommitmentHash, operatorKey, shareKey);
+    dkg.ProcessPreVerifiedCommitments({std::make_pair((NodeId)-1, second)}, {member},
+                                      {otherCommitmentHash}, {shareKey.GetPublicKey()});
+    BOOST_CHECK(!dkg.HasDummyCommitment(::SerializeHash(second)));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
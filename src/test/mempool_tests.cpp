@@ -583,4 +583,68 @@ BOOST_AUTO_TEST_CASE(MempoolSizeLimitTest)
     SetMockTime(0);
 }
 
+BOOST_AUTO_TEST_CASE(MempoolAddressSpentIndexTest)
+{
+    CCoinsView coinsDummy;
+    CCoinsViewCache coins(&coinsDummy);
+    TestMemPoolEntryHelper entry;
+
+    uint160 hashA, hashB;
+    hashA.SetHex("0102030405060708090a0b0c0d0e0f1011121314");
+    hashB.SetHex("1112131415161718191a1b1c1d1e1f2021222324");
+    CScript scriptA = CScript() << OP_DUP << OP_HASH160 << ToByteVector(hashA) << OP_EQUALVERIFY << OP_CHECKSIG;
+    CScript scriptB = CScript() << OP_HASH160 << ToByteVector(hashB) << OP_EQUAL;
+
+    CMutableTransaction txPrev;
+    txPrev.vin.resize(1);
+    txPrev.vin[0].scriptSig = CScript() << OP_1;
+    txPrev.vout.resize(1);
+    txPrev.vout[0].scriptPubKey = scriptA;
+    txPrev.vout[0].nValue = 10 * COIN;
+    AddCoins(coins, txPrev, 1);
+
+    CMutableTransaction tx;
+    tx.vin.resize(1);
+    tx.vin[0].prevout = COutPoint(txPrev.GetHash(), 0);
+    tx.vout.resize(2);
+    tx.vout[0].scriptPubKey = scriptB;
+    tx.vout[0].nValue = 4 * COIN;
+    tx.vout[1].scriptPubKey = scriptA;
+    tx.vout[1].nValue = 6 * COIN;
+
+    CTxMemPool pool(CFeeRate(0));
+    CTxMemPoolEntry txEntry = entry.FromTx(tx);
+    {
+        LOCK(pool.cs);
+        pool.addUnchecked(tx.GetHash(), txEntry);
+        pool.addAddressIndex(txEntry, coins);
+        pool.addSpentIndex(txEntry, coins);
+    }
+
+    std::vector<std::pair<uint160, int> > addresses{{hashA, 1}, {hashB, 2}};
+    std::vector<std::pair<CMempoolAddressDeltaKey, CMempoolAddressDelta> > results;
+    BOOST_CHECK(pool.getAddressIndex(addresses, results));
+    BOOST_CHECK_EQUAL(results.size(), 3U);
+    // deltas of hashA in index order (spending input 0 before output 1), then hashB
+    BOOST_CHECK(results[0].first.addressBytes == hashA && results[0].first.index == 0 && results[0].first.spending == 1);
+    BOOST_CHECK_EQUAL(results[0].second.amount, -10 * COIN);
+    BOOST_CHECK(results[1].first.addressBytes == hashA && results[1].first.index == 1 && results[1].first.spending == 0);
+    BOOST_CHECK_EQUAL(results[1].second.amount, 6 * COIN);
+    BOOST_CHECK(results[2].first.addressBytes == hashB && results[2].first.type == 2);
+    BOOST_CHECK_EQUAL(results[2].second.amount, 4 * COIN);
+
+    CSpentIndexKey spentKey(txPrev.GetHash(), 0);
+    CSpentIndexValue spentValue;
+    BOOST_CHECK(pool.getSpentIndex(spentKey, spentValue));
+    BOOST_CHECK(spentValue.txid == tx.GetHash());
+    BOOST_CHECK(spentValue.addressHash == hashA);
+    BOOST_CHECK_EQUAL(spentValue.satoshis, 10 * COIN);
+
+    pool.removeRecursive(tx);
+    results.clear();
+    BOOST_CHECK(pool.getAddressIndex(addresses, results));
+    BOOST_CHECK(results.empty());
+    BOOST_CHECK(!pool.getSpentIndex(spentKey, spentValue));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
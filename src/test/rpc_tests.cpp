@@ -352,4 +352,34 @@ BOOST_AUTO_TEST_CASE(rpc_sentinel_ping)
     BOOST_CHECK_THROW(CallRPC("sentinelping 2"), std::bad_cast);
 }
 
+BOOST_AUTO_TEST_CASE(rpc_work_classes)
+{
+    HTTPWorkClass workClass;
+    BOOST_CHECK(ParseHTTPWorkClass("heavy", workClass) && workClass == HTTP_WORK_HEAVY);
+    BOOST_CHECK(!ParseHTTPWorkClass("expensive", workClass));
+    BOOST_CHECK_EQUAL(HTTPWorkClassName(HTTP_WORK_CHEAP), "cheap");
+
+    std::string strError;
+    BOOST_CHECK(InitRPCWorkClasses(strError));
+    BOOST_CHECK_EQUAL(GetRPCWorkClass("getblockcount"), HTTP_WORK_CHEAP);
+    BOOST_CHECK_EQUAL(GetRPCWorkClass("getblock"), HTTP_WORK_NORMAL);
+    BOOST_CHECK_EQUAL(GetRPCWorkClass("getaddressdeltas"), HTTP_WORK_HEAVY);
+    BOOST_CHECK_EQUAL(GetRPCWorkClass("nosuchmethod"), HTTP_WORK_NORMAL);
+
+    // Calls are counted by getrpcmetrics, failed ones as errors
+    SetRPCWarmupFinished();
+    JSONRPCRequest request;
+    request.strMethod = "getblockcount";
+    request.params = UniValue(UniValue::VARR);
+    BOOST_CHECK_NO_THROW(tableRPC.execute(request));
+    request.strMethod = "getblockhash";
+    request.params.push_back(-1);
+    BOOST_CHECK_THROW(tableRPC.execute(request), UniValue);
+    UniValue metrics = CallRPC("getrpcmetrics");
+    const UniValue& methods = find_value(metrics.get_obj(), "methods");
+    BOOST_CHECK_EQUAL(find_value(methods["getblockcount"], "class").get_str(), "cheap");
+    BOOST_CHECK(find_value(methods["getblockcount"], "calls").get_int64() >= 1);
+    BOOST_CHECK(find_value(methods["getblockhash"], "errors").get_int64() >= 1);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
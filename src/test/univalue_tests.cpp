@@ -7,6 +7,7 @@
 #include <vector>
 #include <string>
 #include <map>
+#include <limits>
 #include <univalue.h>
 #include "test/test_polis.h"
 
@@ -339,4 +340,41 @@ BOOST_AUTO_TEST_CASE(univalue_readwrite)
     BOOST_CHECK(!v.read("{} 42"));
 }
 
+BOOST_AUTO_TEST_CASE(univalue_move_write)
+{
+    UniValue inner(UniValue::VOBJ);
+    inner.reserve(3);
+    BOOST_CHECK(inner.pushKV("str", "a\"b\\c\n"));
+    BOOST_CHECK(inner.pushKV("num", (int64_t)-42));
+    BOOST_CHECK(inner.pushKV("unum", std::numeric_limits<uint64_t>::max()));
+
+    UniValue obj(UniValue::VOBJ);
+    BOOST_CHECK(obj.push_back(Pair("inner", std::move(inner))));
+    BOOST_CHECK(obj.pushKV("arr", UniValue(UniValue::VARR)));
+    BOOST_CHECK(!obj.push_back(UniValue(1)));
+    BOOST_CHECK_EQUAL(obj.size(), 2);
+    BOOST_CHECK_EQUAL(obj["inner"].size(), 3);
+    BOOST_CHECK_EQUAL(obj["inner"]["num"].get_int64(), -42);
+    BOOST_CHECK_EQUAL(obj["inner"]["unum"].getValStr(), "18446744073709551615");
+
+    UniValue arr(UniValue::VARR);
+    BOOST_CHECK(arr.push_back(UniValue()));
+    BOOST_CHECK(arr.push_back(UniValue(std::string("x"))));
+    BOOST_CHECK(arr.push_back(UniValue(true)));
+    BOOST_CHECK_EQUAL(arr.size(), 3);
+    BOOST_CHECK(obj.pushKV("arr2", std::move(arr)));
+
+    const std::string strJson = "{\"inner\":{\"str\":\"a\\\"b\\\\c\\n\",\"num\":-42,\"unum\":18446744073709551615},"
+                                "\"arr\":[],\"arr2\":[null,\"x\",true]}";
+    BOOST_CHECK_EQUAL(obj.write(), strJson);
+
+    // the appending writer produces the same output behind existing content
+    std::string s = "prefix";
+    obj.write(s);
+    BOOST_CHECK_EQUAL(s, "prefix" + strJson);
+    s.clear();
+    obj.write(s, 4);
+    BOOST_CHECK_EQUAL(s, obj.write(4));
+}
+
 BOOST_AUTO_TEST_SUITE_END()
@@ -11,6 +11,8 @@
 #include "uint256.h"
 #include "ui_interface.h"
 #include "init.h"
+#include "util.h"
+#include "utiltime.h"
 
 #include <stdint.h>
 
@@ -24,11 +26,13 @@ static const char DB_ADDRESSINDEX = 'a';
 static const char DB_ADDRESSUNSPENTINDEX = 'u';
 static const char DB_TIMESTAMPINDEX = 's';
 static const char DB_SPENTINDEX = 'p';
+static const char DB_ADDRESSBALANCEINDEX = 'v';
 static const char DB_BLOCK_INDEX = 'b';
 
 static const char DB_BEST_BLOCK = 'B';
 static const char DB_FLAG = 'F';
 static const char DB_REINDEX_FLAG = 'R';
+static const char DB_INDEXBUILD = 'I';
 static const char DB_LAST_BLOCK = 'l';
 
 namespace {
@@ -55,30 +59,63 @@ struct CoinEntry {
 
 }
 
-CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe) : db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, true) 
+CCoinsViewDB::CCoinsViewDB(size_t nCacheSize, bool fMemory, bool fWipe, bool fAsyncFlushIn) :
+    db(GetDataDir() / "chainstate", nCacheSize, fMemory, fWipe, true),
+    fAsyncFlush(fAsyncFlushIn),
+    pendingCoinsMemoryResource(new CCoinsMapMemoryResource()),
+    pendingCoins(0, SaltedOutpointHasher(), CCoinsMap::key_equal(), pendingCoinsMemoryResource.get()),
+    nPendingCoinsUsage(0),
+    fFlushDone(false),
+    fFlushFailed(false)
 {
 }
 
+CCoinsViewDB::~CCoinsViewDB()
+{
+    FinishAsyncFlush(true);
+}
+
 bool CCoinsViewDB::GetCoin(const COutPoint &outpoint, Coin &coin) const {
+    {
+        LOCK(cs_pending);
+        CCoinsMap::const_iterator it = pendingCoins.find(outpoint);
+        if (it != pendingCoins.end()) {
+            if (it->second.coin.IsSpent())
+                return false;
+            coin = it->second.coin;
+            return true;
+        }
+    }
     return db.Read(CoinEntry(&outpoint), coin);
 }
 
 bool CCoinsViewDB::HaveCoin(const COutPoint &outpoint) const {
+    {
+        LOCK(cs_pending);
+        CCoinsMap::const_iterator it = pendingCoins.find(outpoint);
+        if (it != pendingCoins.end())
+            return !it->second.coin.IsSpent();
+    }
     return db.Exists(CoinEntry(&outpoint));
 }
 
 uint256 CCoinsViewDB::GetBestBlock() const {
+    {
+        LOCK(cs_pending);
+        if (!hashPendingBlock.IsNull())
+            return hashPendingBlock;
+    }
     uint256 hashBestChain;
     if (!db.Read(DB_BEST_BLOCK, hashBestChain))
         return uint256();
     return hashBestChain;
 }
 
-bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
+bool CCoinsViewDB::WriteCoins(const CCoinsMap &mapCoins, const uint256 &hashBlock) {
     CDBBatch batch(db);
     size_t count = 0;
     size_t changed = 0;
-    for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end();) {
+    for (CCoinsMap::const_iterator it = mapCoins.begin(); it != mapCoins.end(); it++) {
         if (it->second.flags & CCoinsCacheEntry::DIRTY) {
             CoinEntry entry(&it->first);
             if (it->second.coin.IsSpent())
@@ -88,23 +125,112 @@ bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
             changed++;
         }
         count++;
-        CCoinsMap::iterator itOld = it++;
-        mapCoins.erase(itOld);
     }
     if (!hashBlock.IsNull())
         batch.Write(DB_BEST_BLOCK, hashBlock);
 
     bool ret = db.WriteBatch(batch);
     LogPrint("coindb", "Committed %u changed transaction outputs (out of %u) to coin database...\n", (unsigned int)changed, (unsigned int)count);
+    if (ret && afterWriteHook)
+        ret = afterWriteHook();
     return ret;
 }
 
+bool CCoinsViewDB::BatchWrite(CCoinsMap &mapCoins, const uint256 &hashBlock) {
+    if (!fAsyncFlush) {
+        bool ret = WriteCoins(mapCoins, hashBlock);
+        mapCoins.clear();
+        return ret;
+    }
+
+    LOCK(cs_pending);
+    if (!FinishFlush(true))
+        return false;
+
+    // Only the dirty entries need to be written, the rest can be dropped right away
+    for (CCoinsMap::iterator it = mapCoins.begin(); it != mapCoins.end(); it++) {
+        if (it->second.flags & CCoinsCacheEntry::DIRTY) {
+            nPendingCoinsUsage += it->second.coin.DynamicMemoryUsage();
+            pendingCoins.emplace(it->first, std::move(it->second));
+        }
+    }
+    mapCoins.clear();
+    hashPendingBlock = hashBlock;
+
+    fFlushDone = false;
+    fFlushFailed = false;
+    flushThread = std::thread(&CCoinsViewDB::ThreadFlush, this);
+    return true;
+}
+
+void CCoinsViewDB::ThreadFlush()
+{
+    RenameThread("polis-coinsflush");
+    int64_t nStart = GetTimeMicros();
+    try {
+        if (!WriteCoins(pendingCoins, hashPendingBlock))
+            fFlushFailed = true;
+    } catch (const std::exception& e) {
+        LogPrintf("%s: %s\n", __func__, e.what());
+        fFlushFailed = true;
+    }
+    LogPrint("coindb", "Background flush of %u coins finished in %.2fms\n", (unsigned int)pendingCoins.size(), 0.001 * (GetTimeMicros() - nStart));
+    fFlushDone = true;
+}
+
+bool CCoinsViewDB::FinishFlush(bool fWait)
+{
+    AssertLockHeld(cs_pending);
+    if (!flushThread.joinable())
+        return true;
+    if (!fWait && !fFlushDone)
+        return true;
+
+    flushThread.join();
+
+    // Same as CCoinsViewCache::ReallocateCache(), release the pool chunks in one go
+    pendingCoins.~CCoinsMap();
+    pendingCoinsMemoryResource.reset(new CCoinsMapMemoryResource());
+    ::new (&pendingCoins) CCoinsMap(0, SaltedOutpointHasher(), CCoinsMap::key_equal(), pendingCoinsMemoryResource.get());
+    hashPendingBlock.SetNull();
+    nPendingCoinsUsage = 0;
+
+    if (fFlushFailed) {
+        LogPrintf("%s: background write to the coin database failed\n", __func__);
+        return false;
+    }
+    return true;
+}
+
+bool CCoinsViewDB::FinishAsyncFlush(bool fWait)
+{
+    LOCK(cs_pending);
+    return FinishFlush(fWait);
+}
+
+size_t CCoinsViewDB::PendingMemoryUsage() const
+{
+    LOCK(cs_pending);
+    return memusage::DynamicUsage(pendingCoins) + nPendingCoinsUsage;
+}
+
 size_t CCoinsViewDB::EstimateSize() const
 {
     return db.EstimateSize(DB_COIN, (char)(DB_COIN+1));
 }
 
-CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe) : CDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe) {
+static CDBWrapper* OpenIndexDB(const std::string &strName, size_t nCacheSize, bool fMemory, bool fWipe) {
+    // Index records are mostly appended and rarely read back in bulk, so trade some CPU for disk space
+    // and let leveldb buffer at least its default amount of writes
+    return new CDBWrapper(GetDataDir() / "indexes" / strName, nCacheSize, fMemory, fWipe, false, true, std::max(nCacheSize / 4, (size_t)4 << 20));
+}
+
+CBlockTreeDB::CBlockTreeDB(size_t nCacheSize, bool fMemory, bool fWipe, const CIndexDBCacheSizes &indexCacheSizes) :
+    CDBWrapper(GetDataDir() / "blocks" / "index", nCacheSize, fMemory, fWipe),
+    txIndexDB(OpenIndexDB("txindex", indexCacheSizes.nTxIndex, fMemory, fWipe)),
+    addressIndexDB(OpenIndexDB("addressindex", indexCacheSizes.nAddressIndex, fMemory, fWipe)),
+    spentIndexDB(OpenIndexDB("spentindex", indexCacheSizes.nSpentIndex, fMemory, fWipe)),
+    timestampIndexDB(OpenIndexDB("timestampindex", indexCacheSizes.nTimestampIndex, fMemory, fWipe)) {
 }
 
 bool CBlockTreeDB::ReadBlockFileInfo(int nFile, CBlockFileInfo &info) {
@@ -129,6 +255,9 @@ bool CBlockTreeDB::ReadLastBlockFile(int &nFile) {
 
 CCoinsViewCursor *CCoinsViewDB::Cursor() const
 {
+    // The cursor iterates the database itself, so any background write has to be finished first
+    const_cast<CCoinsViewDB*>(this)->FinishAsyncFlush(true);
+
     CCoinsViewDBCursor *i = new CCoinsViewDBCursor(const_cast<CDBWrapper*>(&db)->NewIterator(), GetBestBlock());
     /* It seems that there are no "const iterators" for LevelDB.  Since we
        only need read operations on it, use a const-cast to get around
@@ -194,22 +323,22 @@ bool CBlockTreeDB::WriteBatchSync(const std::vector<std::pair<int, const CBlockF
 }
 
 bool CBlockTreeDB::ReadTxIndex(const uint256 &txid, CDiskTxPos &pos) {
-    return Read(std::make_pair(DB_TXINDEX, txid), pos);
+    return txIndexDB->Read(std::make_pair(DB_TXINDEX, txid), pos);
 }
 
 bool CBlockTreeDB::WriteTxIndex(const std::vector<std::pair<uint256, CDiskTxPos> >&vect) {
-    CDBBatch batch(*this);
+    CDBBatch batch(*txIndexDB);
     for (std::vector<std::pair<uint256,CDiskTxPos> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Write(std::make_pair(DB_TXINDEX, it->first), it->second);
-    return WriteBatch(batch);
+    return txIndexDB->WriteBatch(batch);
 }
 
 bool CBlockTreeDB::ReadSpentIndex(CSpentIndexKey &key, CSpentIndexValue &value) {
-    return Read(std::make_pair(DB_SPENTINDEX, key), value);
+    return spentIndexDB->Read(std::make_pair(DB_SPENTINDEX, key), value);
 }
 
 bool CBlockTreeDB::UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> >&vect) {
-    CDBBatch batch(*this);
+    CDBBatch batch(*spentIndexDB);
     for (std::vector<std::pair<CSpentIndexKey,CSpentIndexValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
         if (it->second.IsNull()) {
             batch.Erase(std::make_pair(DB_SPENTINDEX, it->first));
@@ -217,11 +346,11 @@ bool CBlockTreeDB::UpdateSpentIndex(const std::vector<std::pair<CSpentIndexKey,
             batch.Write(std::make_pair(DB_SPENTINDEX, it->first), it->second);
         }
     }
-    return WriteBatch(batch);
+    return spentIndexDB->WriteBatch(batch);
 }
 
 bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect) {
-    CDBBatch batch(*this);
+    CDBBatch batch(*addressIndexDB);
     for (std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
         if (it->second.IsNull()) {
             batch.Erase(std::make_pair(DB_ADDRESSUNSPENTINDEX, it->first));
@@ -229,13 +358,21 @@ bool CBlockTreeDB::UpdateAddressUnspentIndex(const std::vector<std::pair<CAddres
             batch.Write(std::make_pair(DB_ADDRESSUNSPENTINDEX, it->first), it->second);
         }
     }
-    return WriteBatch(batch);
+    return addressIndexDB->WriteBatch(batch);
 }
 
 bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
                                            std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs) {
+    return ForEachAddressUnspent(addressHash, type, [&](const CAddressUnspentKey& key, const CAddressUnspentValue& value) {
+        unspentOutputs.push_back(std::make_pair(key, value));
+        return true;
+    });
+}
 
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+bool CBlockTreeDB::ForEachAddressUnspent(uint160 addressHash, int type,
+                                         const std::function<bool(const CAddressUnspentKey&, const CAddressUnspentValue&)>& fn) {
+
+    std::unique_ptr<CDBIterator> pcursor(addressIndexDB->NewIterator());
 
     pcursor->Seek(std::make_pair(DB_ADDRESSUNSPENTINDEX, CAddressIndexIteratorKey(type, addressHash)));
 
@@ -245,7 +382,8 @@ bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
         if (pcursor->GetKey(key) && key.first == DB_ADDRESSUNSPENTINDEX && key.second.hashBytes == addressHash) {
             CAddressUnspentValue nValue;
             if (pcursor->GetValue(nValue)) {
-                unspentOutputs.push_back(std::make_pair(key.second, nValue));
+                if (!fn(key.second, nValue))
+                    break;
                 pcursor->Next();
             } else {
                 return error("failed to get address unspent value");
@@ -258,27 +396,120 @@ bool CBlockTreeDB::ReadAddressUnspentIndex(uint160 addressHash, int type,
     return true;
 }
 
+void CBlockTreeDB::UpdateAddressBalances(CDBBatch &batch, const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect, bool fUndo) {
+    // Sum up the changes per address first, so every balance record is read and written once per block
+    std::map<std::pair<unsigned int, uint160>, CAddressBalanceValue> mapDeltas;
+    for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++) {
+        // Only count entries which are really added or removed by this batch. Blocks connected again
+        // after an unclean shutdown find their entries already on disk and must not count them twice.
+        if (addressIndexDB->Exists(std::make_pair(DB_ADDRESSINDEX, it->first)) != fUndo)
+            continue;
+        CAddressBalanceValue& delta = mapDeltas[std::make_pair(it->first.type, it->first.hashBytes)];
+        CAmount nValue = fUndo ? -it->second : it->second;
+        delta.balance += nValue;
+        if (it->second > 0)
+            delta.received += nValue;
+    }
+
+    for (const auto& p : mapDeltas) {
+        auto key = std::make_pair(DB_ADDRESSBALANCEINDEX, CAddressIndexIteratorKey(p.first.first, p.first.second));
+        CAddressBalanceValue value;
+        addressIndexDB->Read(key, value);
+        value.balance += p.second.balance;
+        value.received += p.second.received;
+        if (value.IsNull())
+            batch.Erase(key);
+        else
+            batch.Write(key, value);
+    }
+}
+
 bool CBlockTreeDB::WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
-    CDBBatch batch(*this);
+    CDBBatch batch(*addressIndexDB);
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Write(std::make_pair(DB_ADDRESSINDEX, it->first), it->second);
-    return WriteBatch(batch);
+    UpdateAddressBalances(batch, vect, false);
+    return addressIndexDB->WriteBatch(batch);
 }
 
 bool CBlockTreeDB::EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount > >&vect) {
-    CDBBatch batch(*this);
+    CDBBatch batch(*addressIndexDB);
     for (std::vector<std::pair<CAddressIndexKey, CAmount> >::const_iterator it=vect.begin(); it!=vect.end(); it++)
         batch.Erase(std::make_pair(DB_ADDRESSINDEX, it->first));
-    return WriteBatch(batch);
+    UpdateAddressBalances(batch, vect, true);
+    return addressIndexDB->WriteBatch(batch);
+}
+
+bool CBlockTreeDB::ReadAddressBalance(uint160 addressHash, int type, CAddressBalanceValue &value) {
+    value.SetNull();
+    // Addresses without any activity have no record
+    addressIndexDB->Read(std::make_pair(DB_ADDRESSBALANCEINDEX, CAddressIndexIteratorKey(type, addressHash)), value);
+    return true;
+}
+
+bool CBlockTreeDB::BuildAddressBalanceIndex() {
+    std::unique_ptr<CDBIterator> pcursor(addressIndexDB->NewIterator());
+    pcursor->Seek(DB_ADDRESSINDEX);
+
+    CDBBatch batch(*addressIndexDB);
+    CAddressIndexIteratorKey current;
+    CAddressBalanceValue value;
+    size_t nAddresses = 0;
+
+    // Entries of the same address are adjacent in the index, so keep only one running sum
+    auto fnWriteCurrent = [&]() {
+        if (current.hashBytes.IsNull() || value.IsNull())
+            return;
+        batch.Write(std::make_pair(DB_ADDRESSBALANCEINDEX, current), value);
+        nAddresses++;
+        if (batch.SizeEstimate() > (1 << 24)) {
+            addressIndexDB->WriteBatch(batch);
+            batch.Clear();
+        }
+    };
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char,CAddressIndexKey> key;
+        if (!pcursor->GetKey(key) || key.first != DB_ADDRESSINDEX)
+            break;
+        if (key.second.type != current.type || key.second.hashBytes != current.hashBytes) {
+            fnWriteCurrent();
+            current = CAddressIndexIteratorKey(key.second.type, key.second.hashBytes);
+            value.SetNull();
+        }
+        CAmount nValue;
+        if (!pcursor->GetValue(nValue))
+            return error("failed to get address index value");
+        value.balance += nValue;
+        if (nValue > 0)
+            value.received += nValue;
+        pcursor->Next();
+    }
+    fnWriteCurrent();
+
+    LogPrintf("%s: wrote balances of %u addresses\n", __func__, (unsigned int)nAddresses);
+    return addressIndexDB->WriteBatch(batch);
 }
 
 bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
                                     std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
                                     int start, int end) {
+    return ForEachAddressIndex(addressHash, type, [&](const CAddressIndexKey& key, CAmount nValue) {
+        addressIndex.push_back(std::make_pair(key, nValue));
+        return true;
+    }, start, end);
+}
 
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+bool CBlockTreeDB::ForEachAddressIndex(uint160 addressHash, int type,
+                                       const std::function<bool(const CAddressIndexKey&, CAmount)>& fn,
+                                       int start, int end, const CAddressIndexKey* pkeyFrom) {
 
-    if (start > 0 && end > 0) {
+    std::unique_ptr<CDBIterator> pcursor(addressIndexDB->NewIterator());
+
+    if (pkeyFrom) {
+        pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, *pkeyFrom));
+    } else if (start > 0 && end > 0) {
         pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorHeightKey(type, addressHash, start)));
     } else {
         pcursor->Seek(std::make_pair(DB_ADDRESSINDEX, CAddressIndexIteratorKey(type, addressHash)));
@@ -293,7 +524,8 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
             }
             CAmount nValue;
             if (pcursor->GetValue(nValue)) {
-                addressIndex.push_back(std::make_pair(key.second, nValue));
+                if (!fn(key.second, nValue))
+                    break;
                 pcursor->Next();
             } else {
                 return error("failed to get address index value");
@@ -307,14 +539,14 @@ bool CBlockTreeDB::ReadAddressIndex(uint160 addressHash, int type,
 }
 
 bool CBlockTreeDB::WriteTimestampIndex(const CTimestampIndexKey &timestampIndex) {
-    CDBBatch batch(*this);
+    CDBBatch batch(*timestampIndexDB);
     batch.Write(std::make_pair(DB_TIMESTAMPINDEX, timestampIndex), 0);
-    return WriteBatch(batch);
+    return timestampIndexDB->WriteBatch(batch);
 }
 
 bool CBlockTreeDB::ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &hashes) {
 
-    std::unique_ptr<CDBIterator> pcursor(NewIterator());
+    std::unique_ptr<CDBIterator> pcursor(timestampIndexDB->NewIterator());
 
     pcursor->Seek(std::make_pair(DB_TIMESTAMPINDEX, CTimestampIndexIteratorKey(low)));
 
@@ -344,6 +576,124 @@ bool CBlockTreeDB::ReadFlag(const std::string &name, bool &fValue) {
     return true;
 }
 
+bool CBlockTreeDB::ReadIndexBuildState(int &nIndexes, uint256 &hashBlock) {
+    std::pair<int, uint256> state;
+    if (!addressIndexDB->Read(DB_INDEXBUILD, state))
+        return false;
+    nIndexes = state.first;
+    hashBlock = state.second;
+    return true;
+}
+
+bool CBlockTreeDB::WriteIndexBuildBatch(const CAdditionalIndexEntries &entries, bool fDisconnect, int nIndexes, const uint256 &hashBlock) {
+    // Spent and timestamp entries are absolute, so they are written first. If the node stops before the
+    // address batch (which also carries the build progress) made it to disk, writing them again is harmless.
+    CDBBatch batchSpent(*spentIndexDB);
+    for (const auto& p : entries.spentIndex) {
+        if (p.second.IsNull())
+            batchSpent.Erase(std::make_pair(DB_SPENTINDEX, p.first));
+        else
+            batchSpent.Write(std::make_pair(DB_SPENTINDEX, p.first), p.second);
+    }
+    CDBBatch batchTimestamp(*timestampIndexDB);
+    for (const auto& key : entries.timestampIndex) {
+        if (fDisconnect)
+            batchTimestamp.Erase(std::make_pair(DB_TIMESTAMPINDEX, key));
+        else
+            batchTimestamp.Write(std::make_pair(DB_TIMESTAMPINDEX, key), 0);
+    }
+    if (!spentIndexDB->WriteBatch(batchSpent) || !timestampIndexDB->WriteBatch(batchTimestamp))
+        return false;
+
+    CDBBatch batch(*addressIndexDB);
+    for (const auto& p : entries.addressIndex) {
+        if (fDisconnect)
+            batch.Erase(std::make_pair(DB_ADDRESSINDEX, p.first));
+        else
+            batch.Write(std::make_pair(DB_ADDRESSINDEX, p.first), p.second);
+    }
+    UpdateAddressBalances(batch, entries.addressIndex, fDisconnect);
+    // unspent entries carry their own direction, null values are erased
+    for (const auto& p : entries.addressUnspentIndex) {
+        if (p.second.IsNull())
+            batch.Erase(std::make_pair(DB_ADDRESSUNSPENTINDEX, p.first));
+        else
+            batch.Write(std::make_pair(DB_ADDRESSUNSPENTINDEX, p.first), p.second);
+    }
+    batch.Write(DB_INDEXBUILD, std::make_pair(nIndexes, hashBlock));
+    return addressIndexDB->WriteBatch(batch);
+}
+
+bool CBlockTreeDB::FinishIndexBuild(const std::vector<std::string> &vFlags) {
+    CDBBatch batch(*this);
+    for (const auto& name : vFlags)
+        batch.Write(std::make_pair(DB_FLAG, name), '1');
+    if (!WriteBatch(batch, true))
+        return false;
+    return addressIndexDB->Erase(DB_INDEXBUILD, true);
+}
+
+template <typename K, typename V>
+static bool MoveIndexEntries(CDBWrapper &from, CDBWrapper &to, char chPrefix) {
+    std::unique_ptr<CDBIterator> pcursor(from.NewIterator());
+    pcursor->Seek(chPrefix);
+
+    CDBBatch batchFrom(from);
+    CDBBatch batchTo(to);
+    size_t nMoved = 0;
+
+    // The destination is written first, an interrupted migration just copies some entries again
+    auto fnFlush = [&]() {
+        if (!to.WriteBatch(batchTo, true) || !from.WriteBatch(batchFrom))
+            return false;
+        batchTo.Clear();
+        batchFrom.Clear();
+        return true;
+    };
+
+    while (pcursor->Valid()) {
+        boost::this_thread::interruption_point();
+        std::pair<char, K> key;
+        if (!pcursor->GetKey(key) || key.first != chPrefix)
+            break;
+        V value;
+        if (!pcursor->GetValue(value))
+            return error("%s: failed to read index entry", __func__);
+        batchTo.Write(key, value);
+        batchFrom.Erase(key);
+        nMoved++;
+        if (batchTo.SizeEstimate() > (1 << 24) && !fnFlush())
+            return false;
+        pcursor->Next();
+    }
+    if (nMoved == 0)
+        return true;
+    if (!fnFlush())
+        return false;
+
+    // Get rid of the deleted entries right away, so the block index scan doesn't have to skip them
+    from.CompactRange(chPrefix, (char)(chPrefix + 1));
+    LogPrintf("%s: moved %u entries with prefix '%c'\n", __func__, (unsigned int)nMoved, chPrefix);
+    return true;
+}
+
+bool CBlockTreeDB::MigrateIndexes() {
+    if (!MoveIndexEntries<uint256, CDiskTxPos>(*this, *txIndexDB, DB_TXINDEX) ||
+        !MoveIndexEntries<CAddressIndexKey, CAmount>(*this, *addressIndexDB, DB_ADDRESSINDEX) ||
+        !MoveIndexEntries<CAddressUnspentKey, CAddressUnspentValue>(*this, *addressIndexDB, DB_ADDRESSUNSPENTINDEX) ||
+        !MoveIndexEntries<CAddressIndexIteratorKey, CAddressBalanceValue>(*this, *addressIndexDB, DB_ADDRESSBALANCEINDEX) ||
+        !MoveIndexEntries<CSpentIndexKey, CSpentIndexValue>(*this, *spentIndexDB, DB_SPENTINDEX) ||
+        !MoveIndexEntries<CTimestampIndexKey, int>(*this, *timestampIndexDB, DB_TIMESTAMPINDEX))
+        return false;
+
+    std::pair<int, uint256> state;
+    if (Read(DB_INDEXBUILD, state)) {
+        if (!addressIndexDB->Write(DB_INDEXBUILD, state, true) || !Erase(DB_INDEXBUILD, true))
+            return false;
+    }
+    return true;
+}
+
 bool CBlockTreeDB::LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex)
 {
     std::unique_ptr<CDBIterator> pcursor(NewIterator());
@@ -10,9 +10,14 @@
 #include "dbwrapper.h"
 #include "chain.h"
 #include "spentindex.h"
+#include "sync.h"
 
+#include <atomic>
+#include <functional>
 #include <map>
+#include <memory>
 #include <string>
+#include <thread>
 #include <utility>
 #include <vector>
 
@@ -32,14 +37,18 @@ static const int64_t nDefaultDbCache = 300;
 static const int64_t nMaxDbCache = sizeof(void*) > 4 ? 16384 : 1024;
 //! min. -dbcache (MiB)
 static const int64_t nMinDbCache = 4;
-//! Max memory allocated to block tree DB specific cache, if no -txindex (MiB)
+//! Max memory allocated to block tree DB specific cache (MiB)
 static const int64_t nMaxBlockDBCache = 2;
-//! Max memory allocated to block tree DB specific cache, if -txindex (MiB)
+//! Max memory allocated to the optional index databases together (MiB)
 // Unlike for the UTXO database, for the txindex scenario the leveldb cache make
 // a meaningful difference: https://github.com/bitcoin/bitcoin/pull/8273#issuecomment-229601991
-static const int64_t nMaxBlockDBAndTxIndexCache = 1024;
+static const int64_t nMaxIndexDBCache = 1024;
+//! Memory allocated to the database of a disabled optional index (MiB)
+static const int64_t nDisabledIndexDBCache = 1;
 //! Max memory allocated to coin DB specific cache (MiB)
 static const int64_t nMaxCoinsDBCache = 8;
+//! -asynccoinsflush default
+static const bool DEFAULT_ASYNC_COINS_FLUSH = false;
 
 struct CDiskTxPos : public CDiskBlockPos
 {
@@ -71,8 +80,43 @@ class CCoinsViewDB : public CCoinsView
 {
 protected:
     CDBWrapper db;
+
+    /**
+     * Background flush (-asynccoinsflush).
+     *
+     * BatchWrite() moves the dirty entries into pendingCoins and returns, the actual LevelDB
+     * write (including DB_BEST_BLOCK, in the same atomic batch) happens in flushThread. Until
+     * it is finished, reads are answered from pendingCoins first, so callers see the new state
+     * right away. On a crash during the write the database still holds the previous consistent
+     * state and the missing blocks are connected again on startup.
+     *
+     * Only one background write is in flight at a time: the next BatchWrite() (or Cursor())
+     * waits for it. pendingCoins and hashPendingBlock are only modified while no write is in
+     * flight; the flush thread only reads them.
+     *
+     * The pending coins count against -dbcache (see FlushStateToDisk()).
+     *
+     * afterWriteHook runs after every successful write of a batch (in either mode, on the thread
+     * which did the write). It is used to write EvoDB right behind the matching coins.
+     */
+    const bool fAsyncFlush;
+    mutable CCriticalSection cs_pending;
+    std::unique_ptr<CCoinsMapMemoryResource> pendingCoinsMemoryResource;
+    CCoinsMap pendingCoins;
+    uint256 hashPendingBlock;
+    size_t nPendingCoinsUsage;
+    std::thread flushThread;
+    std::atomic<bool> fFlushDone;
+    std::atomic<bool> fFlushFailed;
+    std::function<bool()> afterWriteHook;
+
+    bool WriteCoins(const CCoinsMap &mapCoins, const uint256 &hashBlock);
+    void ThreadFlush();
+    bool FinishFlush(bool fWait);
+
 public:
-    CCoinsViewDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+    CCoinsViewDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false, bool fAsyncFlushIn = false);
+    ~CCoinsViewDB();
 
 
     bool GetCoin(const COutPoint &outpoint, Coin &coin) const override;
@@ -84,6 +128,16 @@ public:
     //! Attempt to update from an older database format. Returns whether an error occurred.
     bool Upgrade();
     size_t EstimateSize() const override;
+
+    /**
+     * Wait for a running background flush (or, if fWait is false, only reap an already finished
+     * one) and release its memory. Returns false if the background write failed.
+     */
+    bool FinishAsyncFlush(bool fWait = true);
+    //! Memory used by coins which are still being written in the background
+    size_t PendingMemoryUsage() const;
+    //! Set the function to call after a batch was written, a failure counts as a failed write
+    void SetAfterWriteHook(const std::function<bool()>& hook) { afterWriteHook = hook; }
 };
 
 /** Specialization of CCoinsViewCursor to iterate over a CCoinsViewDB */
@@ -108,12 +162,41 @@ private:
     friend class CCoinsViewDB;
 };
 
-/** Access to the block database (blocks/index/) */
+/** leveldb cache sizes (in bytes) of the optional index databases */
+struct CIndexDBCacheSizes
+{
+    size_t nTxIndex{nDisabledIndexDBCache << 20};
+    size_t nAddressIndex{nDisabledIndexDBCache << 20};
+    size_t nSpentIndex{nDisabledIndexDBCache << 20};
+    size_t nTimestampIndex{nDisabledIndexDBCache << 20};
+};
+
+/** Index entries of one or more blocks, as written by the background index builder */
+struct CAdditionalIndexEntries
+{
+    std::vector<std::pair<CAddressIndexKey, CAmount> > addressIndex;
+    std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
+    std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
+    std::vector<CTimestampIndexKey> timestampIndex;
+};
+
+/**
+ * Access to the block tree database (blocks/index).
+ *
+ * The optional indexes (-txindex, -addressindex, -spentindex and -timestampindex) are kept in
+ * databases of their own below indexes/, so their writes and compactions don't interfere with the
+ * block index and loading the block index doesn't have to skip over them.
+ */
 class CBlockTreeDB : public CDBWrapper
 {
 public:
-    CBlockTreeDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false);
+    CBlockTreeDB(size_t nCacheSize, bool fMemory = false, bool fWipe = false, const CIndexDBCacheSizes &indexCacheSizes = CIndexDBCacheSizes());
 private:
+    std::unique_ptr<CDBWrapper> txIndexDB;
+    std::unique_ptr<CDBWrapper> addressIndexDB;
+    std::unique_ptr<CDBWrapper> spentIndexDB;
+    std::unique_ptr<CDBWrapper> timestampIndexDB;
+
     CBlockTreeDB(const CBlockTreeDB&);
     void operator=(const CBlockTreeDB&);
 public:
@@ -129,16 +212,44 @@ public:
     bool UpdateAddressUnspentIndex(const std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue > >&vect);
     bool ReadAddressUnspentIndex(uint160 addressHash, int type,
                                  std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &vect);
+    //! Call fn for every unspent output of the address in index order, until it returns false
+    bool ForEachAddressUnspent(uint160 addressHash, int type,
+                               const std::function<bool(const CAddressUnspentKey&, const CAddressUnspentValue&)>& fn);
     bool WriteAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
     bool EraseAddressIndex(const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect);
+    bool ReadAddressBalance(uint160 addressHash, int type, CAddressBalanceValue &value);
+    //! (Re)build the per-address balance records from the full address index, in one pass
+    bool BuildAddressBalanceIndex();
     bool ReadAddressIndex(uint160 addressHash, int type,
                           std::vector<std::pair<CAddressIndexKey, CAmount> > &addressIndex,
                           int start = 0, int end = 0);
+    /**
+     * Call fn for every address index entry of the address in index order, until it returns false.
+     * If pkeyFrom is given, iteration starts at that key (inclusive) instead of at start.
+     */
+    bool ForEachAddressIndex(uint160 addressHash, int type,
+                             const std::function<bool(const CAddressIndexKey&, CAmount)>& fn,
+                             int start = 0, int end = 0, const CAddressIndexKey* pkeyFrom = nullptr);
     bool WriteTimestampIndex(const CTimestampIndexKey &timestampIndex);
     bool ReadTimestampIndex(const unsigned int &high, const unsigned int &low, std::vector<uint256> &vect);
     bool WriteFlag(const std::string &name, bool fValue);
     bool ReadFlag(const std::string &name, bool &fValue);
+    //! Progress of an unfinished background index build: the indexes being built and the last block they contain
+    bool ReadIndexBuildState(int &nIndexes, uint256 &hashBlock);
+    /**
+     * Write (or, if fDisconnect, erase) the entries of a range of blocks built in the background and
+     * record hashBlock as the new build progress, all in one batch.
+     */
+    bool WriteIndexBuildBatch(const CAdditionalIndexEntries &entries, bool fDisconnect, int nIndexes, const uint256 &hashBlock);
+    //! Set the given index flags and forget the build progress
+    bool FinishIndexBuild(const std::vector<std::string> &vFlags);
+    //! Move index entries written by older versions from the block tree database to the index databases
+    bool MigrateIndexes();
     bool LoadBlockIndexGuts(boost::function<CBlockIndex*(const uint256&)> insertBlockIndex);
+
+private:
+    //! Apply the balance changes of the address index entries vect is about to add (or, if fUndo, remove) to batch
+    void UpdateAddressBalances(CDBBatch &batch, const std::vector<std::pair<CAddressIndexKey, CAmount> > &vect, bool fUndo);
 };
 
 #endif // BITCOIN_TXDB_H
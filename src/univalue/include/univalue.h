@@ -67,6 +67,8 @@ public:
     bool empty() const { return (values.size() == 0); }
 
     size_t size() const { return values.size(); }
+    // Polis local patch: pre-size an array or object for n entries
+    void reserve(size_t n);
 
     bool getBool() const { return isTrue(); }
     bool checkObject(const std::map<std::string,UniValue::VType>& memberTypes);
@@ -84,6 +86,8 @@ public:
     bool isObject() const { return (typ == VOBJ); }
 
     bool push_back(const UniValue& val);
+    // Polis local patch: move overload, avoids copying whole subtrees
+    bool push_back(UniValue&& val);
     bool push_back(const std::string& val_) {
         UniValue tmpVal(VSTR, val_);
         return push_back(tmpVal);
@@ -95,6 +99,8 @@ public:
     bool push_backV(const std::vector<UniValue>& vec);
 
     bool pushKV(const std::string& key, const UniValue& val);
+    // Polis local patch: move overload, avoids copying whole subtrees
+    bool pushKV(const std::string& key, UniValue&& val);
     bool pushKV(const std::string& key, const std::string& val_) {
         UniValue tmpVal(VSTR, val_);
         return pushKV(key, tmpVal);
@@ -123,6 +129,10 @@ public:
 
     std::string write(unsigned int prettyIndent = 0,
                       unsigned int indentLevel = 0) const;
+    // Polis local patch: append the JSON encoding to s, so that callers
+    // can reuse one buffer for a whole reply
+    void write(std::string& s, unsigned int prettyIndent = 0,
+               unsigned int indentLevel = 0) const;
 
     bool read(const char *raw);
     bool read(const std::string& rawStr) {
@@ -154,7 +164,8 @@ public:
 
     enum VType type() const { return getType(); }
     bool push_back(std::pair<std::string,UniValue> pear) {
-        return pushKV(pear.first, pear.second);
+        // Polis local patch: move the value out of the pair
+        return pushKV(pear.first, std::move(pear.second));
     }
     friend const UniValue& find_value( const UniValue& obj, const std::string& name);
 };
@@ -223,6 +234,17 @@ static inline std::pair<std::string,UniValue> Pair(std::string key, const UniVal
     return std::make_pair(key, uVal);
 }
 
+// Polis local patch: move overloads of Pair()
+static inline std::pair<std::string,UniValue> Pair(const char *cKey, UniValue&& uVal)
+{
+    return std::make_pair(std::string(cKey), std::move(uVal));
+}
+
+static inline std::pair<std::string,UniValue> Pair(std::string key, UniValue&& uVal)
+{
+    return std::make_pair(std::move(key), std::move(uVal));
+}
+
 enum jtokentype {
     JTOK_ERR        = -1,
     JTOK_NONE       = 0,                           // eof
@@ -179,6 +179,16 @@ bool UniValue::push_back(const UniValue& val_)
     return true;
 }
 
+// Polis local patch
+bool UniValue::push_back(UniValue&& val_)
+{
+    if (typ != VARR)
+        return false;
+
+    values.push_back(std::move(val_));
+    return true;
+}
+
 bool UniValue::push_backV(const std::vector<UniValue>& vec)
 {
     if (typ != VARR)
@@ -199,6 +209,17 @@ bool UniValue::pushKV(const std::string& key, const UniValue& val_)
     return true;
 }
 
+// Polis local patch
+bool UniValue::pushKV(const std::string& key, UniValue&& val_)
+{
+    if (typ != VOBJ)
+        return false;
+
+    keys.push_back(key);
+    values.push_back(std::move(val_));
+    return true;
+}
+
 bool UniValue::pushKVs(const UniValue& obj)
 {
     if (typ != VOBJ || obj.typ != VOBJ)
@@ -212,6 +233,14 @@ bool UniValue::pushKVs(const UniValue& obj)
     return true;
 }
 
+// Polis local patch
+void UniValue::reserve(size_t n)
+{
+    if (typ == VOBJ)
+        keys.reserve(n);
+    values.reserve(n);
+}
+
 int UniValue::findKey(const std::string& key) const
 {
     for (unsigned int i = 0; i < keys.size(); i++) {
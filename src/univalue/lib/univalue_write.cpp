@@ -10,22 +10,24 @@
 
 using namespace std;
 
-static string json_escape(const string& inS)
+// Polis local patch: append inS as a quoted JSON string to outS instead of
+// returning a temporary, copying runs which don't need escaping in one go
+static void json_escape(const string& inS, string& outS)
 {
-    string outS;
-    outS.reserve(inS.size() * 2);
+    outS += '"';
 
-    for (unsigned int i = 0; i < inS.size(); i++) {
-        unsigned char ch = inS[i];
-        const char *escStr = escapes[ch];
-
-        if (escStr)
+    size_t nStart = 0;
+    for (size_t i = 0; i < inS.size(); i++) {
+        const char *escStr = escapes[(unsigned char)inS[i]];
+        if (escStr) {
+            outS.append(inS, nStart, i - nStart);
             outS += escStr;
-        else
-            outS += ch;
+            nStart = i + 1;
+        }
     }
+    outS.append(inS, nStart, string::npos);
 
-    return outS;
+    outS += '"';
 }
 
 string UniValue::write(unsigned int prettyIndent,
@@ -33,7 +35,14 @@ string UniValue::write(unsigned int prettyIndent,
 {
     string s;
     s.reserve(1024);
+    write(s, prettyIndent, indentLevel);
+    return s;
+}
 
+// Polis local patch: the recursive writer appends to the caller's buffer
+void UniValue::write(string& s, unsigned int prettyIndent,
+                     unsigned int indentLevel) const
+{
     unsigned int modIndent = indentLevel;
     if (modIndent == 0)
         modIndent = 1;
@@ -49,7 +58,7 @@ string UniValue::write(unsigned int prettyIndent,
         writeArray(prettyIndent, modIndent, s);
         break;
     case VSTR:
-        s += "\"" + json_escape(val) + "\"";
+        json_escape(val, s);
         break;
     case VNUM:
         s += val;
@@ -58,8 +67,6 @@ string UniValue::write(unsigned int prettyIndent,
         s += (val == "1" ? "true" : "false");
         break;
     }
-
-    return s;
 }
 
 static void indentStr(unsigned int prettyIndent, unsigned int indentLevel, string& s)
@@ -76,7 +83,7 @@ void UniValue::writeArray(unsigned int prettyIndent, unsigned int indentLevel, s
     for (unsigned int i = 0; i < values.size(); i++) {
         if (prettyIndent)
             indentStr(prettyIndent, indentLevel, s);
-        s += values[i].write(prettyIndent, indentLevel + 1);
+        values[i].write(s, prettyIndent, indentLevel + 1);
         if (i != (values.size() - 1)) {
             s += ",";
             if (prettyIndent)
@@ -100,10 +107,11 @@ void UniValue::writeObject(unsigned int prettyIndent, unsigned int indentLevel,
     for (unsigned int i = 0; i < keys.size(); i++) {
         if (prettyIndent)
             indentStr(prettyIndent, indentLevel, s);
-        s += "\"" + json_escape(keys[i]) + "\":";
+        json_escape(keys[i], s);
+        s += ':';
         if (prettyIndent)
             s += " ";
-        s += values.at(i).write(prettyIndent, indentLevel + 1);
+        values.at(i).write(s, prettyIndent, indentLevel + 1);
         if (i != (values.size() - 1))
             s += ",";
         if (prettyIndent)
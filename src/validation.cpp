@@ -79,9 +79,9 @@ int nScriptCheckThreads = 0;
 std::atomic_bool fImporting(false);
 bool fReindex = false;
 bool fTxIndex = true;
-bool fAddressIndex = false;
-bool fTimestampIndex = false;
-bool fSpentIndex = false;
+std::atomic<bool> fAddressIndex{false};
+std::atomic<bool> fTimestampIndex{false};
+std::atomic<bool> fSpentIndex{false};
 bool fHavePruned = false;
 bool fPruneMode = false;
 bool fIsBareMultisigStd = DEFAULT_PERMIT_BAREMULTISIG;
@@ -1044,7 +1044,8 @@ bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state, const C
 
         // Check against previous transactions
         // This is done last to help prevent CPU exhaustion denial-of-service attacks.
-        if (!CheckInputs(tx, state, view, true, STANDARD_SCRIPT_VERIFY_FLAGS, true))
+        PrecomputedTransactionData txdata(tx);
+        if (!CheckInputs(tx, state, view, true, STANDARD_SCRIPT_VERIFY_FLAGS, true, txdata))
             return false; // state filled in by CheckInputs
 
         // Check again against just the consensus-critical mandatory script
@@ -1056,7 +1057,7 @@ bool AcceptToMemoryPoolWorker(CTxMemPool& pool, CValidationState& state, const C
         // There is a similar check in CreateNewBlock() to prevent creating
         // invalid blocks, however allowing such transactions into the mempool
         // can be exploited as a DoS attack.
-        if (!CheckInputs(tx, state, view, true, MANDATORY_SCRIPT_VERIFY_FLAGS, true))
+        if (!CheckInputs(tx, state, view, true, MANDATORY_SCRIPT_VERIFY_FLAGS, true, txdata))
         {
             return error("%s: BUG! PLEASE REPORT THIS! ConnectInputs failed against MANDATORY but not STANDARD flags %s, %s",
                 __func__, hash.ToString(), FormatStateMessage(state));
@@ -1154,6 +1155,20 @@ bool GetAddressIndex(uint160 addressHash, int type,
     return true;
 }
 
+bool GetAddressBalance(uint160 addressHash, int type, CAmount &balance, CAmount &received)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    CAddressBalanceValue value;
+    if (!pblocktree->ReadAddressBalance(addressHash, type, value))
+        return error("unable to get balance for address");
+
+    balance = value.balance;
+    received = value.received;
+    return true;
+}
+
 bool GetAddressUnspent(uint160 addressHash, int type,
                        std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > &unspentOutputs)
 {
@@ -1166,11 +1181,37 @@ bool GetAddressUnspent(uint160 addressHash, int type,
     return true;
 }
 
+bool ForEachAddressIndex(uint160 addressHash, int type,
+                         const std::function<bool(const CAddressIndexKey&, CAmount)>& fn,
+                         int start, int end, const CAddressIndexKey* pkeyFrom)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ForEachAddressIndex(addressHash, type, fn, start, end, pkeyFrom))
+        return error("unable to get txids for address");
+
+    return true;
+}
+
+bool ForEachAddressUnspent(uint160 addressHash, int type,
+                           const std::function<bool(const CAddressUnspentKey&, const CAddressUnspentValue&)>& fn)
+{
+    if (!fAddressIndex)
+        return error("address index not enabled");
+
+    if (!pblocktree->ForEachAddressUnspent(addressHash, type, fn))
+        return error("unable to get txids for address");
+
+    return true;
+}
+
 /** Return transaction in txOut, and if it was found inside a block, its hash is placed in hashBlock */
 bool GetTransaction(const uint256 &hash, CTransactionRef &txOut, const Consensus::Params& consensusParams, uint256 &hashBlock, bool fAllowSlow)
 {
     CBlockIndex *pindexSlow = NULL;
-    LOCK(cs_main);
+    // The mempool and the tx index have their own locks, cs_main is only needed for the slow path, so
+    // lookups with -txindex can run in parallel
     CTransactionRef ptx = mempool.get(hash);
     if (ptx)
     {
@@ -1201,6 +1242,7 @@ bool GetTransaction(const uint256 &hash, CTransactionRef &txOut, const Consensus
     }
 
     if (fAllowSlow) { // use coin database to locate block that contains transaction, and scan it
+        LOCK(cs_main);
         const Coin& coin = AccessByTxid(*pcoinsTip, hash);
         if (!coin.IsSpent()) pindexSlow = chainActive[coin.nHeight];
     }
@@ -1527,7 +1569,7 @@ void UpdateCoins(const CTransaction& tx, CCoinsViewCache& inputs, int nHeight)
 
 bool CScriptCheck::operator()() {
     const CScript &scriptSig = ptxTo->vin[nIn].scriptSig;
-    if (!VerifyScript(scriptSig, scriptPubKey, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, cacheStore), &error)) {
+    if (!VerifyScript(scriptSig, scriptPubKey, nFlags, CachingTransactionSignatureChecker(ptxTo, nIn, cacheStore, *txdata), &error)) {
         return false;
     }
     return true;
@@ -1589,7 +1631,7 @@ bool CheckTxInputs(const CTransaction& tx, CValidationState& state, const CCoins
 }
 }// namespace Consensus
 
-bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsViewCache &inputs, bool fScriptChecks, unsigned int flags, bool cacheStore, std::vector<CScriptCheck> *pvChecks)
+bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsViewCache &inputs, bool fScriptChecks, unsigned int flags, bool cacheStore, PrecomputedTransactionData& txdata, std::vector<CScriptCheck> *pvChecks)
 {
     if (!tx.IsCoinBase())
     {
@@ -1625,7 +1667,7 @@ bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsVi
                     continue;
 
                 // Verify signature
-                CScriptCheck check(scriptPubKey, amount, tx, i, flags, cacheStore);
+                CScriptCheck check(scriptPubKey, amount, tx, i, flags, cacheStore, &txdata);
                 if (pvChecks) {
                     pvChecks->push_back(CScriptCheck());
                     check.swap(pvChecks->back());
@@ -1638,7 +1680,7 @@ bool CheckInputs(const CTransaction& tx, CValidationState &state, const CCoinsVi
                         // avoid splitting the network between upgraded and
                         // non-upgraded nodes.
                         CScriptCheck check2(scriptPubKey, amount, tx, i,
-                                flags & ~STANDARD_NOT_MANDATORY_VERIFY_FLAGS, cacheStore);
+                                flags & ~STANDARD_NOT_MANDATORY_VERIFY_FLAGS, cacheStore, &txdata);
                         if (check2())
                             return state.Invalid(false, REJECT_NONSTANDARD, strprintf("non-mandatory-script-verify-flag (%s)", ScriptErrorString(check.GetScriptError())));
                     }
@@ -1690,6 +1732,8 @@ bool UndoWriteToDisk(const CBlockUndo& blockundo, CDiskBlockPos& pos, const uint
     return true;
 }
 
+} // anon namespace
+
 bool UndoReadFromDisk(CBlockUndo& blockundo, const CDiskBlockPos& pos, const uint256& hashBlock)
 {
     // Open history file to read
@@ -1716,6 +1760,8 @@ bool UndoReadFromDisk(CBlockUndo& blockundo, const CDiskBlockPos& pos, const uin
     return true;
 }
 
+namespace {
+
 /** Abort with a message */
 bool AbortNode(const std::string& strMessage, const std::string& userMessage="")
 {
@@ -1912,8 +1958,12 @@ static DisconnectResult DisconnectBlock(const CBlock& block, CValidationState& s
 
                     } else if (prevout.scriptPubKey.IsPayToPublicKey()) {
                         uint160 hashBytes(Hash160(prevout.scriptPubKey.begin()+1, prevout.scriptPubKey.end()-1));
-                        addressIndex.push_back(std::make_pair(CAddressIndexKey(1, hashBytes, pindex->nHeight, i, hash, j, false), prevout.nValue));
-                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, hashBytes, hash, j), CAddressUnspentValue()));
+
+                        // undo spending activity
+                        addressIndex.push_back(std::make_pair(CAddressIndexKey(1, hashBytes, pindex->nHeight, i, hash, j, true), prevout.nValue * -1));
+
+                        // restore unspent index
+                        addressUnspentIndex.push_back(std::make_pair(CAddressUnspentKey(1, hashBytes, input.prevout.hash, input.prevout.n), CAddressUnspentValue(prevout.nValue, prevout.scriptPubKey, undoHeight)));
                     } else {
                         continue;
                     }
@@ -1973,7 +2023,45 @@ void static FlushBlockFile(bool fFinalize = false)
 
 bool FindUndoPos(CValidationState &state, int nFile, CDiskBlockPos &pos, unsigned int nAddSize);
 
-static CCheckQueue<CScriptCheck> scriptcheckqueue(128);
+/**
+ * A deferred check of ConnectBlock: either a script check or the context-free part of a special tx check. Both kinds
+ * share the script check queue, so that the -par threads verify all of them
+ */
+class CBlockCheck
+{
+private:
+    CScriptCheck scriptCheck;
+    CSpecialTxCheck specialTxCheck;
+    bool fSpecialTx;
+
+public:
+    CBlockCheck() : fSpecialTx(false) {}
+    explicit CBlockCheck(CScriptCheck& check) : fSpecialTx(false) { scriptCheck.swap(check); }
+    explicit CBlockCheck(CSpecialTxCheck& check) : fSpecialTx(true) { specialTxCheck.swap(check); }
+
+    bool operator()() {
+        return fSpecialTx ? specialTxCheck() : scriptCheck();
+    }
+
+    void swap(CBlockCheck &check) {
+        scriptCheck.swap(check.scriptCheck);
+        specialTxCheck.swap(check.specialTxCheck);
+        std::swap(fSpecialTx, check.fSpecialTx);
+    }
+};
+
+template <typename T>
+static void AddBlockChecks(CCheckQueueControl<CBlockCheck>& control, std::vector<T>& vChecks)
+{
+    std::vector<CBlockCheck> vBlockChecks;
+    vBlockChecks.reserve(vChecks.size());
+    for (auto& check : vChecks) {
+        vBlockChecks.emplace_back(check);
+    }
+    control.Add(vBlockChecks);
+}
+
+static CCheckQueue<CBlockCheck> scriptcheckqueue(128);
 
 void ThreadScriptCheck() {
     RenameThread("polis-scriptch");
@@ -2274,7 +2362,8 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
 
     CBlockUndo blockundo;
 
-    CCheckQueueControl<CScriptCheck> control(fScriptChecks && nScriptCheckThreads ? &scriptcheckqueue : NULL);
+    // special txs are always fully checked, independent of fScriptChecks (CheckInputs doesn't queue any script checks then)
+    CCheckQueueControl<CBlockCheck> control(nScriptCheckThreads ? &scriptcheckqueue : NULL);
 
     std::vector<int> prevheights;
     CAmount nFees = 0;
@@ -2288,6 +2377,9 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
     std::vector<std::pair<CAddressUnspentKey, CAddressUnspentValue> > addressUnspentIndex;
     std::vector<std::pair<CSpentIndexKey, CSpentIndexValue> > spentIndex;
 
+    std::vector<PrecomputedTransactionData> txdata;
+    txdata.reserve(block.vtx.size()); // Required so that pointers to individual PrecomputedTransactionData don't get invalidated
+
     bool fDIP0001Active_context = pindex->nHeight >= Params().GetConsensus().DIP0001Height;
     CAmount nValueOut = 0;
     CAmount nValueIn = 0;
@@ -2296,6 +2388,14 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
         const CTransaction &tx = *(block.vtx[i]);
         const uint256 txhash = tx.GetHash();
 
+        std::vector<CSpecialTxCheck> vSpecialTxChecks;
+        if (!CheckSpecialTx(tx, pindex->pprev, state, nScriptCheckThreads ? &vSpecialTxChecks : NULL))
+            return error("ConnectBlock(): CheckSpecialTx on %s failed with %s",
+                         txhash.ToString(), FormatStateMessage(state));
+        AddBlockChecks(control, vSpecialTxChecks);
+
+        txdata.emplace_back(tx);
+
         nInputs += tx.vin.size();
         nSigOps += GetLegacySigOpCount(tx);
         if (nSigOps > MaxBlockSigOps(fDIP0001Active_context))
@@ -2380,10 +2480,10 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
 
             std::vector<CScriptCheck> vChecks;
             bool fCacheResults = fJustCheck; /* Don't cache results if we're actually connecting blocks (still consult the cache, though) */
-            if (!CheckInputs(tx, state, view, fScriptChecks, flags, fCacheResults, nScriptCheckThreads ? &vChecks : NULL))
+            if (!CheckInputs(tx, state, view, fScriptChecks, flags, fCacheResults, txdata[i], nScriptCheckThreads ? &vChecks : NULL))
                 return error("ConnectBlock(): CheckInputs on %s failed with %s",
                              tx.GetHash().ToString(), FormatStateMessage(state));
-            control.Add(vChecks);
+            AddBlockChecks(control, vChecks);
         }
 
         if (fAddressIndex) {
@@ -2438,12 +2538,20 @@ static bool ConnectBlock(const CBlock& block, CValidationState& state, CBlockInd
 
     LogPrint("bench", " - Connect %u transactions: %.2fms (%.3fms/tx, %.3fms/txin) [%.2fs]\n", (unsigned)block.vtx.size(), 0.001 * (nTime3 - nTime2), 0.001 * (nTime3 - nTime2) / block.vtx.size(), nInputs <= 1 ? 0 : 0.001 * (nTime3 - nTime2) / (nInputs-1), nTimeConnect * 0.000001);
 
-    if (!control.Wait())
+    if (!control.Wait()) {
+        // the queued checks don't report why they failed, so repeat the special tx checks serially to get the reject
+        // reason if one of them failed
+        for (const auto& tx : block.vtx) {
+            if (!CheckSpecialTx(*tx, pindex->pprev, state))
+                return error("ConnectBlock(): CheckSpecialTx on %s failed with %s",
+                             tx->GetHash().ToString(), FormatStateMessage(state));
+        }
         return state.DoS(100, false);
+    }
     int64_t nTime4 = GetTimeMicros(); nTimeVerify += nTime4 - nTime2;
     LogPrint("bench", "    - Verify %u txins: %.2fms (%.3fms/txin) [%.2fs]\n", nInputs - 1, 0.001 * (nTime4 - nTime2), nInputs <= 1 ? 0 : 0.001 * (nTime4 - nTime2) / (nInputs-1), nTimeVerify * 0.000001);
 
-    if (!ProcessSpecialTxsInBlock(block, pindex, state)) {
+    if (!ProcessSpecialTxsInBlock(block, pindex, state, false)) {
         return error("ConnectBlock(): ProcessSpecialTxsInBlock for block %s failed with %s",
                      pindex->GetBlockHash().ToString(), FormatStateMessage(state));
     }
@@ -2608,8 +2716,12 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int n
     if (nLastSetChain == 0) {
         nLastSetChain = nNow;
     }
+    // Pick up the result of a finished background coins flush (-asynccoinsflush)
+    if (!pcoinsdbview->FinishAsyncFlush(false))
+        return AbortNode(state, "Failed to write to coin database or EvoDB");
     int64_t nMempoolSizeMax = GetArg("-maxmempool", DEFAULT_MAX_MEMPOOL_SIZE) * 1000000;
-    int64_t cacheSize = pcoinsTip->DynamicMemoryUsage() * DB_PEAK_USAGE_FACTOR;
+    // Coins which are still being written in the background (-asynccoinsflush) count against the limit as well
+    int64_t cacheSize = pcoinsTip->DynamicMemoryUsage() * DB_PEAK_USAGE_FACTOR + pcoinsdbview->PendingMemoryUsage();
     int64_t nTotalSpace = nCoinCacheUsage + std::max<int64_t>(nMempoolSizeMax - nMempoolUsage, 0);
     // The cache is large and we're within 10% and 10 MiB of the limit, but we have time now (not in the middle of a block processing).
     bool fCacheLarge = mode == FLUSH_STATE_PERIODIC && cacheSize > std::max((9 * nTotalSpace) / 10, nTotalSpace - MAX_BLOCK_COINSDB_USAGE * 1024 * 1024);
@@ -2660,12 +2772,20 @@ bool static FlushStateToDisk(CValidationState &state, FlushStateMode mode, int n
         // overwrite one. Still, use a conservative safety factor of 2.
         if (!CheckDiskSpace(48 * 2 * 2 * pcoinsTip->GetCacheSize()))
             return state.Error("out of disk space");
+        // Wait for the previous background write (and the EvoDB batch written behind it), then
+        // set aside the EvoDB changes matching the coins we're about to flush. They are written
+        // by the after-write hook of pcoinsdbview once the coins are on disk, so that EvoDB never
+        // gets ahead of the chainstate, even if we crash during a background write.
+        if (!pcoinsdbview->FinishAsyncFlush(true))
+            return AbortNode(state, "Failed to write to coin database");
+        evoDb->StageRootTransaction();
         // Flush the chainstate (which may refer to block index entries).
+        // With -asynccoinsflush this only hands the dirty coins over to the background writer.
         if (!pcoinsTip->Flush())
-            return AbortNode(state, "Failed to write to coin database");
-        if (!evoDb->CommitRootTransaction()) {
-            return AbortNode(state, "Failed to commit EvoDB");
-        }
+            return AbortNode(state, "Failed to write to coin database or EvoDB");
+        // On shutdown and when pruning block files the chainstate has to be on disk before we return.
+        if ((mode == FLUSH_STATE_ALWAYS || fFlushForPrune) && !pcoinsdbview->FinishAsyncFlush(true))
+            return AbortNode(state, "Failed to write to coin database or EvoDB");
         nLastFlush = nNow;
     }
     if (fDoFullFlush || ((mode == FLUSH_STATE_ALWAYS || mode == FLUSH_STATE_PERIODIC) && nNow > nLastSetChain + (int64_t)DATABASE_WRITE_INTERVAL * 1000000)) {
@@ -4213,15 +4333,33 @@ bool static LoadBlockIndexDB(const CChainParams& chainparams)
     LogPrintf("%s: transaction index %s\n", __func__, fTxIndex ? "enabled" : "disabled");
 
     // Check whether we have an address index
-    pblocktree->ReadFlag("addressindex", fAddressIndex);
+    bool fFlag = fAddressIndex;
+    pblocktree->ReadFlag("addressindex", fFlag);
+    fAddressIndex = fFlag;
     LogPrintf("%s: address index %s\n", __func__, fAddressIndex ? "enabled" : "disabled");
 
+    // Address indexes created before the balance records existed need them built once
+    if (fAddressIndex) {
+        bool fAddressBalanceIndex = false;
+        pblocktree->ReadFlag("addressbalanceindex", fAddressBalanceIndex);
+        if (!fAddressBalanceIndex) {
+            LogPrintf("%s: building address balance index...\n", __func__);
+            if (!pblocktree->BuildAddressBalanceIndex())
+                return error("%s: failed to build address balance index", __func__);
+            pblocktree->WriteFlag("addressbalanceindex", true);
+        }
+    }
+
     // Check whether we have a timestamp index
-    pblocktree->ReadFlag("timestampindex", fTimestampIndex);
+    fFlag = fTimestampIndex;
+    pblocktree->ReadFlag("timestampindex", fFlag);
+    fTimestampIndex = fFlag;
     LogPrintf("%s: timestamp index %s\n", __func__, fTimestampIndex ? "enabled" : "disabled");
 
     // Check whether we have a spent index
-    pblocktree->ReadFlag("spentindex", fSpentIndex);
+    fFlag = fSpentIndex;
+    pblocktree->ReadFlag("spentindex", fFlag);
+    fSpentIndex = fFlag;
     LogPrintf("%s: spent index %s\n", __func__, fSpentIndex ? "enabled" : "disabled");
 
     // Load pointer to end of best chain
@@ -4416,6 +4554,7 @@ bool InitBlockIndex(const CChainParams& chainparams)
     // Use the provided setting for -addressindex in the new database
     fAddressIndex = GetBoolArg("-addressindex", DEFAULT_ADDRESSINDEX);
     pblocktree->WriteFlag("addressindex", fAddressIndex);
+    pblocktree->WriteFlag("addressbalanceindex", fAddressIndex);
 
     // Use the provided setting for -timestampindex in the new database
     fTimestampIndex = GetBoolArg("-timestampindex", DEFAULT_TIMESTAMPINDEX);
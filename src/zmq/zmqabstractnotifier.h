@@ -7,6 +7,8 @@
 
 #include "zmqconfig.h"
 
+#include <atomic>
+
 class CBlockIndex;
 class CGovernanceObject;
 class CGovernanceVote;
@@ -14,6 +16,9 @@ class CZMQAbstractNotifier;
 
 typedef CZMQAbstractNotifier* (*CZMQNotifierFactory)();
 
+//! -zmqpub<type>hwm default, ZMQ_SNDHWM of the notifier's socket (the libzmq default)
+static const int DEFAULT_ZMQ_SNDHWM = 1000;
+
 class CZMQAbstractNotifier
 {
 public:
@@ -30,6 +35,17 @@ public:
     void SetType(const std::string &t) { type = t; }
     std::string GetAddress() const { return address; }
     void SetAddress(const std::string &a) { address = a; }
+    int GetSendHighWaterMark() const { return nSendHighWaterMark; }
+    void SetSendHighWaterMark(int n)
+    {
+        if (n >= 0)
+            nSendHighWaterMark = n;
+    }
+
+    //! Number of messages handed to the socket
+    uint64_t GetPublishedCount() const { return nPublished; }
+    //! Number of messages dropped because the publish queue was full or sending failed
+    uint64_t GetDroppedCount() const { return nDropped; }
 
     virtual bool Initialize(void *pcontext) = 0;
     virtual void Shutdown() = 0;
@@ -46,6 +62,9 @@ protected:
     void *psocket;
     std::string type;
     std::string address;
+    int nSendHighWaterMark{DEFAULT_ZMQ_SNDHWM};
+    std::atomic<uint64_t> nPublished{0};
+    std::atomic<uint64_t> nDropped{0};
 };
 
 #endif // BITCOIN_ZMQ_ZMQABSTRACTNOTIFIER_H
@@ -10,6 +10,8 @@
 #include "streams.h"
 #include "util.h"
 
+CZMQNotificationInterface* pzmqNotificationInterface = NULL;
+
 void zmqError(const char *str)
 {
     LogPrint("zmq", "zmq: Error: %s, errno=%s\n", str, zmq_strerror(errno));
@@ -58,6 +60,7 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
             CZMQAbstractNotifier *notifier = factory();
             notifier->SetType(i->first);
             notifier->SetAddress(address);
+            notifier->SetSendHighWaterMark(GetArg(arg + "hwm", DEFAULT_ZMQ_SNDHWM));
             notifiers.push_back(notifier);
         }
     }
@@ -77,6 +80,11 @@ CZMQNotificationInterface* CZMQNotificationInterface::Create()
     return notificationInterface;
 }
 
+std::list<const CZMQAbstractNotifier*> CZMQNotificationInterface::GetNotifiers() const
+{
+    return allNotifiers;
+}
+
 // Called at startup to conditionally set up ZMQ socket(s)
 bool CZMQNotificationInterface::Initialize()
 {
@@ -111,6 +119,12 @@ bool CZMQNotificationInterface::Initialize()
         return false;
     }
 
+    allNotifiers.assign(notifiers.begin(), notifiers.end());
+
+    int nQueueSize = std::max(1, (int)GetArg("-zmqqueuesize", DEFAULT_ZMQ_QUEUE_SIZE));
+    int nBatchMillis = std::min(MAX_ZMQ_BATCH_MS, std::max(0, (int)GetArg("-zmqbatchms", DEFAULT_ZMQ_BATCH_MS)));
+    zmqPublishQueue.Start(nQueueSize, nBatchMillis);
+
     return true;
 }
 
@@ -120,6 +134,7 @@ void CZMQNotificationInterface::Shutdown()
     LogPrint("zmq", "zmq: Shutdown notification interface\n");
     if (pcontext)
     {
+        zmqPublishQueue.Stop();
         for (std::list<CZMQAbstractNotifier*>::iterator i=notifiers.begin(); i!=notifiers.end(); ++i)
         {
             CZMQAbstractNotifier *notifier = *i;
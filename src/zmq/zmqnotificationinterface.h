@@ -6,6 +6,7 @@
 #define BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
 
 #include "validationinterface.h"
+#include <list>
 #include <string>
 #include <map>
 
@@ -19,6 +20,9 @@ public:
 
     static CZMQNotificationInterface* Create();
 
+    //! All configured notifiers, including those which got shut down after an error
+    std::list<const CZMQAbstractNotifier*> GetNotifiers() const;
+
 protected:
     bool Initialize();
     void Shutdown();
@@ -37,6 +41,9 @@ private:
 
     void *pcontext;
     std::list<CZMQAbstractNotifier*> notifiers;
+    std::list<const CZMQAbstractNotifier*> allNotifiers;
 };
 
+extern CZMQNotificationInterface* pzmqNotificationInterface;
+
 #endif // BITCOIN_ZMQ_ZMQNOTIFICATIONINTERFACE_H
@@ -8,8 +8,14 @@
 #include "validation.h"
 #include "util.h"
 
+#include <algorithm>
+#include <chrono>
+#include <iterator>
+
 static std::multimap<std::string, CZMQAbstractPublishNotifier*> mapPublishNotifiers;
 
+CZMQPublishQueue zmqPublishQueue;
+
 static const char *MSG_HASHBLOCK  = "hashblock";
 static const char *MSG_HASHTX     = "hashtx";
 static const char *MSG_HASHTXLOCK = "hashtxlock";
@@ -46,7 +52,8 @@ static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
 
         data = va_arg(args, const void*);
 
-        rc = zmq_msg_send(&msg, sock, data ? ZMQ_SNDMORE : 0);
+        // never block the publisher thread, PUB sockets drop messages above ZMQ_SNDHWM anyway
+        rc = zmq_msg_send(&msg, sock, (data ? ZMQ_SNDMORE : 0) | ZMQ_DONTWAIT);
         if (rc == -1)
         {
             zmqError("Unable to send ZMQ msg");
@@ -66,6 +73,107 @@ static int zmq_send_multipart(void *sock, const void* data, size_t size, ...)
     return 0;
 }
 
+void CZMQPublishQueue::Start(size_t nMaxSizeIn, int nBatchMillisIn)
+{
+    std::unique_lock<std::mutex> lock(cs);
+    assert(!fRunning);
+    nMaxSize = nMaxSizeIn;
+    nBatchMillis = nBatchMillisIn;
+    fStop = false;
+    fRunning = true;
+    threadPublish = std::thread(&CZMQPublishQueue::ThreadPublish, this);
+}
+
+void CZMQPublishQueue::Stop()
+{
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        if (!fRunning)
+            return;
+        fStop = true;
+    }
+    condQueue.notify_all();
+    threadPublish.join();
+
+    std::unique_lock<std::mutex> lock(cs);
+    fRunning = false;
+}
+
+bool CZMQPublishQueue::Push(Message&& msg)
+{
+    {
+        std::unique_lock<std::mutex> lock(cs);
+        if (!fRunning || fStop || queue.size() >= nMaxSize)
+            return false;
+        queue.push_back(std::move(msg));
+        nPeakSize = std::max(nPeakSize, queue.size());
+    }
+    condQueue.notify_one();
+    return true;
+}
+
+void CZMQPublishQueue::Remove(const CZMQAbstractPublishNotifier* notifier)
+{
+    std::unique_lock<std::mutex> lock(cs);
+    for (auto it = queue.begin(); it != queue.end(); ) {
+        if (it->notifier == notifier)
+            it = queue.erase(it);
+        else
+            ++it;
+    }
+    condIdle.wait(lock, [this]{ return !fSending; });
+}
+
+size_t CZMQPublishQueue::GetSize()
+{
+    std::unique_lock<std::mutex> lock(cs);
+    return queue.size();
+}
+
+size_t CZMQPublishQueue::GetPeakSize()
+{
+    std::unique_lock<std::mutex> lock(cs);
+    return nPeakSize;
+}
+
+size_t CZMQPublishQueue::GetMaxSize()
+{
+    std::unique_lock<std::mutex> lock(cs);
+    return nMaxSize;
+}
+
+void CZMQPublishQueue::ThreadPublish()
+{
+    RenameThread("polis-zmqpub");
+
+    std::vector<Message> vBatch;
+    std::unique_lock<std::mutex> lock(cs);
+    while (true) {
+        condQueue.wait(lock, [this]{ return fStop || !queue.empty(); });
+        if (queue.empty())
+            break;
+
+        if (nBatchMillis > 0) {
+            // give the signals some time to queue more messages, so they are sent back to back
+            condQueue.wait_for(lock, std::chrono::milliseconds(nBatchMillis), [this]{ return fStop || queue.size() >= nMaxSize; });
+        }
+
+        vBatch.assign(std::make_move_iterator(queue.begin()), std::make_move_iterator(queue.end()));
+        queue.clear();
+        fSending = true;
+        lock.unlock();
+
+        for (const Message& msg : vBatch) {
+            msg.notifier->Publish(msg);
+        }
+        vBatch.clear();
+
+        lock.lock();
+        fSending = false;
+        condIdle.notify_all();
+    }
+}
+
 bool CZMQAbstractPublishNotifier::Initialize(void *pcontext)
 {
     assert(!psocket);
@@ -82,7 +190,15 @@ bool CZMQAbstractPublishNotifier::Initialize(void *pcontext)
             return false;
         }
 
-        int rc = zmq_bind(psocket, address.c_str());
+        int rc = zmq_setsockopt(psocket, ZMQ_SNDHWM, &nSendHighWaterMark, sizeof(nSendHighWaterMark));
+        if (rc != 0)
+        {
+            zmqError("Failed to set outbound message high water mark");
+            zmq_close(psocket);
+            return false;
+        }
+
+        rc = zmq_bind(psocket, address.c_str());
         if (rc!=0)
         {
             zmqError("Failed to bind address");
@@ -109,6 +225,9 @@ void CZMQAbstractPublishNotifier::Shutdown()
 {
     assert(psocket);
 
+    // the publisher thread must not use the socket anymore
+    zmqPublishQueue.Remove(this);
+
     int count = mapPublishNotifiers.count(address);
 
     // remove this notifier from the list of publishers using this address
@@ -139,19 +258,34 @@ bool CZMQAbstractPublishNotifier::SendMessage(const char *command, const void* d
 {
     assert(psocket);
 
-    /* send three parts, command & data & a LE 4byte sequence number */
-    unsigned char msgseq[sizeof(uint32_t)];
-    WriteLE32(&msgseq[0], nSequence);
-    int rc = zmq_send_multipart(psocket, command, strlen(command), data, size, msgseq, (size_t)sizeof(uint32_t), (void*)0);
-    if (rc == -1)
-        return false;
+    CZMQPublishQueue::Message msg;
+    msg.notifier = this;
+    msg.command = command;
+    msg.data.assign((const unsigned char*)data, (const unsigned char*)data + size);
+    /* memory only sequence number, also counts dropped messages so subscribers notice them */
+    msg.nSequence = nSequence++;
 
-    /* increment memory only sequence number after sending */
-    nSequence++;
+    if (!zmqPublishQueue.Push(std::move(msg))) {
+        LogPrint("zmq", "zmq: Publish queue full, dropping %s message\n", command);
+        nDropped++;
+    }
 
+    // a full queue is not an error of the notifier, keep it
     return true;
 }
 
+void CZMQAbstractPublishNotifier::Publish(const CZMQPublishQueue::Message& msg)
+{
+    /* send three parts, command & data & a LE 4byte sequence number */
+    unsigned char msgseq[sizeof(uint32_t)];
+    WriteLE32(&msgseq[0], msg.nSequence);
+    int rc = zmq_send_multipart(psocket, msg.command, strlen(msg.command), msg.data.data(), msg.data.size(), msgseq, (size_t)sizeof(uint32_t), (void*)0);
+    if (rc == -1)
+        nDropped++;
+    else
+        nPublished++;
+}
+
 bool CZMQPublishHashBlockNotifier::NotifyBlock(const CBlockIndex *pindex)
 {
     uint256 hash = pindex->GetBlockHash();
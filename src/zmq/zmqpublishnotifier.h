@@ -7,24 +7,90 @@
 
 #include "zmqabstractnotifier.h"
 
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
 class CBlockIndex;
 class CGovernanceVote;
 class CGovernanceObject;
+class CZMQAbstractPublishNotifier;
+
+//! -zmqqueuesize default, number of messages waiting to be published before new ones get dropped
+static const int DEFAULT_ZMQ_QUEUE_SIZE = 10000;
+//! -zmqbatchms default, milliseconds to collect messages before publishing them together (0 = publish right away)
+static const int DEFAULT_ZMQ_BATCH_MS = 0;
+static const int MAX_ZMQ_BATCH_MS = 1000;
+
+/**
+ * Sends the messages of all publish notifiers from a dedicated thread.
+ *
+ * The notifiers are called from the validation signals, so sending synchronously made a slow
+ * subscriber (or a full socket buffer) delay block connection and mempool acceptance. Notifiers now
+ * only serialize their message and push it to this bounded queue. When it is full, new messages are
+ * dropped and counted. Their sequence numbers are still used up, so subscribers can detect the gap.
+ */
+class CZMQPublishQueue
+{
+public:
+    struct Message
+    {
+        CZMQAbstractPublishNotifier* notifier;
+        const char* command;
+        std::vector<unsigned char> data;
+        uint32_t nSequence;
+    };
+
+private:
+    std::mutex cs;
+    std::condition_variable condQueue;
+    std::condition_variable condIdle;
+    std::deque<Message> queue;
+    size_t nMaxSize{DEFAULT_ZMQ_QUEUE_SIZE};
+    size_t nPeakSize{0};
+    int nBatchMillis{DEFAULT_ZMQ_BATCH_MS};
+    bool fRunning{false};
+    bool fStop{false};
+    //! The publisher thread is sending messages it took from the queue
+    bool fSending{false};
+    std::thread threadPublish;
+
+    void ThreadPublish();
+
+public:
+    void Start(size_t nMaxSizeIn, int nBatchMillisIn);
+    //! Publish the remaining messages and stop the thread
+    void Stop();
+    //! Returns false if the message was dropped
+    bool Push(Message&& msg);
+    //! Forget the queued messages of a notifier and wait until none of its messages is being sent
+    void Remove(const CZMQAbstractPublishNotifier* notifier);
+
+    size_t GetSize();
+    size_t GetPeakSize();
+    size_t GetMaxSize();
+};
+
+extern CZMQPublishQueue zmqPublishQueue;
 
 class CZMQAbstractPublishNotifier : public CZMQAbstractNotifier
 {
 private:
-    uint32_t nSequence; //!< upcounting per message sequence number
+    std::atomic<uint32_t> nSequence{0}; //!< upcounting per message sequence number
 
 public:
 
-    /* send zmq multipart message
+    /* queue zmq multipart message
        parts:
           * command
           * data
           * message sequence number
     */
     bool SendMessage(const char *command, const void* data, size_t size);
+    //! Send a queued message, called by the publisher thread
+    void Publish(const CZMQPublishQueue::Message& msg);
 
     bool Initialize(void *pcontext) override;
     void Shutdown() override;
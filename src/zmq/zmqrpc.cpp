@@ -0,0 +1,72 @@
+// Copyright (c) 2019 The Polis Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#include "zmq/zmqrpc.h"
+
+#include "rpc/server.h"
+#include "zmq/zmqabstractnotifier.h"
+#include "zmq/zmqnotificationinterface.h"
+#include "zmq/zmqpublishnotifier.h"
+
+#include <univalue.h>
+
+UniValue getzmqnotifications(const JSONRPCRequest& request)
+{
+    if (request.fHelp || request.params.size() != 0)
+        throw std::runtime_error(
+            "getzmqnotifications\n"
+            "\nReturns information about the active ZeroMQ notifications and the publish queue.\n"
+            "\nResult:\n"
+            "{\n"
+            "  \"queuesize\": n,          (numeric) Number of messages waiting to be published\n"
+            "  \"peakqueuesize\": n,      (numeric) Largest number of messages waiting at the same time\n"
+            "  \"maxqueuesize\": n,       (numeric) Messages are dropped while this many are waiting (-zmqqueuesize)\n"
+            "  \"notifiers\": [\n"
+            "    {\n"
+            "      \"type\": \"pubhashtx\",   (string) Type of notification\n"
+            "      \"address\": \"...\",      (string) Address of the publisher\n"
+            "      \"hwm\": n,              (numeric) Outbound message high water mark\n"
+            "      \"published\": n,        (numeric) Number of messages handed to the socket\n"
+            "      \"dropped\": n           (numeric) Number of messages dropped because the queue was full or sending failed\n"
+            "    },\n"
+            "    ...\n"
+            "  ]\n"
+            "}\n"
+            "\nExamples:\n"
+            + HelpExampleCli("getzmqnotifications", "")
+            + HelpExampleRpc("getzmqnotifications", "")
+        );
+
+    UniValue result(UniValue::VOBJ);
+    UniValue notifiers(UniValue::VARR);
+    if (pzmqNotificationInterface) {
+        for (const auto* n : pzmqNotificationInterface->GetNotifiers()) {
+            UniValue obj(UniValue::VOBJ);
+            obj.push_back(Pair("type", n->GetType()));
+            obj.push_back(Pair("address", n->GetAddress()));
+            obj.push_back(Pair("hwm", n->GetSendHighWaterMark()));
+            obj.push_back(Pair("published", n->GetPublishedCount()));
+            obj.push_back(Pair("dropped", n->GetDroppedCount()));
+            notifiers.push_back(std::move(obj));
+        }
+    }
+    result.push_back(Pair("queuesize", (uint64_t)zmqPublishQueue.GetSize()));
+    result.push_back(Pair("peakqueuesize", (uint64_t)zmqPublishQueue.GetPeakSize()));
+    result.push_back(Pair("maxqueuesize", (uint64_t)zmqPublishQueue.GetMaxSize()));
+    result.push_back(Pair("notifiers", std::move(notifiers)));
+
+    return result;
+}
+
+static const CRPCCommand commands[] =
+{ //  category              name                      actor (function)         okSafeMode
+  //  --------------------- ------------------------  -----------------------  ----------
+    { "zmq",                "getzmqnotifications",    &getzmqnotifications,    true,  {} },
+};
+
+void RegisterZMQRPCCommands(CRPCTable& t)
+{
+    for (unsigned int vcidx = 0; vcidx < ARRAYLEN(commands); vcidx++)
+        t.appendCommand(commands[vcidx].name, &commands[vcidx]);
+}
@@ -0,0 +1,12 @@
+// Copyright (c) 2019 The Polis Core developers
+// Distributed under the MIT software license, see the accompanying
+// file COPYING or http://www.opensource.org/licenses/mit-license.php.
+
+#ifndef POLIS_ZMQ_ZMQRPC_H
+#define POLIS_ZMQ_ZMQRPC_H
+
+class CRPCTable;
+
+void RegisterZMQRPCCommands(CRPCTable& tableRPC);
+
+#endif // POLIS_ZMQ_ZMQRPC_H